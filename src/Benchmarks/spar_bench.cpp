@@ -0,0 +1,780 @@
+/// @file spar_bench.cpp
+/// @brief Benchmark suite of the simulation engine, the file readers and the
+/// derived metrics
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+///
+/// Every case prints one JSON object per line:
+///   {"suite": ..., "case": ..., "items": ..., "unit": ..., "ns_per_item": ...,
+///    "allocations": ..., "peak_rss_kb": ...}
+/// ns_per_item is the best of the repetitions. allocations is the number of
+/// heap allocations of one repetition and peak_rss_kb is the peak resident
+/// set of the process once the case has run.
+///
+/// With --check, the fast paths of the solver and the plain C++ interface
+/// (SParEngine) are compared against the plain dense solve instead, one JSON
+/// object per check:
+///   {"suite": "check", "case": ..., "max_error": ..., "tolerance": ...,
+///    "pass": ...}
+/// and the exit status is 1 if any of them fails.
+///
+/// Usage: spar_bench [--filter text] [--repeat N] [--threads N] [--full]
+///                   [--check] [--netlist file]...
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <random>
+
+#include "Misc/general.h"
+#include "SPAR/SParEngine.h"
+#include "SPAR/SParameterCalculator.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<long long> allocationCount(0);
+
+} // namespace
+
+// Allocation counting. With glibc the malloc family is interposed, so that
+// the allocations of Qt containers are counted as well as operator new.
+// Elsewhere only operator new is seen
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+
+void *malloc(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr ? 0 : ENOMEM;
+}
+}
+#else
+void *operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace {
+
+/// @struct BenchSettings
+/// @brief Command line settings
+struct BenchSettings {
+  QString filter;         ///< Only cases whose name contains this text
+  int repeat = 3;         ///< Repetitions of each case
+  int threads = 1;        ///< Sweep threads (0: one per hardware thread)
+  bool full = false;      ///< Include the largest file sizes
+  bool check = false;     ///< Run the equivalence checks instead
+  QStringList netlists;   ///< Netlist files added to the solver suite
+  std::filesystem::path tempDir; ///< Directory of the generated files
+};
+
+// Peak resident set of the process (kB)
+long peakRSS() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+  return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+/// @brief Runs one case and prints its result
+/// @param setup Called before each repetition, outside of the timing
+/// @param run Body of the case
+void runCase(const BenchSettings &settings, const QString &suite,
+             const QString &name, long long items, const char *unit,
+             const std::function<void()> &setup,
+             const std::function<void()> &run) {
+  QString id = suite + "/" + name;
+  if (!settings.filter.isEmpty() && !id.contains(settings.filter)) {
+    return;
+  }
+
+  double best = 0;
+  long long allocations = 0;
+  for (int r = 0; r < settings.repeat; r++) {
+    setup();
+    long long before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto stop = std::chrono::steady_clock::now();
+    allocations = allocationCount.load() - before;
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (r == 0) ? ns : std::min(best, ns);
+  }
+
+  printf("{\"suite\": \"%s\", \"case\": \"%s\", \"items\": %lld, "
+         "\"unit\": \"%s\", \"ns_per_item\": %.1f, \"allocations\": %lld, "
+         "\"peak_rss_kb\": %ld}\n",
+         suite.toUtf8().constData(), name.toUtf8().constData(), items, unit,
+         best / std::max(items, 1LL), allocations, peakRSS());
+  fflush(stdout);
+}
+
+/// @name Synthetic netlists
+/// @{
+
+// Lowpass LC ladder of the given order between two 50 Ohm ports
+QString ladderNetlist(int order) {
+  QString netlist = "P1 1 50\n";
+  int node = 1;
+  for (int k = 0; k < order; k++) {
+    if (k % 2 == 0) {
+      netlist += QString("L%1 %2 %3 8n\n").arg(k + 1).arg(node).arg(node + 1);
+      node++;
+    } else {
+      netlist += QString("C%1 %2 0 3p\n").arg(k + 1).arg(node);
+    }
+  }
+  netlist += QString("P2 %1 50\n").arg(node);
+  return netlist;
+}
+
+// Wilkinson divider with several quarter-wave sections per branch
+QString wilkinsonNetlist(int stages) {
+  QString netlist = "P1 1 50\n";
+  int node = 2;
+  int upper = 1, lower = 1;
+  for (int s = 0; s < stages; s++) {
+    double Z = 70.7 - 10.0 * s / std::max(stages - 1, 1);
+    netlist += QString("TLIN%1 %2 %3 %4 25mm\n")
+                   .arg(2 * s + 1)
+                   .arg(upper)
+                   .arg(node)
+                   .arg(Z);
+    netlist += QString("TLIN%1 %2 %3 %4 25mm\n")
+                   .arg(2 * s + 2)
+                   .arg(lower)
+                   .arg(node + 1)
+                   .arg(Z);
+    netlist += QString("R%1 %2 %3 %4\n")
+                   .arg(s + 1)
+                   .arg(node)
+                   .arg(node + 1)
+                   .arg(100 + 50 * s);
+    upper = node;
+    lower = node + 1;
+    node += 2;
+  }
+  netlist += QString("P2 %1 50\nP3 %2 50\n").arg(upper).arg(lower);
+  return netlist;
+}
+
+// Edge-coupled microstrip bandpass filter of the given order
+QString coupledLineNetlist(int order) {
+  QString netlist = "P1 1 50\n";
+  int input = 1;
+  int node = 2;
+  for (int k = 0; k <= order; k++) {
+    // Open ends get a node of their own
+    netlist += QString("MSCOUP%1 %2 %3 %4 %5 1.1mm 17mm 0.3mm 4.4 1.6mm "
+                       "5.8e7 35um 0.02\n")
+                   .arg(k + 1)
+                   .arg(input)
+                   .arg(node)
+                   .arg(node + 1)
+                   .arg(node + 2);
+    input = node + 2;
+    node += 3;
+  }
+  netlist += QString("P2 %1 50\n").arg(input);
+  return netlist;
+}
+/// @}
+
+void runSolverCase(const BenchSettings &settings, const QString &name,
+                   const QString &netlist, int points) {
+  SParameterCalculator engine;
+  engine.setSweepThreads(settings.threads);
+  runCase(
+      settings, "parser", name, netlist.count('\n'), "line", [] {},
+      [&] { engine.setNetlist(netlist); });
+
+  if (engine.getNumPorts() == 0) {
+    fprintf(stderr, "%s: no ports, skipped\n", name.toUtf8().constData());
+    return;
+  }
+  engine.setFrequencySweep(1e6, 6e9, points);
+  // Otherwise the repetitions would update the factors of the first sweep
+  engine.setIncrementalSweep(false);
+  runCase(
+      settings, "solver", name, points, "point", [] {},
+      [&] { engine.calculateSParameterSweep(); });
+}
+
+void runSolverSuite(const BenchSettings &settings) {
+  const int points = 1001;
+  for (int order : {3, 5, 10, 20, 50}) {
+    runSolverCase(settings, QString("ladder_%1").arg(order),
+                  ladderNetlist(order), points);
+  }
+  for (int stages : {1, 2, 4, 8}) {
+    runSolverCase(settings, QString("wilkinson_%1").arg(stages),
+                  wilkinsonNetlist(stages), points);
+  }
+  for (int order : {3, 5, 7}) {
+    runSolverCase(settings, QString("coupled_line_%1").arg(order),
+                  coupledLineNetlist(order), points);
+  }
+
+  for (const QString &path : settings.netlists) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      fprintf(stderr, "Cannot open %s\n", path.toUtf8().constData());
+      continue;
+    }
+    runSolverCase(settings, QFileInfo(path).fileName(),
+                  QString::fromUtf8(file.readAll()), points);
+  }
+}
+
+/// @name Equivalence checks
+/// @{
+
+// Turns off every shortcut: dense LU of the whole nodal system at each point
+void usePlainSolver(SParameterCalculator &engine) {
+  engine.setSweepThreads(1);
+  engine.setSparseSolverThreshold(0);
+  engine.setKronReduction(false);
+  engine.setCascadeFastPath(false);
+  engine.setAdaptiveSweep(false);
+  engine.setIncrementalSweep(false);
+  engine.setSensitivityAnalysis(false);
+}
+
+// Sweep of a netlist with the plain solver and the given paths enabled
+SParSweep checkSweep(const QString &netlist, int points, int threads,
+                     const std::function<void(SParameterCalculator &)> &paths) {
+  SParameterCalculator engine;
+  usePlainSolver(engine);
+  engine.setSweepThreads(threads);
+  paths(engine);
+  engine.setNetlist(netlist);
+  engine.setFrequencySweep(1e6, 6e9, points);
+  engine.calculateSParameterSweep();
+  return engine.getSweep();
+}
+
+// Largest difference between the S-parameters of two sweeps. Points that
+// could not be solved only match each other
+double sweepDifference(const SParSweep &a, const SParSweep &b) {
+  if (a.size() != b.size() || a.S.size() != b.S.size()) {
+    return INFINITY;
+  }
+  auto isDefined = [](const std::complex<double> &value) {
+    return std::isfinite(value.real()) && std::isfinite(value.imag());
+  };
+  double error = 0;
+  for (size_t k = 0; k < a.S.size(); k++) {
+    bool definedA = isDefined(a.S[k]);
+    bool definedB = isDefined(b.S[k]);
+    if (definedA != definedB) {
+      return INFINITY;
+    }
+    if (definedA) {
+      error = std::max(error, std::abs(a.S[k] - b.S[k]));
+    }
+  }
+  return error;
+}
+
+bool isSelected(const BenchSettings &settings, const QString &id) {
+  return settings.filter.isEmpty() || id.contains(settings.filter);
+}
+
+// Prints the result of a check. note explains a failure that is not a
+// numerical difference
+bool reportCheck(const QString &name, double error, double tolerance,
+                 const char *note = nullptr) {
+  bool pass = !note && error <= tolerance;
+  printf("{\"suite\": \"check\", \"case\": \"%s\", \"max_error\": %.3e, "
+         "\"tolerance\": %.1e, \"pass\": %s",
+         name.toUtf8().constData(), error, tolerance,
+         pass ? "true" : "false");
+  if (note) {
+    printf(", \"note\": \"%s\"", note);
+  }
+  printf("}\n");
+  fflush(stdout);
+  return pass;
+}
+
+// Derivatives from the adjoint solve against central differences of the
+// netlist values, at a few frequencies. The error is relative to the largest
+// dS/dp * p of the circuit
+double sensitivityDifference(const QString &netlist) {
+  const double step = 1e-5;
+  SParameterCalculator engine;
+  engine.setNetlist(netlist);
+  vector<SensitivityParameter> parameters = engine.getSensitivityParameters();
+
+  double error = 0;
+  for (double freq : {0.5e9, 1.5e9, 2.5e9}) {
+    engine.setFrequency(freq);
+    vector<ComplexMatrix> adjoint = engine.calculateSensitivities();
+
+    double scale = 0;
+    vector<double> errors;
+    for (size_t k = 0; k < parameters.size(); k++) {
+      // The values are written back with a finite number of digits, so the
+      // step is measured on the parsed values
+      ComplexMatrix S[2];
+      double value[2];
+      for (int side = 0; side < 2; side++) {
+        SensitivityParameter perturbed = parameters[k];
+        perturbed.value *= side ? 1 - step : 1 + step;
+        SParameterCalculator plain;
+        usePlainSolver(plain);
+        plain.setNetlist(engine.writeParameterValues({perturbed}));
+        plain.setFrequency(freq);
+        S[side] = plain.calculateSParameters();
+        value[side] = plain.getSensitivityParameters()[k].value;
+      }
+
+      double p = parameters[k].value;
+      double worst = 0;
+      for (int i = 0; i < S[0].rows(); i++) {
+        for (int j = 0; j < S[0].cols(); j++) {
+          Complex derivative =
+              (S[0][i][j] - S[1][i][j]) / (value[0] - value[1]);
+          worst = std::max(worst, std::abs(derivative - adjoint[k][i][j]) * p);
+          scale = std::max(scale, std::abs(derivative) * p);
+        }
+      }
+      errors.push_back(worst);
+    }
+    for (double e : errors) {
+      error = std::max(error, e / std::max(scale, 1e-12));
+    }
+  }
+  return error;
+}
+
+// Compares every fast path against the plain dense solve on one netlist
+bool runCheckCase(const BenchSettings &settings, const QString &name,
+                  const QString &netlist, int points) {
+  // Exact paths only differ by rounding
+  const double solveTolerance = 1e-9;
+  const double sensitivityTolerance = 1e-4;
+  int threads = settings.threads;
+  bool pass = true;
+
+  SParSweep reference = checkSweep(netlist, points, 1, [](auto &) {});
+  if (reference.ports == 0) {
+    fprintf(stderr, "%s: no ports, skipped\n", name.toUtf8().constData());
+    return true;
+  }
+  SParameterCalculator parsed;
+  parsed.setNetlist(netlist);
+  bool tunable = !parsed.getSensitivityParameters().empty();
+
+  // The ABCD chain has no gmin to ground on its nodes, which the nodal
+  // system has. Near a resonance of a long ladder it moves S by some 1e-8
+  const double cascadeTolerance = 1e-7;
+
+  struct Path {
+    const char *name;
+    double tolerance;
+    std::function<void(SParameterCalculator &)> enable;
+  };
+  const Path paths[] = {
+      {"threads", solveTolerance, [](auto &) {}},
+      {"sparse", solveTolerance,
+       [](auto &engine) { engine.setSparseSolverThreshold(1); }},
+      {"kron", solveTolerance,
+       [](auto &engine) { engine.setKronReduction(true); }},
+      {"cascade", cascadeTolerance,
+       [](auto &engine) { engine.setCascadeFastPath(true); }},
+  };
+  for (const Path &path : paths) {
+    QString id = name + "/" + path.name;
+    if (isSelected(settings, "check/" + id)) {
+      SParSweep fast = checkSweep(netlist, points, threads, path.enable);
+      pass &= reportCheck(id, sweepDifference(fast, reference), path.tolerance);
+    }
+  }
+
+  // A value of the middle of the circuit is edited after a full sweep, so the
+  // second sweep updates the factors of the first one
+  for (bool sparse : {false, true}) {
+    QString id = name + (sparse ? "/incremental_sparse" : "/incremental");
+    if (!tunable || !isSelected(settings, "check/" + id)) {
+      continue;
+    }
+    SParameterCalculator engine;
+    usePlainSolver(engine);
+    engine.setSweepThreads(threads);
+    engine.setSparseSolverThreshold(sparse ? 1 : 0);
+    engine.setIncrementalSweep(true);
+    engine.setNetlist(netlist);
+    engine.setFrequencySweep(1e6, 6e9, points);
+    engine.calculateSParameterSweep();
+
+    const vector<SensitivityParameter> &parameters =
+        engine.getSensitivityParameters();
+    SensitivityParameter edited = parameters[parameters.size() / 2];
+    edited.value *= 1.2;
+    QString tuned = engine.writeParameterValues({edited});
+    engine.setNetlist(tuned);
+    engine.calculateSParameterSweep();
+
+    double error = sweepDifference(engine.getSweep(),
+                                   checkSweep(tuned, points, 1, [](auto &) {}));
+    pass &= reportCheck(id, error, solveTolerance,
+                        engine.getSweepUpdateCount() == 0
+                            ? "the sweep was not updated"
+                            : nullptr);
+  }
+
+  QString id = name + "/adjoint";
+  if (tunable && isSelected(settings, "check/" + id)) {
+    pass &= reportCheck(id, sensitivityDifference(netlist),
+                        sensitivityTolerance);
+  }
+
+  // The plain C++ interface runs the engine with its default settings, so it
+  // may take any of the fast paths. Both of its sweeps are checked
+  id = name + "/engine_api";
+  if (isSelected(settings, "check/" + id)) {
+    SParEngine api;
+    api.setThreads(threads);
+    api.setFrequencySweep(1e6, 6e9, points);
+    const char *note = nullptr;
+    double error = 0;
+    if (!api.setNetlist(netlist.toStdString()) ||
+        api.numPorts() != reference.ports) {
+      note = "the netlist was not read";
+    } else {
+      SParSweep sweep = api.sweep();
+      error = sweepDifference(sweep, reference);
+
+      SParSweep buffered = sweep;
+      std::fill(buffered.S.begin(), buffered.S.end(),
+                std::complex<double>(NAN, NAN));
+      if (api.sweep(buffered.S.data(), buffered.S.size() - 1)) {
+        note = "a short buffer was accepted";
+      } else if (!api.sweep(buffered.S.data(), buffered.S.size())) {
+        note = "the buffer was rejected";
+      } else {
+        error = std::max(error, sweepDifference(buffered, reference));
+      }
+    }
+    pass &= reportCheck(id, error, cascadeTolerance, note);
+  }
+  return pass;
+}
+
+bool runCheckSuite(const BenchSettings &settings) {
+  const int points = 201;
+  bool pass = true;
+  pass &= runCheckCase(settings, "ladder_20", ladderNetlist(20), points);
+  pass &= runCheckCase(settings, "wilkinson_4", wilkinsonNetlist(4), points);
+  pass &= runCheckCase(settings, "coupled_line_5", coupledLineNetlist(5),
+                       points);
+
+  for (const QString &path : settings.netlists) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      fprintf(stderr, "Cannot open %s\n", path.toUtf8().constData());
+      pass = false;
+      continue;
+    }
+    pass &= runCheckCase(settings, QFileInfo(path).fileName(),
+                         QString::fromUtf8(file.readAll()), points);
+  }
+  return pass;
+}
+/// @}
+
+/// @name Synthetic data files
+/// @{
+
+// Reproducible S-parameter entry with |S| < 1
+std::complex<double> sampleEntry(std::mt19937 &generator) {
+  std::uniform_real_distribution<double> magnitude(0.01, 0.99);
+  std::uniform_real_distribution<double> phase(-M_PI, M_PI);
+  return std::polar(magnitude(generator), phase(generator));
+}
+
+// Touchstone v1 file (MA), four pairs per line at most
+void writeTouchstone(const std::filesystem::path &path, int ports,
+                     int points) {
+  FILE *file = fopen(path.string().c_str(), "w");
+  std::mt19937 generator(ports * 7919 + points);
+  fprintf(file, "! Benchmark data\n# GHz S MA R 50\n");
+  for (int i = 0; i < points; i++) {
+    fprintf(file, "%.9g", 0.001 + 20.0 * i / points);
+    int pairs = 0;
+    for (int e = 0; e < ports * ports; e++) {
+      if (ports > 2 && pairs == 4) {
+        fprintf(file, "\n");
+        pairs = 0;
+      }
+      std::complex<double> s = sampleEntry(generator);
+      fprintf(file, " %.9g %.9g", std::abs(s), std::arg(s) * 180.0 / M_PI);
+      pairs++;
+      if (ports > 2 && (e + 1) % ports == 0 && e + 1 < ports * ports) {
+        fprintf(file, "\n");
+        pairs = 0;
+      }
+    }
+    fprintf(file, "\n");
+  }
+  fclose(file);
+}
+
+// Qucs dataset in the qucsator (S[i,j]) or NGspice (ac.v(s_i_j)) flavour
+void writeDataset(const std::filesystem::path &path, int ports, int points,
+                  bool ngspice) {
+  FILE *file = fopen(path.string().c_str(), "w");
+  std::mt19937 generator(ports * 104729 + points);
+  fprintf(file, "<Qucs Dataset 25.1.0>\n<indep frequency %d>\n", points);
+  for (int i = 0; i < points; i++) {
+    fprintf(file, "  %+.12e\n", 1e6 + 2e10 * i / points);
+  }
+  fprintf(file, "</indep>\n");
+  if (!ngspice) {
+    fprintf(file, "<indep Z0 1>\n  +5.000000000000e+01\n</indep>\n");
+  }
+  for (int r = 1; r <= ports; r++) {
+    for (int c = 1; c <= ports; c++) {
+      if (ngspice) {
+        fprintf(file, "<dep ac.v(s_%d_%d) frequency>\n", r, c);
+      } else {
+        fprintf(file, "<dep S[%d,%d] frequency>\n", r, c);
+      }
+      for (int i = 0; i < points; i++) {
+        std::complex<double> s = sampleEntry(generator);
+        fprintf(file, "  %+.12e%cj%.12e\n", s.real(),
+                s.imag() < 0 ? '-' : '+', std::abs(s.imag()));
+      }
+      fprintf(file, "</dep>\n");
+    }
+  }
+  fclose(file);
+}
+/// @}
+
+void runTouchstoneSuite(const BenchSettings &settings) {
+  // Files past the budget (points x entries) need --full
+  const long long budget = settings.full ? (1LL << 28) : (1LL << 22);
+  for (int ports : {1, 2, 4, 8, 16}) {
+    for (int points : {1000, 10000, 100000, 1000000}) {
+      if ((long long)points * ports * ports > budget) {
+        continue;
+      }
+      QString name = QString("s%1p_%2").arg(ports).arg(points);
+      std::filesystem::path path =
+          settings.tempDir / QString("bench_%1.s%2p")
+                                 .arg(points)
+                                 .arg(ports)
+                                 .toStdString();
+      writeTouchstone(path, ports, points);
+      QString file = QString::fromStdString(path.string());
+      runCase(
+          settings, "touchstone", name, points, "point", [] {},
+          [&] { readTouchstoneFile(file); });
+      std::filesystem::remove(path);
+    }
+  }
+}
+
+void runDatasetSuite(const BenchSettings &settings) {
+  const long long budget = settings.full ? (1LL << 26) : (1LL << 20);
+  for (bool ngspice : {false, true}) {
+    for (int ports : {2, 4}) {
+      for (int points : {1000, 10000, 100000}) {
+        if ((long long)points * ports * ports > budget) {
+          continue;
+        }
+        QString name = QString("%1_%2port_%3")
+                           .arg(ngspice ? "ngspice" : "qucsator")
+                           .arg(ports)
+                           .arg(points);
+        std::filesystem::path path =
+            settings.tempDir /
+            QString("bench_%1.dat").arg(name).toStdString();
+        writeDataset(path, ports, points, ngspice);
+        QString file = QString::fromStdString(path.string());
+        runCase(
+            settings, "dataset", name, points, "point", [] {}, [&] {
+              if (ngspice) {
+                readNGspiceData(file);
+              } else {
+                readQucsatorDataset(file);
+              }
+            });
+        std::filesystem::remove(path);
+      }
+    }
+  }
+}
+
+// Stability, gain and group delay traces computed as the viewer does: one
+// named trace lookup per entry and point, and a list append per result
+void computeDerivedMetrics(QMap<QString, QList<double>> &dataset) {
+  int points = dataset["S11_re"].size();
+  for (int i = 0; i < points; i++) {
+    std::complex<double> s11(dataset["S11_re"][i], dataset["S11_im"][i]);
+    std::complex<double> s12(dataset["S12_re"][i], dataset["S12_im"][i]);
+    std::complex<double> s21(dataset["S21_re"][i], dataset["S21_im"][i]);
+    std::complex<double> s22(dataset["S22_re"][i], dataset["S22_im"][i]);
+
+    double delta = abs(s11 * s22 - s12 * s21);
+    double K = (1 - norm(s11) - norm(s22) + delta * delta) /
+               (2 * abs(s12 * s21));
+    double mu = (1 - norm(s11)) /
+                (abs(s22 - delta * conj(s11)) + abs(s12 * s21));
+    double MSG = abs(s21) / abs(s12);
+    double MAG = MSG * (K - std::sqrt(K * K - 1));
+    dataset["|Δ|"].append(delta);
+    dataset["K"].append(K);
+    dataset["μₛ"].append(mu);
+    dataset["MSG"].append(10 * log10(MSG));
+    dataset["MAG"].append(10 * log10(abs(MAG)));
+  }
+
+  // Group delay of S21 from the unwrapped phase
+  const QList<double> &freq = dataset["frequency"];
+  QList<double> phase = dataset["S21_ang"];
+  for (int n = 1; n < points; ++n) {
+    while (phase[n] - phase[n - 1] > 180.0) {
+      phase[n] -= 360.0;
+    }
+    while (phase[n] - phase[n - 1] < -180.0) {
+      phase[n] += 360.0;
+    }
+  }
+  QList<double> &groupDelay = dataset["S21_Group Delay"];
+  for (int n = 0; n < points; ++n) {
+    int a = std::max(n - 1, 0), b = std::min(n + 1, points - 1);
+    double df = freq[b] - freq[a];
+    groupDelay.append(df != 0 ? -(phase[b] - phase[a]) / (360.0 * df) * 1e9
+                              : 0);
+  }
+}
+
+void runMetricsSuite(const BenchSettings &settings) {
+  for (int points : {1000, 100000, 1000000}) {
+    if (points > 100000 && !settings.full) {
+      continue;
+    }
+    std::filesystem::path path =
+        settings.tempDir /
+        QString("bench_metrics_%1.s2p").arg(points).toStdString();
+    writeTouchstone(path, 2, points);
+    QMap<QString, QList<double>> data =
+        readTouchstoneFile(QString::fromStdString(path.string()));
+    std::filesystem::remove(path);
+
+    QMap<QString, QList<double>> dataset;
+    runCase(
+        settings, "metrics", QString("two_port_%1").arg(points), points,
+        "point", [&] { dataset = data; },
+        [&] { computeDerivedMetrics(dataset); });
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  BenchSettings settings;
+  for (int i = 1; i < argc; i++) {
+    QString arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--filter" && hasValue) {
+      settings.filter = argv[++i];
+    } else if (arg == "--repeat" && hasValue) {
+      settings.repeat = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--threads" && hasValue) {
+      settings.threads = std::max(0, atoi(argv[++i]));
+    } else if (arg == "--netlist" && hasValue) {
+      settings.netlists.append(argv[++i]);
+    } else if (arg == "--full") {
+      settings.full = true;
+    } else if (arg == "--check") {
+      settings.check = true;
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--filter text] [--repeat N] [--threads N] [--full] "
+              "[--check] [--netlist file]...\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  // The engine logs to std::cout, so it is silenced. The results are written
+  // with stdio
+  std::cout.rdbuf(nullptr);
+
+  if (settings.check) {
+    return runCheckSuite(settings) ? 0 : 1;
+  }
+
+  settings.tempDir = std::filesystem::temp_directory_path() /
+                     ("spar_bench_" + std::to_string(
+                                          std::random_device()()));
+  std::filesystem::create_directories(settings.tempDir);
+
+  runSolverSuite(settings);
+  runTouchstoneSuite(settings);
+  runDatasetSuite(settings);
+  runMetricsSuite(settings);
+
+  std::filesystem::remove_all(settings.tempDir);
+  return 0;
+}
@@ -0,0 +1,275 @@
+/// @file spar_sim.cpp
+/// @brief Headless batch simulator: sweeps netlist files with the S-parameter
+/// engine and writes the results as Touchstone files
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSet>
+
+#include "Misc/profiler.h"
+#include "SPAR/SParameterCalculator.h"
+
+namespace {
+
+/// @struct SimulationJob
+/// @brief One netlist of the batch and the outcome of its sweep
+struct SimulationJob {
+  QString netlist;     ///< Netlist file
+  QString outputBase;  ///< Touchstone file, without the .sNp extension
+  QString output;      ///< Touchstone file written
+  bool ok = false;     ///< The sweep was written
+  QString message;     ///< Error message
+  int ports = 0;       ///< Number of ports
+  int unsolved = 0;    ///< Singular or failed frequency points
+  double elapsed = 0;  ///< Wall time (ms)
+};
+
+/// @brief Makes the file references of a netlist (Touchstone blocks)
+/// relative to the directory of the netlist instead of the working directory
+/// @param netlist Netlist text
+/// @param dir Directory of the netlist file
+/// @return Netlist with absolute file paths
+QString resolveFileReferences(const QString &netlist, const QDir &dir) {
+  QStringList lines = netlist.split('\n');
+  for (QString &line : lines) {
+    QStringList parts =
+        line.trimmed().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    // SPAR1 node1 node2 file
+    if (parts.size() >= 4 && parts[0].startsWith("SPAR") &&
+        !parts[3].startsWith("(") && QFileInfo(parts[3]).isRelative()) {
+      parts[3] = dir.absoluteFilePath(parts[3]);
+      line = parts.join(" ");
+    }
+  }
+  return lines.join("\n");
+}
+
+/// @brief Parses a sweep given as start:stop:points (e.g. 1M:6G:2001)
+/// @return false if the specification is not valid
+bool parseSweep(const QString &spec, double &start, double &stop,
+                int &points) {
+  QStringList fields = spec.split(':');
+  if (fields.size() != 3) {
+    return false;
+  }
+  bool ok;
+  start = parseValueWithUnit(fields[0].trimmed());
+  stop = parseValueWithUnit(fields[1].trimmed());
+  points = fields[2].trimmed().toInt(&ok);
+  return ok && points > 0 && start > 0 && stop >= start;
+}
+
+/// @brief Chooses the Touchstone file of each netlist
+/// @param jobs Batch, in command line order
+/// @param outputDir Directory of the Touchstone files (empty: next to each
+/// netlist)
+/// @details Netlists with the same base name, either in different directories
+/// with --output-dir or side by side with different extensions, would
+/// overwrite each other's results. The later ones get a numeric suffix
+void assignOutputNames(vector<SimulationJob> &jobs, const QString &outputDir) {
+  QSet<QString> used;
+  for (auto &job : jobs) {
+    QFileInfo info(job.netlist);
+    QDir dir(outputDir.isEmpty() ? info.absolutePath() : outputDir);
+    QString base = dir.absoluteFilePath(info.completeBaseName());
+    QString unique = base;
+    for (int n = 2; used.contains(unique); n++) {
+      unique = QString("%1_%2").arg(base).arg(n);
+    }
+    used.insert(unique);
+    if (unique != base) {
+      cerr << "Warning: " << job.netlist.toStdString()
+           << " has the same name as an earlier netlist. Its results are "
+              "written to "
+           << QFileInfo(unique).fileName().toStdString() << ".s*p" << endl;
+    }
+    job.outputBase = unique;
+  }
+}
+
+/// @brief Sweeps one netlist and writes its Touchstone file
+void runJob(SimulationJob &job, double start, double stop, int points,
+            int threads) {
+  QElapsedTimer timer;
+  timer.start();
+
+  QFile file(job.netlist);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    job.message = "cannot open the file";
+    return;
+  }
+  QFileInfo info(job.netlist);
+  QString netlist = resolveFileReferences(QString::fromUtf8(file.readAll()),
+                                          info.absoluteDir());
+
+  try {
+    SParameterCalculator engine;
+    engine.setSweepThreads(threads);
+    if (!engine.setNetlist(netlist)) {
+      job.message = "the netlist could not be parsed";
+      return;
+    }
+    job.ports = engine.getNumPorts();
+    if (job.ports == 0) {
+      job.message = "the netlist has no ports";
+      return;
+    }
+
+    engine.setFrequencySweep(start, stop, points);
+    engine.calculateSParameterSweep();
+    const SParSweep &sweep = engine.getSweep();
+    job.unsolved = sweep.count(SolveStatus::Singular) +
+                   sweep.count(SolveStatus::Failed);
+
+    job.output = QString("%1.s%2p").arg(job.outputBase).arg(job.ports);
+    job.ok = engine.exportSweepTouchstone(job.output);
+    if (!job.ok) {
+      job.message = "cannot write " + job.output;
+    }
+  } catch (const std::exception &e) {
+    job.message = e.what();
+  }
+  job.elapsed = timer.nsecsElapsed() / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("qucs-s-spar-sim");
+  QCoreApplication::setApplicationVersion(PACKAGE_VERSION);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Runs the S-parameter simulator of the Qucs-S S-parameter viewer on "
+      "netlist files and writes the results as Touchstone files.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  QCommandLineOption sweepOption(
+      QStringList() << "s" << "sweep",
+      "Frequency sweep as start:stop:points, e.g. 1M:6G:2001 (default "
+      "1M:1G:201).",
+      "sweep", "1M:1G:201");
+  QCommandLineOption jobsOption(
+      QStringList() << "j" << "jobs",
+      "Number of threads (default: one per hardware thread). Netlists are "
+      "simulated in parallel, and the threads left over are given to the "
+      "frequency sweeps.",
+      "threads", "0");
+  QCommandLineOption outputOption(
+      QStringList() << "o" << "output-dir",
+      "Directory of the Touchstone files (default: next to each netlist).",
+      "dir");
+  QCommandLineOption profileOption(
+      "profile",
+      "Write the time spent in each phase of the simulation as a Chrome trace "
+      "(JSON).",
+      "file");
+  parser.addOption(sweepOption);
+  parser.addOption(jobsOption);
+  parser.addOption(outputOption);
+  parser.addOption(profileOption);
+  parser.addPositionalArgument("netlists", "Netlist files to simulate.",
+                               "netlist...");
+  parser.process(app);
+
+  QStringList files = parser.positionalArguments();
+  if (files.isEmpty()) {
+    parser.showHelp(2);
+  }
+
+  double start, stop;
+  int points;
+  if (!parseSweep(parser.value(sweepOption), start, stop, points)) {
+    cerr << "Invalid sweep: " << parser.value(sweepOption).toStdString()
+         << endl;
+    return 2;
+  }
+
+  QString outputDir = parser.value(outputOption);
+  if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+    cerr << "Cannot create the output directory " << outputDir.toStdString()
+         << endl;
+    return 2;
+  }
+
+  QString profile = parser.value(profileOption);
+  if (!profile.isEmpty()) {
+    Profiler::setEnabled(true);
+  }
+
+  int threads = parser.value(jobsOption).toInt();
+  if (threads <= 0) {
+    threads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+
+  // Whole netlists are the coarsest unit of work, so they are spread first.
+  // Small batches give the remaining threads to each sweep
+  int numJobs = files.size();
+  int numWorkers = std::min(threads, numJobs);
+  int sweepThreads = std::max(1, threads / numWorkers);
+
+  vector<SimulationJob> jobs(numJobs);
+  for (int k = 0; k < numJobs; k++) {
+    jobs[k].netlist = files[k];
+  }
+  assignOutputNames(jobs, outputDir);
+
+  std::atomic<int> nextJob(0);
+  auto runWorker = [&]() {
+    for (int k = nextJob++; k < numJobs; k = nextJob++) {
+      runJob(jobs[k], start, stop, points, sweepThreads);
+    }
+  };
+
+  if (numWorkers == 1) {
+    runWorker();
+  } else {
+    vector<std::thread> pool;
+    for (int w = 0; w < numWorkers; w++) {
+      pool.emplace_back(runWorker);
+    }
+    for (auto &worker : pool) {
+      worker.join();
+    }
+  }
+
+  // Report in the order of the command line
+  int failed = 0;
+  for (const auto &job : jobs) {
+    if (job.ok) {
+      cout << "OK    " << job.netlist.toStdString() << " -> "
+           << job.output.toStdString() << " (" << job.ports << " ports, ";
+      if (job.unsolved > 0) {
+        cout << job.unsolved << " unsolved points, ";
+      }
+      cout << job.elapsed << " ms)" << endl;
+    } else {
+      cout << "FAIL  " << job.netlist.toStdString() << ": "
+           << job.message.toStdString() << endl;
+      failed++;
+    }
+  }
+  cout << numJobs - failed << " of " << numJobs << " netlists simulated"
+       << endl;
+
+  if (!profile.isEmpty()) {
+    cerr << Profiler::summary().toStdString() << endl;
+    if (!Profiler::writeChromeTrace(profile)) {
+      cerr << "Cannot write the trace file " << profile.toStdString() << endl;
+    }
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+/// @file datasetCache.cpp
+/// @brief Binary cache of the datasets read from data files (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "datasetCache.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+namespace DatasetCache {
+
+namespace {
+
+std::atomic<bool> enabled(qEnvironmentVariableIntValue("SPAR_DATASET_CACHE") !=
+                          0);
+
+// Files below this size are parsed about as fast as the cache is read
+constexpr qint64 MinimumSourceSize = 1 << 20;
+
+// Bump the version whenever the layout or the content of the dataset changes
+constexpr char Magic[8] = {'S', 'P', 'A', 'R', 'D', 'S', '\r', '\n'};
+constexpr quint32 Version = 1;
+
+// Layout of a cache file, in native byte order (the cache is not shared
+// between machines). Every field and block is 8-byte aligned, so the columns
+// can be read straight from the mapped file:
+//
+//   Header
+//   source path (UTF-8), zero-padded to a multiple of 8 bytes
+//   for each column:
+//     ColumnHeader
+//     column name (UTF-8), zero-padded to a multiple of 8 bytes
+//     count doubles
+//
+// The checksum covers everything after the header
+struct Header {
+  char magic[8];
+  quint32 version;
+  quint32 columns;
+  qint64 sourceSize;
+  qint64 sourceModified; // ms since the epoch
+  quint64 checksum;
+  quint32 pathBytes;
+  quint32 reserved;
+};
+
+struct ColumnHeader {
+  quint64 count;
+  quint32 nameBytes;
+  quint32 reserved;
+};
+
+static_assert(sizeof(Header) % 8 == 0 && sizeof(ColumnHeader) % 8 == 0,
+              "The blocks of the cache file must be 8-byte aligned");
+
+qint64 padded(qint64 bytes) { return (bytes + 7) & ~qint64(7); }
+
+/// @brief 64-bit FNV-style hash of a sequence of 8-byte words. The words are
+/// spread over four independent lanes, so that the multiplications of
+/// consecutive words do not wait for each other
+class Checksum {
+public:
+  /// @param data Words to add. bytes must be a multiple of 8
+  void add(const void *data, qint64 bytes) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const qint64 words = bytes / 8;
+    qint64 i = 0;
+    // Words are assigned to the lanes by their position in the whole stream
+    for (; i < words && (position & 3); ++i, ++position) {
+      addWord(lanes[position & 3], p + 8 * i);
+    }
+    quint64 a = lanes[0], b = lanes[1], c = lanes[2], d = lanes[3];
+    for (; i + 4 <= words; i += 4, position += 4) {
+      addWord(a, p + 8 * i);
+      addWord(b, p + 8 * i + 8);
+      addWord(c, p + 8 * i + 16);
+      addWord(d, p + 8 * i + 24);
+    }
+    lanes[0] = a, lanes[1] = b, lanes[2] = c, lanes[3] = d;
+    for (; i < words; ++i, ++position) {
+      addWord(lanes[position & 3], p + 8 * i);
+    }
+  }
+
+  quint64 value() const {
+    quint64 h = Basis;
+    for (quint64 lane : lanes) {
+      h = (h ^ lane) * Prime;
+    }
+    return (h ^ position) * Prime;
+  }
+
+private:
+  static void addWord(quint64 &lane, const unsigned char *p) {
+    quint64 word;
+    std::memcpy(&word, p, sizeof(word));
+    lane = (lane ^ word) * Prime;
+  }
+
+  static constexpr quint64 Basis = 0xcbf29ce484222325ULL;
+  static constexpr quint64 Prime = 0x100000001b3ULL;
+  quint64 lanes[4] = {Basis, Basis + 1, Basis + 2, Basis + 3};
+  quint64 position = 0;
+};
+
+/// @brief Emits the body of a cache file (everything after the header) as
+/// blocks of whole 8-byte words
+template <typename Sink>
+void emitBody(const QByteArray &path, const QMap<QString, QList<double>> &data,
+              Sink &&sink) {
+  auto emitPadded = [&](const QByteArray &text) {
+    QByteArray block = text;
+    block.append(padded(text.size()) - text.size(), '\0');
+    sink(block.constData(), block.size());
+  };
+
+  emitPadded(path);
+  for (auto it = data.cbegin(); it != data.cend(); ++it) {
+    QByteArray name = it.key().toUtf8();
+    ColumnHeader column = {quint64(it.value().size()), quint32(name.size()), 0};
+    sink(&column, sizeof(column));
+    emitPadded(name);
+    sink(it.value().constData(), it.value().size() * qint64(sizeof(double)));
+  }
+}
+
+QString cacheFilePath(const QString &absolutePath) {
+  QByteArray key =
+      QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Sha1);
+  return directory() + "/" + QString::fromLatin1(key.toHex()) + ".spards";
+}
+
+qint64 modifiedTime(const QFileInfo &source) {
+  return source.lastModified().toMSecsSinceEpoch();
+}
+
+} // namespace
+
+bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+void setEnabled(bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+QString directory() {
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         "/datasets";
+}
+
+void clear() { QDir(directory()).removeRecursively(); }
+
+bool load(const QFileInfo &source, QMap<QString, QList<double>> &data) {
+  if (!isEnabled() || source.size() < MinimumSourceSize) {
+    return false;
+  }
+
+  QString sourcePath = source.absoluteFilePath();
+  QFile file(cacheFilePath(sourcePath));
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  const qint64 size = file.size();
+  if (size < qint64(sizeof(Header))) {
+    return false;
+  }
+
+  // The file is mapped if possible. Otherwise it is read whole
+  QByteArray contents;
+  const uchar *base = file.map(0, size);
+  if (!base) {
+    contents = file.readAll();
+    if (contents.size() != size) {
+      return false;
+    }
+    base = reinterpret_cast<const uchar *>(contents.constData());
+  }
+
+  Header header;
+  std::memcpy(&header, base, sizeof(header));
+  QByteArray path = sourcePath.toUtf8();
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version || header.sourceSize != source.size() ||
+      header.sourceModified != modifiedTime(source) ||
+      header.pathBytes != quint32(path.size())) {
+    return false;
+  }
+
+  qint64 offset = sizeof(Header);
+  const qint64 pathBlock = padded(header.pathBytes);
+  if (size - offset < pathBlock ||
+      std::memcmp(base + offset, path.constData(), path.size()) != 0) {
+    return false;
+  }
+
+  // Each column is copied and added to the checksum block by block, so it is
+  // only read once from the mapped file
+  constexpr qint64 BlockBytes = 1 << 16;
+  Checksum checksum;
+  checksum.add(base + offset, pathBlock);
+  offset += pathBlock;
+
+  QMap<QString, QList<double>> result;
+  for (quint32 c = 0; c < header.columns; ++c) {
+    ColumnHeader column;
+    if (size - offset < qint64(sizeof(column))) {
+      return false;
+    }
+    std::memcpy(&column, base + offset, sizeof(column));
+    checksum.add(base + offset, sizeof(column));
+    offset += sizeof(column);
+
+    const qint64 nameBlock = padded(column.nameBytes);
+    if (size - offset < nameBlock ||
+        column.count > quint64(size - offset - nameBlock) / sizeof(double)) {
+      return false;
+    }
+    QString name = QString::fromUtf8(
+        reinterpret_cast<const char *>(base + offset), column.nameBytes);
+    checksum.add(base + offset, nameBlock);
+    offset += nameBlock;
+
+    QList<double> &values = result[name];
+    values.resize(qsizetype(column.count));
+    const qint64 bytes = qint64(column.count) * qint64(sizeof(double));
+    char *target = reinterpret_cast<char *>(values.data());
+    for (qint64 done = 0; done < bytes; done += BlockBytes) {
+      const qint64 block = qMin(BlockBytes, bytes - done);
+      checksum.add(base + offset + done, block);
+      std::memcpy(target + done, base + offset + done, block);
+    }
+    offset += bytes;
+  }
+
+  if (offset != size || checksum.value() != header.checksum) {
+    // Truncated or corrupt. It is dropped so it is written again
+    file.close();
+    QFile::remove(file.fileName());
+    return false;
+  }
+
+  data = std::move(result);
+  return true;
+}
+
+void store(const QFileInfo &source, const QMap<QString, QList<double>> &data) {
+  if (!isEnabled() || data.isEmpty() || source.size() < MinimumSourceSize) {
+    return;
+  }
+
+  QString sourcePath = source.absoluteFilePath();
+  QByteArray path = sourcePath.toUtf8();
+
+  Header header = {};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.columns = quint32(data.size());
+  header.sourceSize = source.size();
+  header.sourceModified = modifiedTime(source);
+  header.pathBytes = quint32(path.size());
+
+  Checksum checksum;
+  emitBody(path, data,
+           [&](const void *block, qint64 bytes) { checksum.add(block, bytes); });
+  header.checksum = checksum.value();
+
+  if (!QDir().mkpath(directory())) {
+    return;
+  }
+
+  // QSaveFile only replaces the cache file once it is complete, so a reader
+  // never sees a partial file
+  QSaveFile file(cacheFilePath(sourcePath));
+  if (!file.open(QIODevice::WriteOnly)) {
+    return;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  emitBody(path, data, [&](const void *block, qint64 bytes) {
+    file.write(static_cast<const char *>(block), bytes);
+  });
+  if (!file.commit()) {
+    qWarning() << "DatasetCache: cannot write the cache of" << sourcePath;
+  }
+}
+
+} // namespace DatasetCache
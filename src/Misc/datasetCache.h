@@ -0,0 +1,55 @@
+/// @file datasetCache.h
+/// @brief Binary cache of the datasets read from data files
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef DATASETCACHE_H
+#define DATASETCACHE_H
+
+#include <QFileInfo>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+/// @brief Binary cache of the datasets read from Touchstone and Qucs-S files
+/// @details Parsing a large text file takes much longer than copying its
+/// values, so the dataset of each file is kept in a binary file under the
+/// user cache directory. The cache file is named after the path of the source
+/// file and records its size and modification time: it is only used while
+/// they match. Its layout is columnar and 8-byte aligned, so it is read by
+/// mapping it and copying each column, and a checksum of the contents
+/// detects truncated or corrupt files. loadSparamFile() uses the cache
+/// transparently. It is disabled by default, and enabled at startup if the
+/// SPAR_DATASET_CACHE environment variable is set to a non-zero value.
+namespace DatasetCache {
+
+/// @brief Returns true if the cache is used
+bool isEnabled();
+
+/// @brief Enables or disables the cache
+void setEnabled(bool enable);
+
+/// @brief Returns the directory of the cache files
+QString directory();
+
+/// @brief Deletes all the cached datasets
+void clear();
+
+/// @brief Reads the dataset of a file from the cache
+/// @param source Data file. Its size and modification time must match those
+/// of the cached dataset
+/// @param[out] data Dataset
+/// @return false if the cache is disabled or has no fresh copy of the file
+bool load(const QFileInfo &source, QMap<QString, QList<double>> &data);
+
+/// @brief Writes the dataset of a file to the cache. Small files, which are
+/// parsed quickly, are not cached
+/// @param source Data file, as it was before it was parsed
+/// @param data Dataset read from the file
+void store(const QFileInfo &source, const QMap<QString, QList<double>> &data);
+
+} // namespace DatasetCache
+
+#endif // DATASETCACHE_H
@@ -6,6 +6,11 @@
 /// @license GPL-3.0-or-later
 
 #include "general.h"
+#include "datasetCache.h"
+
+#include "SPAR/SParSweep.h"
+
+#include <limits>
 
 QString RoundVariablePrecision(double val) {
   int precision = 0; // By default, it takes 2 decimal places
@@ -516,15 +521,87 @@ double parseValueWithUnit(const QString& str) {
 }
 
 QMap<QString, QList<double>> loadSparamFile(const QString& path) {
-    QString ext = QFileInfo(path).suffix().toLower();
-    if (ext.startsWith("s") && ext.endsWith("p"))
-        return readTouchstoneFile(path);
+    // The size and time of the file are taken before it is parsed, so a file
+    // rewritten meanwhile leaves a stale cache entry instead of a wrong one
+    QFileInfo info(path);
+    QMap<QString, QList<double>> data;
+    if (DatasetCache::load(info, data))
+        return data;
+
+    QString ext = info.suffix().toLower();
+    if ((ext.startsWith("s") && ext.endsWith("p")) || ext == "ts")
+        data = readTouchstoneFile(path);
     else if (ext == "dat")
-        return readQucsatorDataset(path);
+        data = readQucsatorDataset(path);
     else if (ext == "ngspice")
-        return readNGspiceData(path);
+        data = readNGspiceData(path);
     else {
         qWarning() << "loadSparamFile: unsupported file extension:" << ext << "in" << path;
         return {};
     }
+
+    if (!data.isEmpty())
+        DatasetCache::store(info, data);
+    return data;
+}
+
+QMap<QString, QList<double>> sweepToDataset(
+    const SParSweep& sweep, const QStringList& parameters,
+    const std::vector<std::vector<ComplexMatrix>>& sensitivities) {
+    auto toList = [](const std::vector<double>& values) {
+        return QList<double>(values.begin(), values.end());
+    };
+
+    QMap<QString, QList<double>> data;
+    data["n_ports"].append(sweep.ports);
+    data["Z0"].append(sweep.Z0);
+    data["frequency"] = toList(sweep.frequency);
+
+    // The rest of the viewer addresses the traces by name. Each one is taken
+    // from the sweep with a single pass over its column
+    for (size_t row = 0; row < sweep.ports; ++row) {
+        for (size_t col = 0; col < sweep.ports; ++col) {
+            QString name = QString("S%1%2").arg(row + 1).arg(col + 1);
+            data[name + "_dB"] = toList(sweep.dB(row, col));
+            data[name + "_ang"] = toList(sweep.angle(row, col));
+            data[name + "_re"] = toList(sweep.real(row, col));
+            data[name + "_im"] = toList(sweep.imag(row, col));
+        }
+    }
+
+    if (sensitivities.size() != sweep.size()) {
+        return data;
+    }
+
+    // Derivatives, e.g. dS21_dC1.C_re and dS21_dC1.C_im. Like the
+    // S-parameters, they are NaN at the points that could not be solved
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int k = 0; k < parameters.size(); ++k) {
+        for (size_t row = 0; row < sweep.ports; ++row) {
+            for (size_t col = 0; col < sweep.ports; ++col) {
+                QString name = QString("dS%1%2_d%3")
+                                   .arg(row + 1)
+                                   .arg(col + 1)
+                                   .arg(parameters[k]);
+                QList<double>& res = data[name + "_re"];
+                QList<double>& ims = data[name + "_im"];
+                res.reserve(sweep.size());
+                ims.reserve(sweep.size());
+                for (size_t i = 0; i < sweep.size(); ++i) {
+                    if (sweep.status[i] == SolveStatus::Singular ||
+                        sweep.status[i] == SolveStatus::Failed ||
+                        k >= (int)sensitivities[i].size()) {
+                        res.append(nan);
+                        ims.append(nan);
+                        continue;
+                    }
+                    std::complex<double> derivative =
+                        sensitivities[i][k][row][col];
+                    res.append(derivative.real());
+                    ims.append(derivative.imag());
+                }
+            }
+        }
+    }
+    return data;
 }
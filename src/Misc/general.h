@@ -11,12 +11,19 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QString>
+#include <QStringList>
 
 #include <QList>
 #include <QPointF>
 #include <QRegularExpression>
 #include <cmath>
 #include <complex>
+#include <memory>
+#include <vector>
+
+#include "SPAR/ComplexMatrix.h"
+
+struct SParSweep;
 
 // CONSTANTS
 static constexpr double Z0  = 376.730313668;     // Free space impedance
@@ -108,10 +115,54 @@ QPointF findClosestPoint(const QList<double>& xValues,
                          const QList<double>& yValues, double targetX);
 
 /// @brief Reads Touchstone file and extracts S-parameter data
-/// @param filePath Path to the Touchstone file (.sNp)
-/// @return Map of variable names to data arrays
+/// @param filePath Path to the Touchstone file (.sNp, or .ts for version 2.0)
+/// @return Map of variable names to data arrays. Empty if the file cannot be
+/// read or has no data
 QMap<QString, QList<double>> readTouchstoneFile(const QString& filePath);
 
+/// @brief Reads Touchstone file into a sweep, without building the named traces
+/// @param filePath Path to the Touchstone file (.sNp, or .ts for version 2.0)
+/// @param[out] sweep Frequencies (Hz), reference impedances and S-parameters
+/// @return false if the file cannot be read or has no data
+bool readTouchstoneFile(const QString& filePath, SParSweep& sweep);
+
+/// @class TouchstoneTailReader
+/// @brief Follows a Touchstone file that is being written, e.g. by a
+/// simulator that appends the points of a sweep as it solves them
+/// @details The reader keeps the parse state and the offset reached in the
+/// file, so each update only parses the bytes written since the previous one.
+/// The file is read again from the start when the content already read has
+/// changed: when it has shrunk, or when its first bytes or the bytes before
+/// the offset differ. A last line without line break is read as
+/// readTouchstoneFile() reads it, and read again once it is completed.
+class TouchstoneTailReader {
+public:
+    /// @brief Outcome of an update
+    enum class Update {
+        Unchanged, ///< No new points
+        Appended,  ///< The sweep holds the points added to the file
+        Reloaded,  ///< The sweep holds all the points of the file
+        Failed     ///< The file cannot be read
+    };
+
+    /// @param filePath Path to the Touchstone file (.sNp or .ts)
+    explicit TouchstoneTailReader(const QString& filePath);
+    ~TouchstoneTailReader();
+
+    TouchstoneTailReader(const TouchstoneTailReader&) = delete;
+    TouchstoneTailReader& operator=(const TouchstoneTailReader&) = delete;
+
+    /// @brief Reads what was written to the file since the last update. The
+    /// first update reads the whole file
+    /// @param[out] sweep New points (Appended) or all of them (Reloaded)
+    /// @return Outcome of the update
+    Update update(SParSweep& sweep);
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
 /// @brief Reads Qucs-S dataset with data from NGspice
 /// @param filePath Path to the dataset file (.dat.ngspice)
 /// @return Map of variable names to data arrays
@@ -126,6 +177,18 @@ QMap<QString, QList<double>> readQucsatorDataset(const QString& filePath);
 /// @see readTouchstoneFile, readNGspiceData, and readQucsatorDataset
 QMap<QString, QList<double>> loadSparamFile(const QString& path);
 
+/// @brief Converts a sweep into the traces of a dataset
+/// @param sweep Frequencies and S-parameters
+/// @param parameters Names of the sensitivity parameters ("C1.C")
+/// @param sensitivities Derivatives of the S-parameters, [point][parameter]
+/// (see SParameterCalculator::getSweepSensitivities()). Empty if the sweep
+/// ran without the sensitivity analysis
+/// @return frequency, n_ports, Z0 and the Sij_dB/_ang/_re/_im traces, plus
+/// the dSij_d<parameter>_re/_im traces when there are sensitivities
+QMap<QString, QList<double>> sweepToDataset(
+    const SParSweep& sweep, const QStringList& parameters = {},
+    const std::vector<std::vector<ComplexMatrix>>& sensitivities = {});
+
 
 /// @brief Show HTML documentation in the web browser
 /// @param path Path to the HTML file
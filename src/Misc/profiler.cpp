@@ -0,0 +1,301 @@
+/// @file profiler.cpp
+/// @brief Scoped timers and counters for profiling the simulation pipeline
+/// (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "profiler.h"
+
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Profiler {
+
+namespace detail {
+std::atomic<bool> enabled(qEnvironmentVariableIntValue("SPAR_PROFILE") != 0);
+} // namespace detail
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Scopes past this number are still aggregated, but are not kept for the
+// trace. It bounds the memory of long sessions
+constexpr long long MaxEvents = 1 << 21;
+
+struct Event {
+  const char *name;
+  long long start;    // ns since the origin of the registry
+  long long duration; // ns
+};
+
+struct Aggregate {
+  long long calls = 0;
+  long long totalNs = 0;
+  long long maxNs = 0;
+  long long windowCalls = 0;
+  long long windowNs = 0;
+};
+
+struct Counter {
+  long long value = 0;
+  long long window = 0;
+};
+
+// The scopes of each thread are kept apart, so that recording only takes a
+// lock that is contended while the results are being read
+struct ThreadLog {
+  std::mutex mutex;
+  int id = 0;
+  std::vector<Event> events;
+  std::unordered_map<const char *, Aggregate> phases;
+  std::unordered_map<const char *, Counter> counters;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadLog>> logs;
+  const Clock::time_point origin = Clock::now();
+  std::atomic<long long> events{0};
+  int nextId = 1;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+ThreadLog &threadLog() {
+  thread_local std::shared_ptr<ThreadLog> log = [] {
+    auto created = std::make_shared<ThreadLog>();
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    created->id = r.nextId++;
+    r.logs.push_back(created);
+    return created;
+  }();
+  return *log;
+}
+
+// Calls f(log) for every thread log, with the log locked
+template <typename F> void forEachLog(F f) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const auto &log : r.logs) {
+    std::lock_guard<std::mutex> logLock(log->mutex);
+    f(*log);
+  }
+}
+
+QString formatMs(double ms) {
+  return ms < 10 ? QString::number(ms, 'f', 2) + " ms"
+                 : QString::number(ms, 'f', 1) + " ms";
+}
+
+} // namespace
+
+namespace detail {
+
+void record(const char *name, Clock::time_point start, Clock::time_point stop) {
+  Registry &r = registry();
+  long long begin =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start - r.origin)
+          .count();
+  long long duration =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+          .count();
+
+  ThreadLog &log = threadLog();
+  std::lock_guard<std::mutex> lock(log.mutex);
+  Aggregate &phase = log.phases[name];
+  phase.calls++;
+  phase.totalNs += duration;
+  phase.maxNs = std::max(phase.maxNs, duration);
+  phase.windowCalls++;
+  phase.windowNs += duration;
+  if (r.events.fetch_add(1, std::memory_order_relaxed) < MaxEvents) {
+    log.events.push_back({name, begin, duration});
+  }
+}
+
+void add(const char *name, long long delta) {
+  ThreadLog &log = threadLog();
+  std::lock_guard<std::mutex> lock(log.mutex);
+  Counter &counter = log.counters[name];
+  counter.value += delta;
+  counter.window += delta;
+}
+
+} // namespace detail
+
+void setEnabled(bool enable) {
+  if (enable) {
+    mark();
+  }
+  detail::enabled.store(enable, std::memory_order_relaxed);
+}
+
+void reset() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const auto &log : r.logs) {
+    std::lock_guard<std::mutex> logLock(log->mutex);
+    log->events.clear();
+    log->events.shrink_to_fit();
+    log->phases.clear();
+    log->counters.clear();
+  }
+  // Threads that have finished only live in the registry
+  r.logs.erase(std::remove_if(r.logs.begin(), r.logs.end(),
+                              [](const std::shared_ptr<ThreadLog> &log) {
+                                return log.use_count() == 1;
+                              }),
+               r.logs.end());
+  r.events = 0;
+}
+
+void mark() {
+  forEachLog([](ThreadLog &log) {
+    for (auto &phase : log.phases) {
+      phase.second.windowCalls = 0;
+      phase.second.windowNs = 0;
+    }
+    for (auto &counter : log.counters) {
+      counter.second.window = 0;
+    }
+  });
+}
+
+std::vector<PhaseStats> phases() {
+  // The same name may come from literals at different addresses
+  std::map<QString, PhaseStats> merged;
+  forEachLog([&merged](ThreadLog &log) {
+    for (const auto &entry : log.phases) {
+      QString name = QString::fromLatin1(entry.first);
+      PhaseStats &stats = merged[name];
+      stats.name = name;
+      stats.calls += entry.second.calls;
+      stats.totalMs += entry.second.totalNs * 1e-6;
+      stats.maxMs = std::max(stats.maxMs, entry.second.maxNs * 1e-6);
+      stats.windowCalls += entry.second.windowCalls;
+      stats.windowMs += entry.second.windowNs * 1e-6;
+    }
+  });
+
+  std::vector<PhaseStats> result;
+  for (const auto &entry : merged) {
+    result.push_back(entry.second);
+  }
+  std::sort(result.begin(), result.end(),
+            [](const PhaseStats &a, const PhaseStats &b) {
+              return a.totalMs > b.totalMs;
+            });
+  return result;
+}
+
+std::vector<CounterStats> counters() {
+  std::map<QString, CounterStats> merged;
+  forEachLog([&merged](ThreadLog &log) {
+    for (const auto &entry : log.counters) {
+      QString name = QString::fromLatin1(entry.first);
+      CounterStats &stats = merged[name];
+      stats.name = name;
+      stats.value += entry.second.value;
+      stats.window += entry.second.window;
+    }
+  });
+
+  std::vector<CounterStats> result;
+  for (const auto &entry : merged) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
+QString summary() {
+  std::vector<PhaseStats> stats = phases();
+  std::sort(stats.begin(), stats.end(),
+            [](const PhaseStats &a, const PhaseStats &b) {
+              return a.windowMs > b.windowMs;
+            });
+
+  QStringList parts;
+  for (const auto &phase : stats) {
+    if (phase.windowCalls == 0) {
+      continue;
+    }
+    QString part = phase.name + " " + formatMs(phase.windowMs);
+    if (phase.windowCalls > 1) {
+      part += QString(" (%1×)").arg(phase.windowCalls);
+    }
+    parts.append(part);
+  }
+  for (const auto &counter : counters()) {
+    if (counter.window != 0) {
+      parts.append(QString("%1 %2").arg(counter.name).arg(counter.window));
+    }
+  }
+  return parts.isEmpty() ? QString("No profiled activity") : parts.join(" | ");
+}
+
+bool writeChromeTrace(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    return false;
+  }
+
+  QTextStream out(&file);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first = true;
+  auto separator = [&out, &first]() {
+    if (!first) {
+      out << ",\n";
+    }
+    first = false;
+  };
+
+  long long last = 0;
+  forEachLog([&](ThreadLog &log) {
+    separator();
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+        << log.id << ", \"args\": {\"name\": \"Thread " << log.id << "\"}}";
+    for (const Event &event : log.events) {
+      separator();
+      out << "{\"name\": \"" << event.name
+          << "\", \"cat\": \"spar\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+          << log.id << ", \"ts\": " << QString::number(event.start * 1e-3, 'f', 3)
+          << ", \"dur\": " << QString::number(event.duration * 1e-3, 'f', 3)
+          << "}";
+      last = std::max(last, event.start + event.duration);
+    }
+  });
+
+  // Counters are reported once, at the end of the trace
+  std::vector<CounterStats> values = counters();
+  if (!values.empty()) {
+    separator();
+    out << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+        << QString::number(last * 1e-3, 'f', 3) << ", \"args\": {";
+    for (size_t k = 0; k < values.size(); k++) {
+      out << (k ? ", " : "") << "\"" << values[k].name
+          << "\": " << values[k].value;
+    }
+    out << "}}";
+  }
+  out << "\n]}\n";
+
+  file.close();
+  return file.error() == QFile::NoError;
+}
+
+} // namespace Profiler
@@ -0,0 +1,128 @@
+/// @file profiler.h
+/// @brief Scoped timers and counters for profiling the simulation pipeline
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/// @brief Profiling of the simulation pipeline
+/// @details Code is instrumented with PROFILE_SCOPE("phase"), which times the
+/// enclosing scope, and Profiler::count(). While the profiler is disabled (the
+/// default) a scope costs one relaxed atomic load. While enabled, every scope
+/// is recorded per thread, aggregated per phase, and can be written as a
+/// Chrome trace (chrome://tracing, Perfetto). The profiler is enabled at
+/// startup if the SPAR_PROFILE environment variable is set to a non-zero
+/// value.
+namespace Profiler {
+
+/// @struct PhaseStats
+/// @brief Aggregated timings of a phase
+struct PhaseStats {
+  QString name;            ///< Phase name
+  long long calls = 0;     ///< Number of scopes since reset()
+  double totalMs = 0;      ///< Time spent since reset()
+  double maxMs = 0;        ///< Longest scope since reset()
+  long long windowCalls = 0; ///< Number of scopes since mark()
+  double windowMs = 0;     ///< Time spent since mark()
+};
+
+/// @struct CounterStats
+/// @brief Value of a counter
+struct CounterStats {
+  QString name;          ///< Counter name
+  long long value = 0;   ///< Accumulated value since reset()
+  long long window = 0;  ///< Accumulated value since mark()
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+
+/// @brief Stores a finished scope in the log of the calling thread
+void record(const char *name, std::chrono::steady_clock::time_point start,
+            std::chrono::steady_clock::time_point stop);
+
+/// @brief Adds to a counter of the calling thread
+void add(const char *name, long long delta);
+} // namespace detail
+
+/// @brief Returns true if the scopes are being recorded
+inline bool isEnabled() {
+  return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/// @brief Starts or stops recording. Starting also calls mark()
+void setEnabled(bool enable);
+
+/// @brief Discards all the recorded scopes and counters
+void reset();
+
+/// @brief Starts a new window for the windowCalls/windowMs statistics (e.g.
+/// one user action)
+void mark();
+
+/// @brief Adds to a counter (e.g. the number of solved frequency points)
+inline void count(const char *name, long long delta = 1) {
+  if (isEnabled()) {
+    detail::add(name, delta);
+  }
+}
+
+/// @brief Aggregated timings of all the phases, longest total first
+std::vector<PhaseStats> phases();
+
+/// @brief Values of all the counters, sorted by name
+std::vector<CounterStats> counters();
+
+/// @brief One-line readout of the phases since mark() (for a status bar)
+QString summary();
+
+/// @brief Writes the recorded scopes in the Chrome trace event format
+/// @param path Output file (JSON)
+/// @return false if the file could not be written
+bool writeChromeTrace(const QString &path);
+
+/// @class ScopedTimer
+/// @brief Records the time spent between its construction and destruction
+class ScopedTimer {
+public:
+  /// @param name Phase name. It must be a string literal (it is not copied)
+  explicit ScopedTimer(const char *name)
+      : name(isEnabled() ? name : nullptr) {
+    if (this->name) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedTimer() {
+    if (name) {
+      detail::record(name, start, std::chrono::steady_clock::now());
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  const char *name;                            ///< Null if disabled
+  std::chrono::steady_clock::time_point start; ///< Start of the scope
+};
+
+} // namespace Profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/// @brief Times the enclosing scope under the given phase name
+#define PROFILE_SCOPE(name)                                                    \
+  Profiler::ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#endif // PROFILER_H
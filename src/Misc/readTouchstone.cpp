@@ -7,127 +7,654 @@
 
 #include "general.h"
 
-QMap<QString, QList<double>> readTouchstoneFile(const QString &filePath) {
-  QMap<QString, QList<double>>
-      file_data; // Data structure to store the file data
-  QString frequency_unit, parameter, format;
-  double freq_scale = 1; // Hz
-  double Z0 = 50;        // System impedance. Typically 50 Ohm
-  QStringList values;
-
-  // Get the filename for extracting number of ports
-  QString filename = QFileInfo(filePath).fileName();
-
-  // Get the number of ports
-  QString suffix = QFileInfo(filename).suffix();
-  QRegularExpression regex("(?i)[sp]");
-  QStringList numberParts = suffix.split(regex);
-  int number_of_ports = numberParts[1].toInt();
-  file_data["n_ports"].append(number_of_ports);
-
-  // 1) Open the file
-  QFile file(filePath);
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    qDebug() << "Cannot open the file";
-    return file_data;
-  }
+#include "SPAR/SParSweep.h"
 
-  // 2) Read data
-  QTextStream in(&file);
-  while (!in.atEnd()) {
-    QString line = in.readLine();
-    line = line.simplified();
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 
-    if (line.isEmpty()) {
-      continue;
+namespace {
+
+/// @enum TouchstoneFormat
+/// @brief Format of the network parameter data pairs
+enum class TouchstoneFormat { DB, MA, RI };
+
+/// @brief Returns true for the characters that separate Touchstone tokens
+inline bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/// @brief Case-insensitive comparison of a token with a lowercase keyword
+bool tokenEquals(const char *begin, const char *end, const char *keyword) {
+  size_t length = std::strlen(keyword);
+  if ((size_t)(end - begin) != length) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    char c = begin[i];
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';
     }
-    if ((line.at(0).isNumber() == false) && (line.at(0) != '#')) {
-      if (file_data["frequency"].size() == 0) {
-        // There's still no data
-        continue;
-      } else {
-        // There's already data, so it's very likely that the S-par data has
-        // ended and the following lines contain noise data. We must stop at
-        // this point.
-        break;
-      }
+    if (c != keyword[i]) {
+      return false;
     }
+  }
+  return true;
+}
 
-    // Check for the option line
-    if (line.at(0) == '#') {
-      QStringList info = line.split(' ', Qt::SkipEmptyParts);
-      frequency_unit = info.at(1); // Specifies the unit of frequency.
-                                   // Legal values are Hz, kHz, MHz, and GHz.
-                                   // The default value is GHz.
+/// @brief Returns the next whitespace-separated token of a line
+/// @param[in,out] p Current position. It is left at the end of the token
+/// @param end End of the line
+/// @param[out] tokenEnd End of the token
+/// @return Start of the token, or nullptr at the end of the line
+const char *nextToken(const char *&p, const char *end, const char *&tokenEnd) {
+  while (p < end && isBlank(*p)) {
+    ++p;
+  }
+  if (p == end) {
+    return nullptr;
+  }
+  const char *begin = p;
+  while (p < end && !isBlank(*p)) {
+    ++p;
+  }
+  tokenEnd = p;
+  return begin;
+}
 
-      frequency_unit = frequency_unit.toLower();
+/// @brief Converts a token to double, in place and independently of the locale
+/// @return false if the token is not a number
+bool toDouble(const char *begin, const char *end, double &value) {
+  if (begin < end && *begin == '+') {
+    ++begin; // from_chars does not take an explicit plus sign
+  }
+#if defined(__cpp_lib_to_chars)
+  auto result = std::from_chars(begin, end, value);
+  return result.ec == std::errc() && result.ptr == end;
+#else
+  // Standard libraries without floating-point from_chars. fromRawData does not
+  // copy the token, and the conversion uses the C locale
+  bool ok;
+  value = QByteArray::fromRawData(begin, end - begin).toDouble(&ok);
+  return ok;
+#endif
+}
 
-      // Default is already set to "hz"
-      if (frequency_unit == "khz") {
-        freq_scale = 1e3;
-      }
-      else if (frequency_unit == "mhz") {
-          freq_scale = 1e6;
-      }
-      else if (frequency_unit == "ghz") {
-            freq_scale = 1e9;
+/// @brief Parses the option line (# <unit> <parameter> <format> R <Z0>).
+/// Fields that are not given keep their value
+void parseOptionLine(const char *p, const char *end, double &freqScale,
+                     TouchstoneFormat &format, double &Z0) {
+  const char *tokenEnd;
+  ++p; // '#'
+  while (const char *token = nextToken(p, end, tokenEnd)) {
+    if (tokenEquals(token, tokenEnd, "hz")) {
+      freqScale = 1;
+    } else if (tokenEquals(token, tokenEnd, "khz")) {
+      freqScale = 1e3;
+    } else if (tokenEquals(token, tokenEnd, "mhz")) {
+      freqScale = 1e6;
+    } else if (tokenEquals(token, tokenEnd, "ghz")) {
+      freqScale = 1e9;
+    } else if (tokenEquals(token, tokenEnd, "db")) {
+      format = TouchstoneFormat::DB;
+    } else if (tokenEquals(token, tokenEnd, "ma")) {
+      format = TouchstoneFormat::MA;
+    } else if (tokenEquals(token, tokenEnd, "ri")) {
+      format = TouchstoneFormat::RI;
+    } else if (tokenEquals(token, tokenEnd, "r")) {
+      const char *valueEnd;
+      const char *value = nextToken(p, end, valueEnd);
+      if (value) {
+        toDouble(value, valueEnd, Z0);
       }
+    }
+    // The parameter type (S, Y, Z, H, G) is not used: the data is read as
+    // S-parameters
+  }
+}
+
+/// @class TouchstoneParser
+/// @brief Parser of Touchstone 1.x and 2.0 files
+/// @details The file is fed one line at a time, so it can be read in chunks
+/// of any size. The records are read as a stream of numbers, so they may be
+/// wrapped over any number of lines. The values are converted to complex
+/// numbers as they are read and written straight into the S tensor of the
+/// sweep.
+class TouchstoneParser {
+public:
+  /// @brief Constructor
+  /// @param sweep Output
+  /// @param ports Number of ports given by the file extension (0 if unknown)
+  /// @param size Size of the file (bytes), used to size the storage
+  TouchstoneParser(SParSweep &sweep, int ports, qint64 size)
+      : sweep(sweep), bytesLeft(size) {
+    sweep.reset(ports);
+  }
+
+  /// @brief Parses one line
+  /// @param line Start of the line
+  /// @param end End of the line (line break excluded)
+  /// @return false once the network data has ended
+  bool parseLine(const char *line, const char *end);
+
+  /// @brief Trims the storage to the points that were read and sets the
+  /// reference impedances
+  /// @return false if the file had no network data
+  bool finish();
+
+  /// @brief Returns the number of complete points read so far
+  size_t points() const { return point; }
+
+  /// @brief Sets the reference impedances read so far on a sweep
+  void setImpedances(SParSweep &target) const;
+
+private:
+  /// @brief Handles a [Keyword] line of Touchstone 2.0
+  /// @return false if the keyword ends the network data
+  bool parseKeyword(const char *line, const char *end);
+
+  /// @brief Stores the next number of the network data
+  /// @return false if the network data has ended
+  bool parseValue(double value);
+
+  /// @brief Sets the matrix entry of each pair of a record
+  void setEntryOrder();
+
+  /// @brief Sizes the storage after the first record
+  void reserve();
+
+  enum class MatrixFormat { Full, Lower, Upper };
 
-      // parameter: {S,Y,Z,H,G}
-      parameter = info.at(2).toUpper();; // specifies what kind of network parameter data
-                                         // is contained in the file
-      // format: {DB, MA, RI} for dB-angle, magnitude-angle, and real-imaginary
-      format = info.at(3).toLower();    // Specifies the format of the network parameter data pairs
-      Z0 = info.at(5).toDouble();
-      file_data["Z0"].append(Z0);
+  SParSweep &sweep;
+  qint64 bytesLeft; ///< Bytes not parsed yet
 
+  // Option line and keywords. The defaults are those of the specification
+  double freqScale = 1e9;
+  TouchstoneFormat format = TouchstoneFormat::MA;
+  double Z0 = 50;
+  bool version2 = false;
+  bool order21_12 = true; ///< 2-port order: S11 S21 S12 S22 (v1 order)
+  MatrixFormat matrixFormat = MatrixFormat::Full;
+  size_t numFrequencies = 0;     ///< [Number of Frequencies] (0 if not given)
+  std::vector<double> references; ///< [Reference]
+  int referencesLeft = 0;         ///< [Reference] values still to be read
+  bool information = false;       ///< Inside [Begin/End Information]
+  bool networkData = false;       ///< The network data has started
+
+  // Network data
+  std::vector<std::pair<int, int>> entries; ///< (row, col) of each pair
+  size_t point = 0;       ///< Point being read
+  int pair = -1;          ///< Pair of the point; -1 while expecting a frequency
+  double first = 0;       ///< First value of the current pair
+  bool haveFirst = false; ///< The first value of the pair has been read
+  bool reserved = false;  ///< The storage has been sized
+  qint64 firstRecordBytes = 0;
+};
+
+bool TouchstoneParser::parseLine(const char *line, const char *end) {
+  qint64 lineBytes = end - line + 1;
+  bytesLeft -= lineBytes;
+
+  // Everything after '!' is a comment
+  const char *comment =
+      static_cast<const char *>(std::memchr(line, '!', end - line));
+  if (comment) {
+    end = comment;
+  }
+  while (line < end && isBlank(*line)) {
+    ++line;
+  }
+  if (line == end) {
+    return true;
+  }
+
+  if (*line == '[') {
+    return parseKeyword(line, end);
+  }
+  if (information) {
+    return true;
+  }
+  if (*line == '#') {
+    parseOptionLine(line, end, freqScale, format, Z0);
+    return true;
+  }
+
+  const char *token, *tokenEnd;
+  while ((token = nextToken(line, end, tokenEnd))) {
+    double value;
+    if (!toDouble(token, tokenEnd, value)) {
+      // Text before the data is ignored. Once the data has started, it
+      // marks the end of the S-parameters
+      return !networkData;
+    }
+    if (referencesLeft > 0) {
+      // The [Reference] values may continue on the following lines
+      references.push_back(value);
+      referencesLeft--;
       continue;
     }
+    if (version2 && !networkData) {
+      continue; // Touchstone 2.0 data must follow [Network Data]
+    }
+    if (!parseValue(value)) {
+      return false;
+    }
+  }
+
+  if (networkData && !reserved) {
+    firstRecordBytes += lineBytes;
+    if (point > 0) {
+      reserve();
+    }
+  }
+  return true;
+}
+
+bool TouchstoneParser::parseKeyword(const char *line, const char *end) {
+  const char *close =
+      static_cast<const char *>(std::memchr(line, ']', end - line));
+  if (!close) {
+    return true;
+  }
+  const char *keyword = line + 1;
+  const char *argument = close + 1;
+  const char *argumentEnd;
+  const char *value = nextToken(argument, end, argumentEnd);
+
+  if (tokenEquals(keyword, close, "end information")) {
+    information = false;
+  } else if (information) {
+    return true;
+  } else if (tokenEquals(keyword, close, "begin information")) {
+    information = true;
+  } else if (tokenEquals(keyword, close, "version")) {
+    version2 = true;
+    order21_12 = false; // Must be given by [Two-Port Data Order]
+  } else if (tokenEquals(keyword, close, "number of ports")) {
+    double ports;
+    if (value && toDouble(value, argumentEnd, ports) && ports > 0) {
+      sweep.reset((size_t)ports);
+    }
+  } else if (tokenEquals(keyword, close, "two-port data order")) {
+    order21_12 = value && tokenEquals(value, argumentEnd, "21_12");
+  } else if (tokenEquals(keyword, close, "number of frequencies")) {
+    double count;
+    if (value && toDouble(value, argumentEnd, count) && count > 0) {
+      numFrequencies = (size_t)count;
+    }
+  } else if (tokenEquals(keyword, close, "reference")) {
+    references.clear();
+    referencesLeft = sweep.ports;
+    // The values start on the same line or on the next ones
+    const char *token = value, *tokenEnd = argumentEnd;
+    double z;
+    while (token && referencesLeft > 0 && toDouble(token, tokenEnd, z)) {
+      references.push_back(z);
+      referencesLeft--;
+      token = nextToken(argument, end, tokenEnd);
+    }
+  } else if (tokenEquals(keyword, close, "matrix format")) {
+    if (value && tokenEquals(value, argumentEnd, "lower")) {
+      matrixFormat = MatrixFormat::Lower;
+    } else if (value && tokenEquals(value, argumentEnd, "upper")) {
+      matrixFormat = MatrixFormat::Upper;
+    } else {
+      matrixFormat = MatrixFormat::Full;
+    }
+  } else if (tokenEquals(keyword, close, "network data")) {
+    networkData = true;
+    if (numFrequencies > 0) {
+      // The exact size is known up front
+      sweep.resize(numFrequencies);
+      reserved = true;
+    }
+  } else if (tokenEquals(keyword, close, "noise data") ||
+             tokenEquals(keyword, close, "end")) {
+    // The noise parameters are not used
+    return false;
+  }
+  // Other keywords ([Number of Noise Frequencies], [Mixed-Mode Order]) do not
+  // change how the S-parameters are read
+  return true;
+}
+
+bool TouchstoneParser::parseValue(double value) {
+  if (pair < 0) {
+    if (sweep.ports == 0) {
+      qDebug() << "The number of ports of the Touchstone file is unknown";
+      return false;
+    }
+    if (entries.empty()) {
+      setEntryOrder();
+    }
+    networkData = true;
+
+    double frequency = value * freqScale;
+    // In 2-port Touchstone 1.x files, the noise parameters follow the
+    // S-parameters and start at a frequency not above the last one
+    if (!version2 && sweep.ports == 2 && point > 0 &&
+        frequency <= sweep.frequency[point - 1]) {
+      return false;
+    }
+    if (point == sweep.size()) {
+      sweep.resize(std::max<size_t>(16, 2 * point));
+    }
+    sweep.frequency[point] = frequency;
+    pair = 0;
+    return true;
+  }
+
+  if (!haveFirst) {
+    first = value;
+    haveFirst = true;
+    return true;
+  }
+  haveFirst = false;
+
+  std::complex<double> s;
+  switch (format) {
+  case TouchstoneFormat::RI:
+    s = std::complex<double>(first, value);
+    break;
+  case TouchstoneFormat::MA:
+    s = std::polar(first, value * (M_PI / 180));
+    break;
+  case TouchstoneFormat::DB:
+    s = std::polar(std::pow(10, first / 20), value * (M_PI / 180));
+    break;
+  }
+
+  const auto &entry = entries[pair];
+  sweep.at(point, entry.first, entry.second) = s;
+  if (matrixFormat != MatrixFormat::Full) {
+    // Reciprocal network: only one triangle is given
+    sweep.at(point, entry.second, entry.first) = s;
+  }
+
+  if (++pair == (int)entries.size()) {
+    pair = -1;
+    ++point;
+  }
+  return true;
+}
+
+void TouchstoneParser::setEntryOrder() {
+  int ports = sweep.ports;
+  for (int row = 0; row < ports; ++row) {
+    int firstCol = matrixFormat == MatrixFormat::Upper ? row : 0;
+    int lastCol = matrixFormat == MatrixFormat::Lower ? row : ports - 1;
+    for (int col = firstCol; col <= lastCol; ++col) {
+      entries.emplace_back(row, col);
+    }
+  }
+  if (ports == 2 && matrixFormat == MatrixFormat::Full && order21_12) {
+    std::swap(entries[1], entries[2]); // S11 S21 S12 S22
+  }
+}
 
-    // Split line by whitespace
-    values.clear();
-    values = line.split(' ', Qt::SkipEmptyParts);
-
-    file_data["frequency"].append(values[0].toDouble() * freq_scale); // in Hz
-
-    // S_in1_becomes_dB and S_in2_becomes_angle are s-param args, e.g. mag angle
-    // They become dB and angle
-    double S_in1_becomes_dB, S_in2_becomes_angle, S_re, S_im;
-    QString s1, s2, s3, s4;
-    int index = 1, data_counter = 0;
-
-    for (int i = 1; i <= number_of_ports; i++) {
-      for (int j = 1; j <= number_of_ports; j++) {
-        s1 = QStringLiteral("S") + QString::number(j) + QString::number(i) +
-             QStringLiteral("_dB");
-        s2 = s1.mid(0, s1.length() - 2).append("ang");
-        s3 = s1.mid(0, s1.length() - 2).append("re");
-        s4 = s1.mid(0, s1.length() - 2).append("im");
-
-        S_in1_becomes_dB = values[index].toDouble();
-        S_in2_becomes_angle = values[index + 1].toDouble();
-
-        convert_MA_RI_to_dB(S_in1_becomes_dB, S_in2_becomes_angle, S_re, S_im, format);
-
-        file_data[s1].append(S_in1_becomes_dB); // dB
-        file_data[s2].append(S_in2_becomes_angle); // ang
-        file_data[s3].append(S_re); // re
-        file_data[s4].append(S_im); // im
-        index += 2;
-        data_counter++;
-
-        // Check if the next values are in the new line
-        if ((index >= values.length()) &&
-            (data_counter < number_of_ports * number_of_ports)) {
-          line = in.readLine();
-          line = line.simplified();
-          values = line.split(' ');
-          index = 0; // Reset index (it's a new line)
-        }
+void TouchstoneParser::reserve() {
+  // The first record tells how long the rest of the file is likely to be, so
+  // the storage is sized once. A file that is still being written may
+  // already be longer than it was when the parse started
+  reserved = true;
+  size_t estimate =
+      std::max<qint64>(0, bytesLeft) / std::max<qint64>(1, firstRecordBytes);
+  sweep.resize(std::max(sweep.size(), point + 1 + estimate * 21 / 20));
+}
+
+bool TouchstoneParser::finish() {
+  // An incomplete last record is dropped
+  sweep.resize(point);
+  setImpedances(sweep);
+  return point > 0;
+}
+
+void TouchstoneParser::setImpedances(SParSweep &target) const {
+  target.Z0 = Z0;
+  target.reference.clear();
+  if (!references.empty()) {
+    target.Z0 = references[0];
+    bool common = std::all_of(references.begin(), references.end(),
+                              [&](double z) { return z == target.Z0; });
+    if (!common) {
+      target.reference = references;
+    }
+  }
+}
+
+/// @brief Feeds the lines of a range of a file to the parser
+/// @details The range is mapped and tokenized in place, one window at a time,
+/// so the memory used to read it does not depend on its size. If a window
+/// cannot be mapped (e.g. on a file system without mmap support), it is read
+/// instead. A line cut by the end of a window is carried over to the next one
+/// @param file Open file
+/// @param from Offset of the first line
+/// @param until End of the range
+/// @param lastLine Parse the text after the last line break too (the end of a
+/// complete file). Otherwise it is left for the next call
+/// @param parser Parser
+/// @param[in,out] reading Set to false once the network data has ended
+/// @return Offset past the last line parsed
+qint64 parseLines(QFile &file, qint64 from, qint64 until, bool lastLine,
+                  TouchstoneParser &parser, bool &reading) {
+  const qint64 WindowSize = 64 << 20;
+  qint64 parsed = from;
+  std::string carry;
+  QByteArray buffer;
+  for (qint64 offset = from; reading && offset < until; offset += WindowSize) {
+    qint64 length = std::min(WindowSize, until - offset);
+    uchar *mapped = file.map(offset, length);
+    const char *window = reinterpret_cast<const char *>(mapped);
+    if (!mapped) {
+      file.seek(offset);
+      buffer = file.read(length);
+      window = buffer.constData();
+      length = buffer.size();
+    }
+
+    const char *p = window;
+    const char *end = window + length;
+    while (reading && p < end) {
+      const char *eol =
+          static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (!eol) {
+        carry.append(p, end);
+        break;
+      }
+      if (carry.empty()) {
+        reading = parser.parseLine(p, eol);
+      } else {
+        carry.append(p, eol);
+        reading = parser.parseLine(carry.data(), carry.data() + carry.size());
+        carry.clear();
       }
+      p = eol + 1;
+      parsed = offset + (p - window);
+    }
+
+    if (mapped) {
+      file.unmap(mapped);
     }
   }
+  if (reading && lastLine && !carry.empty()) {
+    parser.parseLine(carry.data(), carry.data() + carry.size());
+    parsed = until;
+  }
+  return parsed;
+}
 
+/// @brief Returns the number of ports given by the extension of a Touchstone
+/// file: N for .sNp, 0 for .ts (given by [Number of Ports]), -1 otherwise
+int portsFromSuffix(const QString &filePath) {
+  QString suffix = QFileInfo(filePath).suffix().toLower();
+  if (suffix == "ts") {
+    return 0;
+  }
+  int ports = 0;
+  if (suffix.startsWith("s") && suffix.endsWith("p")) {
+    ports = suffix.mid(1, suffix.length() - 2).toInt();
+  }
+  return ports > 0 ? ports : -1;
+}
+
+// Bytes kept to tell whether the content already read has changed
+constexpr qint64 FingerprintBytes = 4096;
+
+/// @brief Returns true if a file has the given bytes at an offset
+bool hasBytes(QFile &file, qint64 offset, const QByteArray &bytes) {
+  return file.seek(offset) && file.read(bytes.size()) == bytes;
+}
+
+} // namespace
+
+bool readTouchstoneFile(const QString &filePath, SParSweep &sweep) {
+  // Touchstone 1.x files give the number of ports by the extension (.sNp).
+  // Touchstone 2.0 files (.ts or .sNp) give it by [Number of Ports]
+  int number_of_ports = portsFromSuffix(filePath);
+  if (number_of_ports < 0) {
+    qDebug() << "Not a Touchstone file:" << filePath;
+    return false;
+  }
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "Cannot open the file";
+    return false;
+  }
+
+  qint64 size = file.size();
+  TouchstoneParser parser(sweep, number_of_ports, size);
+  bool reading = true;
+  parseLines(file, 0, size, true, parser, reading);
+
+  file.close();
+  return parser.finish();
+}
+
+struct TouchstoneTailReader::State {
+  QString filePath;
+  int ports = -1; ///< Given by the extension (see portsFromSuffix())
+  SParSweep sweep; ///< All the points read, with spare capacity
+  std::unique_ptr<TouchstoneParser> parser;
+  bool reading = true; ///< The network data has not ended
+  qint64 offset = 0;   ///< End of the last line parsed
+  QByteArray head;     ///< First bytes of the file
+  QByteArray tail;     ///< Bytes before the offset
+  size_t published = 0; ///< Points returned by the previous updates
+  bool reloaded = true; ///< The next points returned start a new sweep
+  /// Last points returned, read from a line without line break. They are
+  /// checked once the line is complete
+  size_t tentative = 0;
+  std::vector<double> tentativeFrequency;
+  std::vector<std::complex<double>> tentativeS;
+};
+
+TouchstoneTailReader::TouchstoneTailReader(const QString &filePath)
+    : state(new State) {
+  state->filePath = filePath;
+  state->ports = portsFromSuffix(filePath);
+}
+
+TouchstoneTailReader::~TouchstoneTailReader() = default;
+
+TouchstoneTailReader::Update TouchstoneTailReader::update(SParSweep &sweep) {
+  State &s = *state;
+  QFile file(s.filePath);
+  if (s.ports < 0 || !file.open(QIODevice::ReadOnly)) {
+    return Update::Failed;
+  }
+
+  const qint64 size = file.size();
+  if (!s.parser || size < s.offset || !hasBytes(file, 0, s.head) ||
+      !hasBytes(file, s.offset - s.tail.size(), s.tail)) {
+    // First update, or the file was rewritten
+    s.parser.reset(new TouchstoneParser(s.sweep, s.ports, size));
+    s.reading = true;
+    s.offset = 0;
+    s.head.clear();
+    s.tail.clear();
+    s.published = 0;
+    s.reloaded = true;
+    s.tentative = 0;
+  }
+  if (!s.reading || (size == s.offset && s.tentative == 0)) {
+    return Update::Unchanged;
+  }
+
+  s.offset = parseLines(file, s.offset, size, false, *s.parser, s.reading);
+  if (s.head.size() < FingerprintBytes) {
+    file.seek(0);
+    s.head = file.read(std::min(FingerprintBytes, s.offset));
+  }
+  qint64 tailBytes = std::min(FingerprintBytes, s.offset);
+  file.seek(s.offset - tailBytes);
+  s.tail = file.read(tailBytes);
+
+  // The last line may not have its line break yet, either because the writer
+  // is busy or because the file ends there. It is read as readTouchstoneFile()
+  // does, on a copy of the parser, and read again by the next update
+  TouchstoneParser last(*s.parser);
+  if (s.reading && size > s.offset) {
+    file.seek(s.offset);
+    QByteArray line = file.read(size - s.offset);
+    last.parseLine(line.constData(), line.constData() + line.size());
+  }
   file.close();
-  return file_data;
+
+  const size_t entries = s.sweep.ports * s.sweep.ports;
+  size_t points = last.points();
+
+  // The points read from an unfinished line are returned again, with the
+  // whole sweep, if the rest of the line changed them
+  bool changed = false;
+  if (s.tentative > 0) {
+    size_t from = s.published - s.tentative;
+    changed =
+        points < s.published ||
+        !std::equal(s.tentativeFrequency.begin(), s.tentativeFrequency.end(),
+                    s.sweep.frequency.begin() + from) ||
+        !std::equal(s.tentativeS.begin(), s.tentativeS.end(),
+                    s.sweep.S.begin() + from * entries);
+  }
+  size_t committed = std::min(s.parser->points(), points);
+  s.tentative = points - committed;
+  s.tentativeFrequency.assign(s.sweep.frequency.begin() + committed,
+                              s.sweep.frequency.begin() + points);
+  s.tentativeS.assign(s.sweep.S.begin() + committed * entries,
+                      s.sweep.S.begin() + points * entries);
+  if (changed) {
+    s.reloaded = true;
+  }
+
+  // Until the rewritten file has data, the points of the previous one stay
+  if (points == s.published && !changed) {
+    return Update::Unchanged;
+  }
+  size_t first = s.reloaded ? 0 : s.published;
+  Update result = s.reloaded ? Update::Reloaded : Update::Appended;
+  s.reloaded = false;
+  s.published = points;
+
+  sweep.reset(s.sweep.ports);
+  sweep.frequency.assign(s.sweep.frequency.begin() + first,
+                         s.sweep.frequency.begin() + points);
+  sweep.S.assign(s.sweep.S.begin() + first * entries,
+                 s.sweep.S.begin() + points * entries);
+  sweep.status.assign(points - first, SolveStatus::Ok);
+  sweep.condition.assign(points - first, 1);
+  last.setImpedances(sweep);
+  return result;
+}
+
+QMap<QString, QList<double>> readTouchstoneFile(const QString &filePath) {
+  SParSweep sweep;
+  if (!readTouchstoneFile(filePath, sweep)) {
+    return {};
+  }
+  if (!sweep.reference.empty()) {
+    qWarning() << filePath
+               << "has a different reference impedance at each port. The "
+                  "traces are referred to the impedance of port 1";
+  }
+  return sweepToDataset(sweep);
 }
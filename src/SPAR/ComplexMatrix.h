@@ -0,0 +1,252 @@
+/// @file ComplexMatrix.h
+/// @brief Dense complex matrix types used by the S-parameter engine
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef COMPLEXMATRIX_H
+#define COMPLEXMATRIX_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/// @brief Alignment (bytes) of the matrix storage. Matches a cache line so
+/// that rows of small matrices do not straddle two lines
+static constexpr std::size_t ComplexMatrixAlignment = 64;
+
+/// @class BasicComplexMatrixView
+/// @brief Non-owning view over a row-major block of complex numbers
+/// @details A view does not own its storage. It is used to address a matrix
+/// (or a sub-block of it) without copying, e.g. when passing fixed-size and
+/// dynamic matrices to the same solver routine.
+template <typename T> class BasicComplexMatrixView {
+public:
+  BasicComplexMatrixView() = default;
+
+  /// @brief Constructor
+  /// @param data Pointer to the first element
+  /// @param rows Number of rows
+  /// @param cols Number of columns
+  /// @param stride Distance (in elements) between the start of two rows
+  BasicComplexMatrixView(T *data, int rows, int cols, int stride)
+      : ptr(data), nRows(rows), nCols(cols), rowStride(stride) {}
+
+  /// @brief Implicit conversion from a mutable view to a read-only view
+  template <typename U>
+  BasicComplexMatrixView(const BasicComplexMatrixView<U> &other)
+      : ptr(other.data()), nRows(other.rows()), nCols(other.cols()),
+        rowStride(other.stride()) {}
+
+  int rows() const { return nRows; }
+  int cols() const { return nCols; }
+  int stride() const { return rowStride; }
+  T *data() const { return ptr; }
+
+  /// @brief Returns a pointer to the first element of row i
+  T *operator[](int i) const { return ptr + (std::size_t)i * rowStride; }
+  T &operator()(int i, int j) const {
+    return ptr[(std::size_t)i * rowStride + j];
+  }
+
+  /// @brief Returns a view of the sub-block starting at (row, col)
+  BasicComplexMatrixView block(int row, int col, int rows, int cols) const {
+    return BasicComplexMatrixView(ptr + (std::size_t)row * rowStride + col,
+                                  rows, cols, rowStride);
+  }
+
+  /// @brief Swaps the contents of rows i and j
+  void swapRows(int i, int j) const {
+    if (i != j) {
+      std::swap_ranges((*this)[i], (*this)[i] + nCols, (*this)[j]);
+    }
+  }
+
+private:
+  T *ptr = nullptr;
+  int nRows = 0;
+  int nCols = 0;
+  int rowStride = 0;
+};
+
+using ComplexMatrixView = BasicComplexMatrixView<std::complex<double>>;
+using ConstComplexMatrixView =
+    BasicComplexMatrixView<const std::complex<double>>;
+
+/// @class ComplexMatrix
+/// @brief Dense, row-major complex matrix stored in a single aligned block
+/// @details Element (i, j) lives at data()[i * cols() + j]. M[i] returns a
+/// pointer to row i, so the usual M[i][j] indexing is available.
+/// resize() keeps the allocation when the new size fits in it, which allows
+/// scratch matrices to be reused across frequency points.
+class ComplexMatrix {
+public:
+  using Complex = std::complex<double>;
+
+  ComplexMatrix() = default;
+
+  /// @brief Creates a rows x cols matrix initialized to zero
+  ComplexMatrix(int rows, int cols) { resize(rows, cols); }
+
+  ComplexMatrix(const ComplexMatrix &other) { *this = other; }
+
+  ComplexMatrix(ComplexMatrix &&other) noexcept { swap(other); }
+
+  ~ComplexMatrix() { release(); }
+
+  ComplexMatrix &operator=(const ComplexMatrix &other) {
+    if (this != &other) {
+      reshape(other.nRows, other.nCols);
+      std::copy(other.ptr, other.ptr + other.size(), ptr);
+    }
+    return *this;
+  }
+
+  ComplexMatrix &operator=(ComplexMatrix &&other) noexcept {
+    if (this != &other) {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  /// @brief Returns an n x n identity matrix
+  static ComplexMatrix identity(int n) {
+    ComplexMatrix I(n, n);
+    for (int i = 0; i < n; i++) {
+      I(i, i) = Complex(1, 0);
+    }
+    return I;
+  }
+
+  int rows() const { return nRows; }
+  int cols() const { return nCols; }
+  std::size_t size() const { return (std::size_t)nRows * nCols; }
+  bool empty() const { return size() == 0; }
+
+  Complex *data() { return ptr; }
+  const Complex *data() const { return ptr; }
+
+  Complex *operator[](int i) { return ptr + (std::size_t)i * nCols; }
+  const Complex *operator[](int i) const {
+    return ptr + (std::size_t)i * nCols;
+  }
+  Complex &operator()(int i, int j) { return ptr[(std::size_t)i * nCols + j]; }
+  const Complex &operator()(int i, int j) const {
+    return ptr[(std::size_t)i * nCols + j];
+  }
+
+  /// @brief Resizes the matrix and sets all the entries to zero
+  void resize(int rows, int cols) {
+    reshape(rows, cols);
+    setZero();
+  }
+
+  /// @brief Sets all the entries to zero
+  void setZero() { std::fill(ptr, ptr + size(), Complex(0, 0)); }
+
+  ComplexMatrixView view() { return ComplexMatrixView(ptr, nRows, nCols, nCols); }
+  ConstComplexMatrixView view() const {
+    return ConstComplexMatrixView(ptr, nRows, nCols, nCols);
+  }
+
+  void swap(ComplexMatrix &other) noexcept {
+    std::swap(ptr, other.ptr);
+    std::swap(nRows, other.nRows);
+    std::swap(nCols, other.nCols);
+    std::swap(capacity, other.capacity);
+  }
+
+private:
+  Complex *ptr = nullptr;
+  int nRows = 0;
+  int nCols = 0;
+  std::size_t capacity = 0;
+
+  /// @brief Changes the dimensions. Existing storage is reused if large
+  /// enough, the contents are left unspecified
+  void reshape(int rows, int cols) {
+    std::size_t n = (std::size_t)rows * cols;
+    if (n > capacity) {
+      release();
+      ptr = static_cast<Complex *>(::operator new(
+          n * sizeof(Complex), std::align_val_t(ComplexMatrixAlignment)));
+      capacity = n;
+    }
+    nRows = rows;
+    nCols = cols;
+  }
+
+  void release() {
+    if (ptr) {
+      ::operator delete(ptr, std::align_val_t(ComplexMatrixAlignment));
+    }
+    ptr = nullptr;
+    capacity = 0;
+    nRows = nCols = 0;
+  }
+};
+
+/// @class FixedComplexMatrix
+/// @brief N x N complex matrix with inline (stack) storage
+/// @details Used for the small, fixed-size blocks of the stamps (2x2 for
+/// two-port devices, 4x4 for coupled lines and couplers), so building them
+/// never touches the heap.
+template <int N> class FixedComplexMatrix {
+public:
+  using Complex = std::complex<double>;
+
+  FixedComplexMatrix() { setZero(); }
+
+  static FixedComplexMatrix identity() {
+    FixedComplexMatrix I;
+    for (int i = 0; i < N; i++) {
+      I(i, i) = Complex(1, 0);
+    }
+    return I;
+  }
+
+  static constexpr int rows() { return N; }
+  static constexpr int cols() { return N; }
+
+  Complex *data() { return elements.data(); }
+  const Complex *data() const { return elements.data(); }
+
+  Complex *operator[](int i) { return elements.data() + i * N; }
+  const Complex *operator[](int i) const { return elements.data() + i * N; }
+  Complex &operator()(int i, int j) { return elements[i * N + j]; }
+  const Complex &operator()(int i, int j) const { return elements[i * N + j]; }
+
+  void setZero() { elements.fill(Complex(0, 0)); }
+
+  ComplexMatrixView view() { return ComplexMatrixView(data(), N, N, N); }
+  ConstComplexMatrixView view() const {
+    return ConstComplexMatrixView(data(), N, N, N);
+  }
+
+private:
+  alignas(ComplexMatrixAlignment) std::array<Complex, N * N> elements;
+};
+
+using ComplexMatrix2 = FixedComplexMatrix<2>; ///< Two-port blocks
+using ComplexMatrix4 = FixedComplexMatrix<4>; ///< Four-port blocks
+
+/// @brief Returns true if no entry of a matrix (or view) is NaN or infinite
+template <typename M> bool isFiniteMatrix(const M &matrix) {
+  for (int i = 0; i < matrix.rows(); i++) {
+    const auto *row = matrix[i];
+    for (int j = 0; j < matrix.cols(); j++) {
+      if (!std::isfinite(row[j].real()) || !std::isfinite(row[j].imag())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+#endif // COMPLEXMATRIX_H
@@ -0,0 +1,63 @@
+/// @file SParEngine.cpp
+/// @brief Plain C++ interface to the S-parameter simulation engine
+/// (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParEngine.h"
+#include "SParameterCalculator.h"
+
+SParEngine::SParEngine() : engine(new SParameterCalculator()) {
+  engine->setFrequencySweep(f_start, f_stop, n_points);
+}
+
+SParEngine::~SParEngine() = default;
+
+SParEngine::SParEngine(SParEngine &&) noexcept = default;
+
+SParEngine &SParEngine::operator=(SParEngine &&) noexcept = default;
+
+bool SParEngine::setNetlist(const std::string &netlist) {
+  return engine->setNetlist(QString::fromStdString(netlist));
+}
+
+void SParEngine::setFrequencySweep(double start, double stop, int points) {
+  f_start = start;
+  f_stop = stop;
+  n_points = points;
+  engine->setFrequencySweep(start, stop, points);
+}
+
+void SParEngine::setThreads(int threads) { engine->setSweepThreads(threads); }
+
+std::size_t SParEngine::numPorts() const { return engine->getNumPorts(); }
+
+SParSweep SParEngine::sweep() {
+  if (engine->getNumPorts() == 0) {
+    return SParSweep(); // Nothing to simulate
+  }
+  engine->calculateSParameterSweep();
+  return engine->getSweep();
+}
+
+bool SParEngine::sweep(std::complex<double> *S, std::size_t size) {
+  std::size_t ports = engine->getNumPorts();
+  if ((std::size_t)std::max(n_points, 0) * ports * ports > size) {
+    return false;
+  }
+  if (ports == 0) {
+    return true; // Nothing to simulate
+  }
+  engine->calculateSParameterSweep();
+
+  // The sweep is already stored as [point][row][col]
+  const SParSweep &result = engine->getSweep();
+  std::copy(result.S.begin(), result.S.end(), S);
+  return true;
+}
+
+bool SParEngine::exportTouchstone(const std::string &filename) const {
+  return engine->exportSweepTouchstone(QString::fromStdString(filename));
+}
@@ -0,0 +1,73 @@
+/// @file SParEngine.h
+/// @brief Plain C++ interface to the S-parameter simulation engine
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef SPARENGINE_H
+#define SPARENGINE_H
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SParSweep.h"
+
+class SParameterCalculator;
+
+/// @class SParEngine
+/// @brief Netlist simulator that can be used without any Qt header
+/// @details It wraps SParameterCalculator for tools that link the engine
+/// library directly (test harnesses, batch and throughput tools). Points
+/// that cannot be solved are NaN and flagged in SParSweep::status; invalid
+/// netlists are reported by exceptions (std::runtime_error).
+class SParEngine {
+public:
+  SParEngine();
+  ~SParEngine();
+  SParEngine(SParEngine &&) noexcept;
+  SParEngine &operator=(SParEngine &&) noexcept;
+
+  /// @brief Parses a netlist (same format as the built-in simulator)
+  /// @return false if the netlist could not be parsed
+  bool setNetlist(const std::string &netlist);
+
+  /// @brief Sets a linear frequency sweep
+  /// @param start Start frequency (Hz)
+  /// @param stop Stop frequency (Hz)
+  /// @param points Number of points
+  void setFrequencySweep(double start, double stop, int points);
+
+  /// @brief Sets the number of threads of the sweep. 0 uses one per hardware
+  /// thread
+  void setThreads(int threads);
+
+  /// @brief Returns the number of ports of the netlist
+  std::size_t numPorts() const;
+
+  /// @brief Runs the frequency sweep
+  /// @return Frequencies and S-parameters
+  SParSweep sweep();
+
+  /// @brief Runs the frequency sweep and copies the S-parameters into a
+  /// caller-owned buffer, so that repeated sweeps do not allocate the result
+  /// @param S Output buffer of points * ports * ports entries, [point][row][col]
+  /// @param size Number of entries of the buffer
+  /// @return false if the buffer is too small
+  bool sweep(std::complex<double> *S, std::size_t size);
+
+  /// @brief Writes the S-parameters of the last sweep to a Touchstone file
+  /// @return false if the file could not be written
+  bool exportTouchstone(const std::string &filename) const;
+
+private:
+  std::unique_ptr<SParameterCalculator> engine; ///< Simulation engine
+  double f_start = 1e6; ///< Frequency sweep start (Hz)
+  double f_stop = 1e9;  ///< Frequency sweep stop (Hz)
+  int n_points = 20;    ///< Number of frequency points
+};
+
+#endif // SPARENGINE_H
@@ -0,0 +1,85 @@
+/// @file SParSweep.cpp
+/// @brief Columnar storage of the S-parameters of a frequency sweep
+/// (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParSweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Applies f to S(row, col) at every point. The entries of a trace are
+// ports * ports apart in the tensor
+template <typename T, typename F>
+std::vector<T> column(const SParSweep &sweep, std::size_t row, std::size_t col,
+                      F f) {
+  std::vector<T> values(sweep.size());
+  const std::size_t stride = sweep.ports * sweep.ports;
+  const std::complex<double> *S = sweep.S.data() + row * sweep.ports + col;
+  for (std::size_t i = 0; i < values.size(); ++i, S += stride) {
+    values[i] = f(*S);
+  }
+  return values;
+}
+
+} // namespace
+
+void SParSweep::reset(std::size_t numPorts) {
+  frequency.clear();
+  S.clear();
+  status.clear();
+  condition.clear();
+  reference.clear();
+  ports = numPorts;
+}
+
+void SParSweep::resize(std::size_t points) {
+  frequency.resize(points);
+  S.resize(points * ports * ports);
+  status.resize(points, SolveStatus::Ok);
+  condition.resize(points, 1.0);
+}
+
+std::size_t SParSweep::count(SolveStatus value) const {
+  return std::count(status.begin(), status.end(), value);
+}
+
+std::vector<std::complex<double>> SParSweep::trace(std::size_t row,
+                                                   std::size_t col) const {
+  return column<std::complex<double>>(
+      *this, row, col, [](const std::complex<double> &s) { return s; });
+}
+
+std::vector<double> SParSweep::real(std::size_t row, std::size_t col) const {
+  return column<double>(*this, row, col,
+                        [](const std::complex<double> &s) { return s.real(); });
+}
+
+std::vector<double> SParSweep::imag(std::size_t row, std::size_t col) const {
+  return column<double>(*this, row, col,
+                        [](const std::complex<double> &s) { return s.imag(); });
+}
+
+std::vector<double> SParSweep::magnitude(std::size_t row,
+                                         std::size_t col) const {
+  return column<double>(*this, row, col, [](const std::complex<double> &s) {
+    return std::abs(s);
+  });
+}
+
+std::vector<double> SParSweep::dB(std::size_t row, std::size_t col) const {
+  return column<double>(*this, row, col, [](const std::complex<double> &s) {
+    return 20.0 * std::log10(std::abs(s));
+  });
+}
+
+std::vector<double> SParSweep::angle(std::size_t row, std::size_t col) const {
+  return column<double>(*this, row, col, [](const std::complex<double> &s) {
+    return std::atan2(s.imag(), s.real()) * (180.0 / M_PI);
+  });
+}
@@ -0,0 +1,110 @@
+/// @file SParSweep.h
+/// @brief Columnar storage of the S-parameters of a frequency sweep
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef SPARSWEEP_H
+#define SPARSWEEP_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "ComplexMatrix.h"
+
+/// @enum SolveStatus
+/// @brief Outcome of the solve of a frequency point
+enum class SolveStatus : unsigned char {
+  Ok,           ///< Solved
+  NearSingular, ///< Solved, but the nodal system is ill-conditioned
+  Singular,     ///< Not solved: the nodal system is singular
+  Failed        ///< Not solved: the solver reported an error
+};
+
+/// @struct SParSweep
+/// @brief S-parameters of a frequency sweep
+/// @details The frequencies are kept in one vector and the S-parameters in a
+/// single points x ports x ports tensor, so the number of allocations of a
+/// sweep does not depend on its size. Magnitude, dB and phase are not stored:
+/// they are computed from the complex values by the trace views below, one
+/// S-parameter at a time, when a consumer asks for them. The S-parameters of
+/// the points that could not be solved are NaN.
+struct SParSweep {
+  std::vector<double> frequency; ///< Frequency points (Hz)
+  std::size_t ports = 0;         ///< Number of ports
+  double Z0 = 50;                ///< Reference impedance (Ohm)
+  /// Reference impedance of each port (Ohm), only when they are not all Z0
+  std::vector<double> reference;
+  /// S-parameters stored as [point][row][col], row-major
+  std::vector<std::complex<double>> S;
+  std::vector<SolveStatus> status; ///< Solve status of each point
+  /// Condition estimate of each point: how much the factorizations of the
+  /// point cancelled, as the largest ratio between the magnitude of a row and
+  /// its pivot (infinite if singular)
+  std::vector<double> condition;
+
+  /// @brief Returns the number of frequency points
+  std::size_t size() const { return frequency.size(); }
+
+  /// @brief Returns true if the sweep has no points
+  bool empty() const { return frequency.empty(); }
+
+  /// @brief Discards the points and sets the number of ports
+  void reset(std::size_t numPorts);
+
+  /// @brief Resizes the storage to a number of points. New entries are zero,
+  /// with status Ok
+  void resize(std::size_t points);
+
+  /// @brief Returns the number of points with the given status
+  std::size_t count(SolveStatus value) const;
+
+  /// @brief Returns S(row, col) at a frequency point (0-based indices)
+  const std::complex<double> &at(std::size_t point, std::size_t row,
+                                 std::size_t col) const {
+    return S[(point * ports + row) * ports + col];
+  }
+
+  /// @brief Returns S(row, col) at a frequency point (0-based indices)
+  std::complex<double> &at(std::size_t point, std::size_t row,
+                           std::size_t col) {
+    return S[(point * ports + row) * ports + col];
+  }
+
+  /// @brief Returns the S-matrix of a frequency point without copying it
+  ConstComplexMatrixView matrix(std::size_t point) const {
+    return ConstComplexMatrixView(S.data() + point * ports * ports,
+                                  (int)ports, (int)ports, (int)ports);
+  }
+
+  /// @brief Returns the S-matrix of a frequency point without copying it
+  ComplexMatrixView matrix(std::size_t point) {
+    return ComplexMatrixView(S.data() + point * ports * ports, (int)ports,
+                             (int)ports, (int)ports);
+  }
+
+  // Trace views. Each one returns S(row, col) (0-based) over the whole sweep
+
+  /// @brief Returns the complex values of S(row, col)
+  std::vector<std::complex<double>> trace(std::size_t row,
+                                          std::size_t col) const;
+
+  /// @brief Returns the real part of S(row, col)
+  std::vector<double> real(std::size_t row, std::size_t col) const;
+
+  /// @brief Returns the imaginary part of S(row, col)
+  std::vector<double> imag(std::size_t row, std::size_t col) const;
+
+  /// @brief Returns the magnitude of S(row, col) in natural units
+  std::vector<double> magnitude(std::size_t row, std::size_t col) const;
+
+  /// @brief Returns the magnitude of S(row, col) in dB
+  std::vector<double> dB(std::size_t row, std::size_t col) const;
+
+  /// @brief Returns the phase of S(row, col) in degrees, in (-180, 180]
+  std::vector<double> angle(std::size_t row, std::size_t col) const;
+};
+
+#endif // SPARSWEEP_H
@@ -6,127 +6,141 @@
 /// @license GPL-3.0-or-later
 
 #include "SParameterCalculator.h"
+#include "Misc/profiler.h"
 
-Complex SParameterCalculator::getImpedance(const Component_SPAR &comp,
+Complex SParameterCalculator::getImpedance(const CompiledLumped &comp,
                                            double freq) {
   double omega = 2 * M_PI * freq;
   switch (comp.type) {
   case ComponentType_SPAR::RESISTOR:
-    return Complex(comp.value["R"], 0);
+    return Complex(comp.value, 0);
 
   case ComponentType_SPAR::COMPLEX_IMPEDANCE:
-    return comp.Zvalue["Z"];
+    return comp.Z;
 
   case ComponentType_SPAR::CAPACITOR:
-    return Complex(0, -1.0 / (omega * comp.value["C"]));
+    return Complex(0, -1.0 / (omega * comp.value));
 
   case ComponentType_SPAR::INDUCTOR:
-    return Complex(0, omega * comp.value["L"]);
-
-  case ComponentType_SPAR::OPEN_STUB: {
-    double Z0 = comp.value["Z0"];
-    double len = comp.value["Length"];
-    const double c = 299792458.0;
-    double beta = omega / c;
-    double cot_beta_l = 1.0 / tan(beta * len);
-    return Complex(0, -Z0 * cot_beta_l);
-  }
-
-  case ComponentType_SPAR::SHORT_STUB: {
-    double Z0 = comp.value["Z0"];
-    double len = comp.value["Length"];
-    const double c = 299792458.0;
-    double beta = omega / c;
-    double tan_beta_l = tan(beta * len);
-    return Complex(0, Z0 * tan_beta_l);
-  }
+    return Complex(0, omega * comp.value);
 
   default:
     return Complex(0, 0);
   }
 }
 
-vector<vector<Complex>> SParameterCalculator::buildAdmittanceMatrix() {
-  vector<vector<Complex>> Y = createMatrix(numNodes, numNodes);
-
-  // First handle ALL lumped elements (R, L, C)
-  for (const auto &comp : components) {
+Complex SParameterCalculator::getImpedance(const CompiledStub &stub,
+                                           double freq) {
+  double omega = 2 * M_PI * freq;
+  const double c = 299792458.0;
+  double beta = omega / c;
 
-    // TRANSMISSION LINES (TLIN)
-    if (comp.type == ComponentType_SPAR::TRANSMISSION_LINE) {
-      addTransmissionLineToAdmittance(Y, comp);
-      continue;
-    }
+  if (stub.type == ComponentType_SPAR::OPEN_STUB) {
+    double cot_beta_l = 1.0 / tan(beta * stub.length);
+    return Complex(0, -stub.Z0 * cot_beta_l);
+  }
 
-    // Microstrip line model
-    if (comp.type == ComponentType_SPAR::MICROSTRIP_LINE) {
-      addMicrostripLineToAdmittance(Y, comp);
-      continue;
-    }
+  double tan_beta_l = tan(beta * stub.length);
+  return Complex(0, stub.Z0 * tan_beta_l);
+}
 
-    // Microstrip coupled line model
-    if (comp.type == ComponentType_SPAR::MICROSTRIP_COUPLED_LINES) {
-      addMicrostripCoupledLinesToAdmittance(Y, comp);
-      continue;
-    }
+void SParameterCalculator::addTwoTerminalAdmittance(StampTarget Y, int node1,
+                                                    int node2, Complex y) {
+  if (node1 > 0) {
+    Y[node1 - 1][node1 - 1] += y;
+  }
+  if (node2 > 0) {
+    Y[node2 - 1][node2 - 1] += y;
+  }
+  if (node1 > 0 && node2 > 0) {
+    Y[node1 - 1][node2 - 1] -= y;
+    Y[node2 - 1][node1 - 1] -= y;
+  }
+}
 
-    // Microstrip via model
-    if (comp.type == ComponentType_SPAR::MICROSTRIP_VIA) {
-      addMicrostripViaToAdmittance(Y, comp);
-      continue;
+void SParameterCalculator::buildFixedAdmittanceMatrix(StampTarget Y) {
+  // Resistors, fixed complex impedances and shorts
+  for (const auto &comp : circuit.fixedLumped) {
+    Complex impedance = getImpedance(comp, 0);
+    if (abs(impedance) < 1e-12) {
+      impedance = Complex(1e-12, 0); // Avoid division by zero!
     }
+    addTwoTerminalAdmittance(Y, comp.node1, comp.node2,
+                             Complex(1, 0) / impedance);
+  }
 
-    // COUPLED LINES (CLIN)
-    if (comp.type == ComponentType_SPAR::COUPLED_LINE) {
-      addCoupledLineToAdmittance(Y, comp);
-      continue;
-    }
+  for (const auto &coupler : circuit.idealCouplers) {
+    addIdealCouplerToAdmittance(Y, coupler);
+  }
 
-    if (comp.type == ComponentType_SPAR::IDEAL_COUPLER) {
-      addIdealCouplerToAdmittance(Y, comp);
-      continue;
-    }
+  // S-parameter blocks
+  for (const auto &block : circuit.sparBlocks) {
+    addSParamBlockToAdmittance(Y, block.node1, block.node2, block.numRFPorts,
+                               block.Y);
+  }
 
-    if (comp.type == ComponentType_SPAR::SPAR_BLOCK) {
-      addSParamBlockToAdmittance(Y, comp);
-      continue;
-    }
+  // Add small conductance to ground to prevent singular matrix (for all nodes)
+  double gmin = 1e-12;
+  for (int i = 0; i < numNodes; ++i) {
+    Y[i][i] += Complex(gmin, 0);
+  }
+}
 
-    if (comp.type == ComponentType_SPAR::FREQUENCY_DEPENDENT_SPAR_BLOCK) {
-      addFrequencyDependentSParamBlockToAdmittance(Y, comp);
-      continue;
+void SParameterCalculator::addFrequencyDependentAdmittance(StampTarget Y) {
+  // Capacitors, inductors and ideal stubs
+  for (const auto &comp : circuit.reactiveLumped) {
+    Complex impedance = getImpedance(comp, frequency);
+    if (abs(impedance) < 1e-12) {
+      impedance = Complex(1e-12, 0); // Avoid division by zero!
     }
+    addTwoTerminalAdmittance(Y, comp.node1, comp.node2,
+                             Complex(1, 0) / impedance);
+  }
 
-    Complex impedance = getImpedance(comp, frequency);
+  for (const auto &stub : circuit.stubs) {
+    Complex impedance = getImpedance(stub, frequency);
     if (abs(impedance) < 1e-12) {
       impedance = Complex(1e-12, 0); // Avoid division by zero!
     }
+    addTwoTerminalAdmittance(Y, stub.node1, stub.node2,
+                             Complex(1, 0) / impedance);
+  }
 
-    Complex admittance = Complex(1, 0) / impedance;
-    if (comp.nodes.size() == 2) {
-      int node1 = comp.nodes[0];
-      int node2 = comp.nodes[1];
+  // TRANSMISSION LINES (TLIN)
+  for (const auto &line : circuit.transmissionLines) {
+    addTransmissionLineToAdmittance(Y, line);
+  }
 
-      if (node1 > 0) {
-        Y[node1 - 1][node1 - 1] += admittance;
-      }
-      if (node2 > 0) {
-        Y[node2 - 1][node2 - 1] += admittance;
-      }
-      if (node1 > 0 && node2 > 0) {
-        Y[node1 - 1][node2 - 1] -= admittance;
-        Y[node2 - 1][node1 - 1] -= admittance;
-      }
-    }
+  // Microstrip line model
+  for (const auto &line : circuit.microstripLines) {
+    addMicrostripLineToAdmittance(Y, line);
   }
 
-  // Add small conductance to ground to prevent singular matrix (for all nodes)
-  double gmin = 1e-12;
-  for (int i = 0; i < numNodes; ++i) {
-    Y[i][i] += Complex(gmin, 0);
+  // Microstrip coupled line model
+  for (const auto &lines : circuit.microstripCoupledLines) {
+    addMicrostripCoupledLinesToAdmittance(Y, lines);
+  }
+
+  // Microstrip via model
+  for (const auto &via : circuit.microstripVias) {
+    addMicrostripViaToAdmittance(Y, via);
   }
 
-  return Y;
+  // COUPLED LINES (CLIN)
+  for (const auto &line : circuit.coupledLines) {
+    addCoupledLineToAdmittance(Y, line);
+  }
+
+  // Touchstone blocks, interpolated at the analysis frequency
+  for (const auto &block : circuit.frequencyDependentBlocks) {
+    addFrequencyDependentSParamBlockToAdmittance(Y, block);
+  }
+}
+
+void SParameterCalculator::buildAdmittanceMatrix(ComplexMatrix &Y) {
+  PROFILE_SCOPE("buildAdmittanceMatrix");
+  Y = fixedY;
+  addFrequencyDependentAdmittance(Y);
 }
 
 void SParameterCalculator::addComponent(ComponentType_SPAR type,
@@ -135,6 +149,8 @@ void SParameterCalculator::addComponent(ComponentType_SPAR type,
                                         QMap<QString, Complex> Zvalue) {
   components.emplace_back(type, name, nodes, Zvalue);
 
+  circuitCompiled = false;
+
   // Update number of nodes
   for (int node : nodes) {
     if (node > numNodes) {
@@ -148,6 +164,8 @@ void SParameterCalculator::addComponent(
     QMap<QString, QList<double>> freqDepData) {
   components.emplace_back(type, name, nodes, freqDepData);
 
+  circuitCompiled = false;
+
   // Update number of nodes
   for (int node : nodes) {
     if (node > numNodes) {
@@ -162,6 +180,8 @@ void SParameterCalculator::addComponent(ComponentType_SPAR type,
                                         QMap<QString, double> value) {
   components.emplace_back(type, name, nodes, value);
 
+  circuitCompiled = false;
+
   // Update number of nodes
   for (int node : nodes) {
     if (node > numNodes) {
@@ -172,79 +192,161 @@ void SParameterCalculator::addComponent(ComponentType_SPAR type,
 
 void SParameterCalculator::addPort(int node, double impedance) {
   ports.emplace_back(node, impedance);
+  circuitCompiled = false;
 }
 
-vector<vector<Complex>> SParameterCalculator::calculateSParameters() {
+ComplexMatrix SParameterCalculator::calculateSParameters() {
   if (ports.empty()) {
     throw runtime_error("No ports defined for S-parameter calculation");
   }
 
+  ensureCircuitCompiled();
+
+  ComplexMatrix S;
+  solveSParameters(S);
+  return S;
+}
+
+ComplexMatrix SParameterCalculator::calculatePortAdmittance() {
+  if (ports.empty()) {
+    throw runtime_error("No ports defined for the port admittance calculation");
+  }
+
+  ensureCircuitCompiled();
+  checkPortNodes();
+
+  ComplexMatrix Y;
+  buildAdmittanceMatrix(Y);
+  ComplexMatrix reducedY;
+  if (!reduceToPortNodes(Y, reducedY)) {
+    throw runtime_error("Matrix is singular and cannot be reduced");
+  }
+
+  // Ports sharing a node share its row and column
   int numPorts = ports.size();
-  vector<vector<Complex>> S = createMatrix(numPorts, numPorts);
-  vector<vector<Complex>> Y = buildAdmittanceMatrix();
+  ComplexMatrix portY(numPorts, numPorts);
+  for (int i = 0; i < numPorts; i++) {
+    for (int j = 0; j < numPorts; j++) {
+      portY[i][j] = reducedY[reducedPortNodes[i]][reducedPortNodes[j]];
+    }
+  }
+  return portY;
+}
 
-  // Check all port nodes are within bounds
+void SParameterCalculator::checkPortNodes() const {
   for (const auto &port : ports) {
     if (port.node <= 0 || port.node > numNodes) {
       throw runtime_error("Port node " + to_string(port.node) +
                           " is out of bounds (1-" + to_string(numNodes) + ")");
     }
   }
+}
 
-  for (int j = 0; j < numPorts; j++) {
-    int systemSize = numNodes + numPorts;
-    vector<vector<Complex>> augmentedY = createMatrix(systemSize, systemSize);
-    vector<Complex> excitation(systemSize, Complex(0, 0));
+void SParameterCalculator::solveSParameters(ComplexMatrix &S) {
+  checkPortNodes();
 
-    // Copy the internal nodal admittance matrix
-    for (int i = 0; i < numNodes; i++) {
-      for (int k = 0; k < numNodes; k++) {
-        augmentedY[i][k] = Y[i][k];
-      }
-    }
+  // Two-port chains are evaluated with ABCD matrices. Points where the chain
+  // product breaks down fall through to nodal analysis
+  if (cascadeFastPath && cascade.valid && solveCascade(S)) {
+    return;
+  }
+
+  // The sparse solver already eliminates the internal nodes before the ports,
+  // so the Kron reduction only replaces the dense path
+  if (kronReduction && !sparseLU.isAnalyzed()) {
+    ComplexMatrix &Y = scratchY;
+    buildAdmittanceMatrix(Y);
+    reduceToPortNodes(Y, scratchReducedY);
+    solvePortSystem(scratchReducedY, reducedPortNodes, S);
+  } else {
+    solveNodalSystem(S);
+  }
+}
 
-    // Add port equations
-    for (int p = 0; p < numPorts; p++) {
-      int portNode = ports[p].node - 1;
-      int portEqn = numNodes + p;
+bool SParameterCalculator::solveNodalSystem(ComplexMatrix &S) {
+  // Large circuits are assembled straight into the sparse factor storage.
+  // The dense Y-matrix is only built if the static pivot order turns out to
+  // be unstable at this frequency
+  if (sparseLU.isAnalyzed() && factorizeSparse()) {
+    setPortExcitation(numNodes, portNodes);
+    sparseLU.solve(scratchExcitation.view());
+    readPortSolution(numNodes, S);
+    return true;
+  }
 
-      augmentedY[portEqn][portNode] = Complex(1, 0);
-      augmentedY[portEqn][portEqn] = Complex(-1, 0);
+  ComplexMatrix &Y = scratchY;
+  buildAdmittanceMatrix(Y);
+  solvePortSystem(Y, portNodes, S);
+  return false;
+}
 
-      Complex Gp = Complex(1.0 / ports[p].impedance, 0);
-      augmentedY[portNode][portEqn] = Gp;
+void SParameterCalculator::setPortExcitation(int n,
+                                             const vector<int> &nodeOfPort) {
+  // Augmented nodal system: the node voltages are followed by one unknown
+  // per port, tied to its node voltage by the port equation v_p - b_p = 0.
+  // Column j of the right-hand side is the Norton excitation of port j, so
+  // all the ports are solved at once against a single factorization
+  int numPorts = ports.size();
+  ComplexMatrix &excitation = scratchExcitation;
+  excitation.resize(n + numPorts, numPorts);
+  for (int p = 0; p < numPorts; p++) {
+    excitation[nodeOfPort[p]][p] = Complex(2.0 / ports[p].impedance, 0);
+  }
+}
 
-      if (p == j) {
-        excitation[portNode] = Complex(2.0 / ports[p].impedance, 0);
+void SParameterCalculator::readPortSolution(int n, ComplexMatrix &S) {
+  int numPorts = ports.size();
+  S.resize(numPorts, numPorts);
+  for (int i = 0; i < numPorts; i++) {
+    const Complex *portVoltages = scratchExcitation[n + i];
+    for (int j = 0; j < numPorts; j++) {
+      if (i == j) {
+        S[i][j] = portVoltages[j] - Complex(1, 0);
+      } else {
+        S[i][j] = portVoltages[j];
       }
     }
+  }
+}
 
-    try {
-      vector<vector<Complex>> augmentedYinv = invertMatrix(augmentedY);
-      vector<Complex> solution(systemSize, Complex(0, 0));
+bool SParameterCalculator::solvePortSystem(const ComplexMatrix &Y,
+                                           const vector<int> &nodeOfPort,
+                                           ComplexMatrix &S) {
+  PROFILE_SCOPE("solvePortSystem");
+  int numPorts = ports.size();
+  int n = Y.rows();
+  int systemSize = n + numPorts;
+  setPortExcitation(n, nodeOfPort);
 
-      for (int i = 0; i < systemSize; i++) {
-        for (int k = 0; k < systemSize; k++) {
-          solution[i] += augmentedYinv[i][k] * excitation[k];
-        }
-      }
+  // The port conductance is kept off the node diagonal so that it is not
+  // absorbed by very large admittances connected to the port node
+  ComplexMatrix &augmentedY = scratchSystem;
+  augmentedY.resize(systemSize, systemSize);
 
-      for (int i = 0; i < numPorts; i++) {
-        Complex portVoltage = solution[numNodes + i];
-        if (i == j) {
-          S[i][j] = portVoltage - Complex(1, 0);
-        } else {
-          S[i][j] = portVoltage;
-        }
-      }
+  for (int i = 0; i < n; i++) {
+    std::copy(Y[i], Y[i] + n, augmentedY[i]);
+  }
 
-    } catch (const exception &e) {
-      cerr << "Error solving for port " << j + 1 << ": " << e.what() << endl;
-      throw;
-    }
+  for (int p = 0; p < numPorts; p++) {
+    int portNode = nodeOfPort[p];
+    int portEqn = n + p;
+
+    augmentedY[portEqn][portNode] = Complex(1, 0);
+    augmentedY[portEqn][portEqn] = Complex(-1, 0);
+    augmentedY[portNode][portEqn] = Complex(1.0 / ports[p].impedance, 0);
   }
 
-  return S;
+  // Factorize once per frequency and reuse the factors for every port
+  double ratio = luFactorize(augmentedY.view(), scratchPivots);
+  notePivotRatio(ratio);
+  if (!std::isfinite(ratio)) {
+    S.resize(numPorts, numPorts);
+    std::fill(S.data(), S.data() + S.size(), Complex(NAN, NAN));
+    return false;
+  }
+  luSolve(augmentedY.view(), scratchPivots, scratchExcitation.view());
+  readPortSolution(n, S);
+  return true;
 }
 
 void SParameterCalculator::setFrequencySweep(double start, double stop,
@@ -254,62 +356,258 @@ void SParameterCalculator::setFrequencySweep(double start, double stop,
   n_points = points;
 }
 
+void SParameterCalculator::swapWorkerlessState(SParameterCalculator &other) {
+  std::swap(components, other.components);
+  std::swap(currentNetlist, other.currentNetlist);
+  std::swap(sweepResults, other.sweepResults);
+  std::swap(sweepSensitivities, other.sweepSensitivities);
+  std::swap(sweepData, other.sweepData);
+  std::swap(scratchY, other.scratchY);
+  std::swap(scratchSystem, other.scratchSystem);
+  std::swap(scratchExcitation, other.scratchExcitation);
+  std::swap(scratchReducedY, other.scratchReducedY);
+}
+
+vector<SParameterCalculator> SParameterCalculator::createWorkers(int count) {
+  // The heavy state that the workers never read is set aside while this
+  // engine is copied. The compiled circuit is up to date, so the workers do
+  // not need the component list
+  SParameterCalculator aside;
+  swapWorkerlessState(aside);
+  vector<SParameterCalculator> engines;
+  try {
+    engines.assign(count, *this);
+  } catch (...) {
+    swapWorkerlessState(aside);
+    throw;
+  }
+  swapWorkerlessState(aside);
+  return engines;
+}
+
+void SParameterCalculator::solveSweepPoints(
+    const vector<int> &indices, vector<SParameterCalculator> &engines,
+    vector<string> &errors, double step, PointSolver solver) {
+  PROFILE_SCOPE("solveSweepPoints");
+  // Points are handed out one at a time and stored by index
+  int count = indices.size();
+  std::atomic<int> nextPoint(0);
+  auto runWorker = [&](SParameterCalculator &engine) {
+    for (int k = nextPoint++; k < count; k = nextPoint++) {
+      int i = indices[k];
+      engine.frequency = f_start + i * step;
+      engine.pivotCondition = 1.0;
+      // Singular systems do not throw. Only errors such as a port on a
+      // missing node get here
+      try {
+        if (engine.sensitivityAnalysis) {
+          engine.solveSensitivities(sweepResults[i], sweepSensitivities[i]);
+        } else if (solver == PointSolver::Record) {
+          engine.recordSweepPoint(factorCache->points[i], sweepResults[i]);
+        } else if (solver == PointSolver::Update) {
+          engine.updateSweepPoint(factorCache->points[i], *factorCache,
+                                  sweepResults[i]);
+        } else {
+          engine.solveSParameters(sweepResults[i]);
+        }
+      } catch (const std::exception &e) {
+        errors[i] = e.what();
+      }
+      sweepData.condition[i] = engine.pivotCondition;
+    }
+  };
+
+  if (engines.empty() || count < 2) {
+    runWorker(*this);
+  } else {
+    vector<std::thread> pool;
+    for (auto &engine : engines) {
+      pool.emplace_back(runWorker, std::ref(engine));
+    }
+    for (auto &worker : pool) {
+      worker.join();
+    }
+    frequency = f_start + indices.back() * step;
+  }
+}
+
 void SParameterCalculator::calculateSParameterSweep() {
   if (ports.empty()) {
     return;
   }
+  PROFILE_SCOPE("calculateSParameterSweep");
 
   sweepResults.clear();
-  data.clear();
+  sweepSensitivities.clear();
 
   int n_ports = ports.size();
-  double Z0 = ports.at(0).impedance;
-  data["n_ports"].append(n_ports);
-  data["Z0"].append(Z0);
+  sweepData.reset(n_ports);
+  sweepData.Z0 = ports.at(0).impedance;
 
   double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
 
+  ensureCircuitCompiled();
+
+  // Purely resistive networks (attenuators, ideal couplers, constant
+  // S-parameter blocks) have the same response at every point, so a single
+  // solve serves the whole sweep
+  bool singleSolve = circuit.isFrequencyIndependent() && n_points > 0;
+  bool adaptive = adaptiveSweep && !sensitivityAnalysis &&
+                  n_points > 2 * AdaptiveInitialSegments;
+
+  // Sweeps of the whole grid keep their factors, so that a later sweep that
+  // only edits a few component values can update them instead. Chains
+  // evaluated with ABCD matrices have no factors to keep
+  PointSolver solver = PointSolver::Full;
+  if (incrementalSweep && !singleSolve && !adaptive && !sensitivityAnalysis &&
+      !(cascadeFastPath && cascade.valid)) {
+    if (planSweepUpdate()) {
+      solver = PointSolver::Update;
+    } else if (allocateFactorCache()) {
+      solver = PointSolver::Record;
+    }
+  }
+  sweepUpdates = 0;
+
+  // The stamp functions read the analysis frequency from the engine, so each
+  // worker runs on its own copy
+  int numWorkers = std::min(getSweepThreads(), n_points);
+  vector<SParameterCalculator> engines;
+  if (numWorkers > 1 && !singleSolve) {
+    engines = createWorkers(numWorkers);
+  }
+
+  // All the output matrices are allocated up front, so the solve loop does not
+  // touch the heap once the scratch storage has grown to its final size
+  sweepResults.assign(n_points, ComplexMatrix(n_ports, n_ports));
+  sweepData.resize(n_points);
+  vector<string> errors(n_points);
+  int numParameters = circuit.parameters.size();
+  if (sensitivityAnalysis) {
+    sweepSensitivities.assign(
+        n_points,
+        vector<ComplexMatrix>(numParameters, ComplexMatrix(n_ports, n_ports)));
+  }
+
+  if (singleSolve) {
+    solveSweepPoints({0}, engines, errors, step);
+    for (int i = 1; i < n_points; ++i) {
+      sweepResults[i] = sweepResults[0];
+      errors[i] = errors[0];
+      sweepData.condition[i] = sweepData.condition[0];
+      if (sensitivityAnalysis) {
+        sweepSensitivities[i] = sweepSensitivities[0];
+      }
+    }
+    sweepSolves = 1;
+  } else if (adaptive) {
+    runAdaptiveSweep(engines, errors, step);
+  } else {
+    vector<int> indices(n_points);
+    for (int i = 0; i < n_points; ++i) {
+      indices[i] = i;
+    }
+    solveSweepPoints(indices, engines, errors, step, solver);
+    if (solver == PointSolver::Update) {
+      sweepSolves = 0;
+      sweepUpdates = n_points;
+    } else {
+      sweepSolves = n_points;
+    }
+  }
+
+  Profiler::count("sweep.points", n_points);
+  Profiler::count("sweep.solves", sweepSolves);
+
+  // The results are copied, point by point, into the columnar store
+  PROFILE_SCOPE("formatSweepResults");
+  const Complex failed(NAN, NAN);
+  bool clean = true;
   for (int i = 0; i < n_points; ++i) {
-    double freq = f_start + i * step;
-    frequency = freq;
-    data["frequency"].append(freq);
-
-    try {
-      auto S = calculateSParameters();
-      sweepResults.push_back(S);
-
-      for (int row = 1; row <= n_ports; ++row) {
-        for (int col = 1; col <= n_ports; ++col) {
-          // Get the S-parameter value (note: S matrix uses 0-based indexing)
-          Complex sParam = S[row - 1][col - 1];
-
-          // Extract real and imaginary parts
-          double re = sParam.real();
-          double im = sParam.imag();
-
-          // Calculate magnitude and convert to dB
-          double magnitude = sqrt(re * re + im * im);
-          double dB = 20.0 * log10(magnitude);
-
-          // Calculate phase angle in degrees
-          double ang = atan2(im, re) * 180.0 / M_PI;
-
-          QString keyDb = QString("S%1%2_dB").arg(row).arg(col);
-          QString keyAng = QString("S%1%2_ang").arg(row).arg(col);
-          QString keyRe = QString("S%1%2_re").arg(row).arg(col);
-          QString keyIm = QString("S%1%2_im").arg(row).arg(col);
-
-          data[keyDb].append(dB);
-          data[keyAng].append(ang);
-          data[keyRe].append(re);
-          data[keyIm].append(im);
-        }
+    sweepData.frequency[i] = f_start + i * step;
+
+    Complex *S = sweepData.matrix(i).data();
+    SolveStatus &status = sweepData.status[i];
+    double condition = sweepData.condition[i];
+    if (!errors[i].empty()) {
+      status = SolveStatus::Failed;
+      sweepResults[i].resize(n_ports, n_ports);
+    } else if (!std::isfinite(condition) ||
+               !isFiniteMatrix(sweepResults[i])) {
+      status = SolveStatus::Singular;
+    } else {
+      status = condition > NearSingularCondition ? SolveStatus::NearSingular
+                                                 : SolveStatus::Ok;
+      std::copy(sweepResults[i].data(),
+                sweepResults[i].data() + n_ports * n_ports, S);
+      clean = clean && status == SolveStatus::Ok;
+      continue;
+    }
+    std::fill(S, S + n_ports * n_ports, failed);
+    clean = false;
+  }
+
+  if (!clean) {
+    reportSweepStatus(errors);
+  }
+}
+
+void SParameterCalculator::reportSweepStatus(
+    const vector<string> &errors) const {
+  // Number of distinct error messages that are printed
+  const int MaxReportedErrors = 3;
+
+  int points = sweepData.size();
+  int singular = 0, nearSingular = 0;
+  int firstSingular = -1, firstNearSingular = -1;
+  double worstCondition = 0;
+  // Failed points, grouped by message: count and first point
+  std::map<string, pair<int, int>> failures;
+  for (int i = 0; i < points; ++i) {
+    switch (sweepData.status[i]) {
+    case SolveStatus::Ok:
+      break;
+    case SolveStatus::NearSingular:
+      if (nearSingular++ == 0) {
+        firstNearSingular = i;
+      }
+      worstCondition = std::max(worstCondition, sweepData.condition[i]);
+      break;
+    case SolveStatus::Singular:
+      if (singular++ == 0) {
+        firstSingular = i;
       }
-    } catch (const std::exception &e) {
-      std::cerr << "Error at frequency " << freq << " Hz: " << e.what()
-                << std::endl;
-      sweepResults.push_back(std::vector<std::vector<Complex>>(
-          ports.size(), std::vector<Complex>(ports.size(), Complex(0, 0))));
+      break;
+    case SolveStatus::Failed: {
+      auto &failure = failures.emplace(errors[i], make_pair(0, i)).first->second;
+      failure.first++;
+      break;
+    }
+    }
+  }
+
+  if (singular > 0) {
+    cerr << "Warning: the circuit is singular at " << singular << " of "
+         << points << " frequency points (first at "
+         << sweepData.frequency[firstSingular]
+         << " Hz). Their S-parameters are left undefined" << endl;
+  }
+  if (nearSingular > 0) {
+    cerr << "Warning: the circuit is ill-conditioned at " << nearSingular
+         << " of " << points << " frequency points (first at "
+         << sweepData.frequency[firstNearSingular]
+         << " Hz, condition estimate up to " << worstCondition << ")" << endl;
+  }
+  int reported = 0;
+  for (const auto &failure : failures) {
+    if (reported++ == MaxReportedErrors) {
+      cerr << "Error: " << failures.size() - MaxReportedErrors
+           << " more error messages" << endl;
+      break;
     }
+    cerr << "Error at " << failure.second.first << " of " << points
+         << " frequency points (first at "
+         << sweepData.frequency[failure.second.second]
+         << " Hz): " << failure.first << endl;
   }
 }
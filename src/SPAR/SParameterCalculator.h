@@ -16,17 +16,24 @@
 #include <QStringList>
 #include <QTextStream>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <complex>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 #include <utility> // std::as_const()
 
+#include "ComplexMatrix.h"
+#include "SParSweep.h"
+#include "SparseLU.h"
+#include "StampTarget.h"
 #include "Misc/general.h"
 
 using namespace std;
@@ -65,14 +72,17 @@ struct Component_SPAR {
   double frequency;                  ///< Operating frequency for frequency-dependent components
   QMap<QString, double> value;       ///< Real-valued parameters (R, L, C, etc.)
   QMap<QString, Complex> Zvalue;     ///< Complex impedance values
-  vector<vector<Complex>> Smatrix;   ///< S-parameter matrix for network blocks
+  ComplexMatrix Smatrix;             ///< S-parameter matrix for network blocks
   QMap<QString, QList<double>> freqDepData; ///< Frequency-dependent data tables
   int numRFPorts;                    ///< Number of RF ports for network blocks
   double referenceImpedance;         ///< Reference impedance (typically 50Ω)
+  QMap<QString, int> netlistField;   ///< Netlist field of each value (the
+                                     ///< name is field 0). Empty if the
+                                     ///< component was not read from a netlist
 
   /// @brief Constructor for S-parameter network block with matrix
   Component_SPAR(ComponentType_SPAR t, const string& n, const vector<int>& nds,
-                 const vector<vector<Complex>>& S, int rfPorts,
+                 const ComplexMatrix& S, int rfPorts,
                  double Z0 = 50.0)
       : type(t), name(n), nodes(nds), frequency(0.0),
         Smatrix(S), numRFPorts(rfPorts), referenceImpedance(Z0) {}
@@ -96,7 +106,7 @@ struct Component_SPAR {
 
   /// @brief Constructor for S-parameter device without port count
   Component_SPAR(ComponentType_SPAR t, const string& n, const vector<int>& nds,
-                 const vector<vector<Complex>>& S)
+                 const ComplexMatrix& S)
       : type(t), name(n), nodes(nds), frequency(0.0), Smatrix(S) {}
 
   /// @brief Constructor for frequency-dependent impedance
@@ -117,6 +127,393 @@ struct Port {
   Port(int n, double z = 50.0) : node(n), impedance(z) {}
 };
 
+// Compiled circuit
+// The netlist is lowered once into typed parameter structs, grouped by
+// component type, so that the frequency sweep does not need any map lookup.
+// Node numbers follow the netlist convention (0 is ground).
+
+/// @struct CompiledLumped
+/// @brief Two-terminal lumped element (R, L, C or fixed complex impedance)
+struct CompiledLumped {
+  ComponentType_SPAR type; ///< RESISTOR, CAPACITOR, INDUCTOR or COMPLEX_IMPEDANCE.
+                           ///< Other types have zero impedance
+  int node1;               ///< First terminal
+  int node2;               ///< Second terminal
+  double value;            ///< R (Ω), C (F) or L (H)
+  Complex Z;               ///< Impedance of COMPLEX_IMPEDANCE elements (Ω)
+};
+
+/// @struct CompiledStub
+/// @brief Ideal open or short-circuited stub
+struct CompiledStub {
+  ComponentType_SPAR type; ///< OPEN_STUB or SHORT_STUB
+  int node1;               ///< First terminal
+  int node2;               ///< Second terminal
+  double Z0;               ///< Characteristic impedance (Ω)
+  double length;           ///< Physical length (m)
+};
+
+/// @struct CompiledTransmissionLine
+/// @brief Ideal lossless transmission line (TLIN)
+struct CompiledTransmissionLine {
+  int node1;     ///< Port 1
+  int node2;     ///< Port 2
+  double Z0;     ///< Characteristic impedance (Ω)
+  double length; ///< Physical length (m)
+};
+
+/// @struct CompiledCoupledLine
+/// @brief Ideal coupled transmission lines (CLIN)
+struct CompiledCoupledLine {
+  int nodes[4];  ///< Port nodes
+  double Z0e;    ///< Even-mode impedance (Ω)
+  double Z0o;    ///< Odd-mode impedance (Ω)
+  double length; ///< Physical length (m)
+};
+
+/// @struct CompiledIdealCoupler
+/// @brief Ideal directional coupler
+/// @details The Y-matrix does not depend on frequency, so it is computed when
+/// the circuit is compiled
+struct CompiledIdealCoupler {
+  int nodes[4];     ///< Port nodes
+  double k;         ///< Linear coupling coefficient
+  double phase_deg; ///< Phase of the coupled port (degrees)
+  double Z0;        ///< Reference impedance (Ω)
+  ComplexMatrix4 Y; ///< Y-parameters of the coupler
+};
+
+/// @struct CompiledSParamBlock
+/// @brief Frequency-independent 1-port or 2-port S-parameter block
+/// @details Y holds the Y-parameters of the block, computed when the circuit
+/// is compiled. One-port blocks only use Y[0][0]
+struct CompiledSParamBlock {
+  int node1;        ///< First node
+  int node2;        ///< Second node
+  int numRFPorts;   ///< 1 or 2
+  double Z0;        ///< Reference impedance (Ω)
+  ComplexMatrix2 Y; ///< Y-parameters of the block
+};
+
+/// @struct CompiledFrequencyDependentBlock
+/// @brief 1-port or 2-port S-parameter block loaded from a Touchstone file
+struct CompiledFrequencyDependentBlock {
+  int node1;                  ///< First node
+  int node2;                  ///< Second node
+  int numRFPorts;             ///< 1 or 2
+  double Z0;                  ///< Reference impedance (Ω)
+  vector<double> frequencies; ///< Tabulated frequencies (Hz)
+  vector<ComplexMatrix2> S;   ///< S-matrix at each tabulated frequency
+};
+
+/// @struct MicrostripStatics
+/// @brief Frequency-independent part of a microstrip propagation mode
+/// @details Computed once per geometry by compileCircuit(). Only the
+/// dispersion is evaluated at each frequency.
+struct MicrostripStatics {
+  double ZlEff;          ///< Quasi-static characteristic impedance (Ω)
+  double ErEff;          ///< Quasi-static effective permittivity
+  double conductorLoss;  ///< Conductor attenuation at 1 Hz (scales as √f)
+  double dielectricLoss; ///< Dielectric attenuation at 1 Hz (scales as f)
+};
+
+/// @struct CompiledMicrostripLine
+/// @brief Microstrip line (MLIN)
+struct CompiledMicrostripLine {
+  int node1;   ///< Port 1
+  int node2;   ///< Port 2
+  double W;    ///< Width (m)
+  double L;    ///< Length (m)
+  double h;    ///< Substrate height (m)
+  double er;   ///< Relative permittivity
+  double t;    ///< Metal thickness (m)
+  double tand; ///< Loss tangent
+  double rho;  ///< Metal resistivity (Ω·m)
+  MicrostripStatics statics; ///< Quasi-static model of the line
+};
+
+/// @struct CompiledMicrostripCoupledLines
+/// @brief Microstrip coupled lines (MSCOUP)
+struct CompiledMicrostripCoupledLines {
+  int nodes[4]; ///< Port nodes
+  double W;     ///< Width of each line (m)
+  double S;     ///< Spacing between the lines (m)
+  double L;     ///< Length (m)
+  double h;     ///< Substrate height (m)
+  double er;    ///< Relative permittivity
+  double t;     ///< Metal thickness (m)
+  double tand;  ///< Loss tangent
+  double rho;   ///< Metal resistivity (Ω·m)
+  MicrostripStatics even; ///< Quasi-static model of the even mode
+  MicrostripStatics odd;  ///< Quasi-static model of the odd mode
+};
+
+/// @struct CompiledMicrostripStep
+/// @brief Microstrip width step (MSTEP)
+struct CompiledMicrostripStep {
+  int node1; ///< Port 1
+  int node2; ///< Port 2
+  double W1; ///< Width of the first section (m)
+  double W2; ///< Width of the second section (m)
+  double h;  ///< Substrate height (m)
+  double er; ///< Relative permittivity
+  double t;  ///< Metal thickness (m)
+};
+
+/// @struct CompiledMicrostripOpen
+/// @brief Microstrip open end (MSOPEN)
+struct CompiledMicrostripOpen {
+  int node1; ///< Node of the open end
+  double W;  ///< Width (m)
+  double h;  ///< Substrate height (m)
+  double er; ///< Relative permittivity
+  double t;  ///< Metal thickness (m)
+};
+
+/// @struct CompiledMicrostripVia
+/// @brief Microstrip via hole to ground (MSVIA)
+struct CompiledMicrostripVia {
+  int node1;  ///< Node of the via
+  int N;      ///< Number of vias in parallel
+  double D;   ///< Diameter (m)
+  double h;   ///< Substrate height (m)
+  double t;   ///< Metal thickness (m)
+  double rho; ///< Metal resistivity (Ω·m)
+};
+
+/// @struct SensitivityParameter
+/// @brief Component value the S-parameters can be differentiated against
+struct SensitivityParameter {
+  enum Kind {
+    Resistance,
+    Capacitance,
+    Inductance,
+    StubImpedance,
+    StubLength,
+    LineImpedance,
+    LineLength,
+    MicrostripWidth,
+    MicrostripLength,
+    CoupledMicrostripWidth,
+    CoupledMicrostripLength
+  };
+  string component; ///< Component name
+  string name;      ///< Parameter name, as in the netlist
+  Kind kind;        ///< Parameter and component array
+  int index;        ///< Component index in its CompiledCircuit array
+  double value;     ///< Nominal value (SI units)
+  int field = -1;   ///< Netlist field of the value (the name is field 0). -1
+                    ///< if the component was not read from a netlist
+};
+
+/// @struct Tolerance
+/// @brief Statistical distribution of a component value
+struct Tolerance {
+  enum Distribution { Uniform, Gaussian };
+  Distribution distribution = Uniform;
+  double relative = 0.0; ///< Relative tolerance (0.05: ±5%). For the gaussian
+                         ///< distribution it is the 3σ bound. Samples beyond
+                         ///< it are drawn again
+};
+
+/// @struct SpecificationLimit
+/// @brief Limit line on the magnitude of an S-parameter
+/// @details Same geometry as the limit lines of the rectangular chart: a
+/// straight segment from (f1, y1) to (f2, y2)
+struct SpecificationLimit {
+  int row;    ///< S-parameter row (0-based)
+  int col;    ///< S-parameter column (0-based)
+  double f1;  ///< Start frequency (Hz)
+  double f2;  ///< End frequency (Hz)
+  double y1;  ///< Limit at f1 (dB)
+  double y2;  ///< Limit at f2 (dB)
+  bool upper; ///< true: |Sij| must stay below the line, false: above it
+  double weight = 1.0; ///< Weight of the violations in the optimizer cost
+
+  /// @brief Value of the line at a frequency
+  /// @param freq Frequency (Hz)
+  /// @param[out] y Limit (dB)
+  /// @return false if the frequency is outside the line
+  bool valueAt(double freq, double& y) const {
+    if (freq < std::min(f1, f2) || freq > std::max(f1, f2)) {
+      return false;
+    }
+    y = (f2 == f1) ? y1 : y1 + (y2 - y1) * (freq - f1) / (f2 - f1);
+    return true;
+  }
+};
+
+/// @struct OptimizationVariable
+/// @brief Component value tuned by the optimizer
+struct OptimizationVariable {
+  string component;     ///< Component name
+  string parameter;     ///< Parameter name (see SensitivityParameter)
+  double minimum = 0.0; ///< Lower bound (0: none, the value stays positive)
+  double maximum = 0.0; ///< Upper bound (0: none)
+};
+
+/// @struct OptimizationResult
+/// @brief Outcome of an optimization
+struct OptimizationResult {
+  bool converged = false;   ///< All goals met or no further progress possible
+  int iterations = 0;       ///< Quasi-Newton iterations
+  int evaluations = 0;      ///< Cost and gradient evaluations
+  double initialCost = 0.0; ///< Weighted violation before the optimization
+  double finalCost = 0.0;   ///< Weighted violation after it (0: goals met)
+  bool aborted = false;     ///< Stopped by AnalysisControl::abort
+  /// The variables, with their optimized value in SensitivityParameter::value
+  vector<SensitivityParameter> variables;
+  QString netlist; ///< Netlist with the optimized values written back
+};
+
+/// @struct MonteCarloResult
+/// @brief Outcome of a Monte Carlo tolerance analysis
+struct MonteCarloResult {
+  int trials = 0;     ///< Number of trials
+  int passed = 0;     ///< Trials that met all the limits
+  double yield = 0.0; ///< passed / trials
+  bool aborted = false; ///< Stopped by AnalysisControl::abort (no results)
+  /// "frequency" and the envelopes of the trials: Sij_dB_min, Sij_dB_median
+  /// and Sij_dB_max
+  QMap<QString, QList<double>> data;
+};
+
+/// @struct AnalysisControl
+/// @brief Lets another thread follow a long analysis and stop it
+struct AnalysisControl {
+  std::atomic<bool> abort{false}; ///< Set to stop the analysis
+  std::atomic<int> done{0};       ///< Steps finished so far
+  std::atomic<int> total{0};      ///< Steps of the analysis (0: not known yet)
+};
+
+/// @struct CompiledCircuit
+/// @brief Typed component arrays iterated by the frequency sweep
+struct CompiledCircuit {
+  vector<CompiledLumped> fixedLumped;    ///< R, Z and zero-impedance elements
+  vector<CompiledLumped> reactiveLumped; ///< Capacitors and inductors
+  vector<CompiledStub> stubs;
+  vector<CompiledTransmissionLine> transmissionLines;
+  vector<CompiledCoupledLine> coupledLines;
+  vector<CompiledIdealCoupler> idealCouplers;
+  vector<CompiledSParamBlock> sparBlocks;
+  vector<CompiledFrequencyDependentBlock> frequencyDependentBlocks;
+  vector<CompiledMicrostripLine> microstripLines;
+  vector<CompiledMicrostripCoupledLines> microstripCoupledLines;
+  vector<CompiledMicrostripVia> microstripVias;
+  vector<SensitivityParameter> parameters; ///< Differentiable values
+
+  /// @brief Removes all the compiled components
+  void clear() {
+    fixedLumped.clear();
+    reactiveLumped.clear();
+    stubs.clear();
+    transmissionLines.clear();
+    coupledLines.clear();
+    idealCouplers.clear();
+    sparBlocks.clear();
+    frequencyDependentBlocks.clear();
+    microstripLines.clear();
+    microstripCoupledLines.clear();
+    microstripVias.clear();
+    parameters.clear();
+  }
+
+  /// @brief Checks whether the circuit response is the same at every frequency
+  /// @return true if the circuit only contains fixed impedances, ideal
+  /// couplers and constant S-parameter blocks
+  bool isFrequencyIndependent() const {
+    return reactiveLumped.empty() && stubs.empty() &&
+           transmissionLines.empty() && coupledLines.empty() &&
+           frequencyDependentBlocks.empty() && microstripLines.empty() &&
+           microstripCoupledLines.empty() && microstripVias.empty();
+  }
+};
+
+/// @enum CascadeSource
+/// @brief Component array of CompiledCircuit referenced by a cascade element
+enum class CascadeSource {
+  FixedLumped,
+  ReactiveLumped,
+  Stub,
+  MicrostripVia,
+  SParamBlock,
+  FrequencyDependentBlock,
+  TransmissionLine,
+  MicrostripLine
+};
+
+/// @struct CascadeBranch
+/// @brief Two-terminal branch of a cascade: a component or the series or
+/// parallel combination of two earlier branches
+struct CascadeBranch {
+  enum Operation { Element, Series, Parallel };
+  Operation op;         ///< How the branch is formed
+  CascadeSource source; ///< Component array (Element only)
+  int index;            ///< Component index (Element only)
+  int first;            ///< First combined branch (Series/Parallel only)
+  int second;           ///< Second combined branch (Series/Parallel only)
+};
+
+/// @struct CascadeStage
+/// @brief One 2x2 ABCD factor of a two-port chain
+struct CascadeStage {
+  enum Kind { SeriesBranch, ShuntBranch, TwoPort };
+  Kind kind;
+  int branch;           ///< Branch index (SeriesBranch/ShuntBranch)
+  CascadeSource source; ///< Component array (TwoPort)
+  int index;            ///< Component index (TwoPort)
+  bool reversed;        ///< TwoPort traversed from its node2 to its node1
+};
+
+/// @struct CompiledCascade
+/// @brief Two-port chain equivalent of the circuit, if it has one
+/// @details Built by compileCircuit() when the circuit is a ladder of series
+/// and shunt branches and two-port sections between two ports. The stages are
+/// ordered from port 1 to port 2.
+struct CompiledCascade {
+  bool valid = false;
+  vector<CascadeBranch> branches;
+  vector<CascadeStage> stages;
+
+  void clear() {
+    valid = false;
+    branches.clear();
+    stages.clear();
+  }
+};
+
+/// @struct SweepFactorization
+/// @brief Factors of the augmented nodal system at one sweep point
+struct SweepFactorization {
+  bool solved = false;    ///< false if the point could not be solved
+  bool sparse = false;    ///< The factors are in sparseFactors
+  ComplexMatrix dense;    ///< Dense factors (see luFactorize())
+  vector<int> pivots;     ///< Row interchanges of the dense factors
+  SparseLU sparseFactors; ///< Sparse factors
+  ComplexMatrix solution; ///< Solution for the port excitations
+};
+
+/// @struct SweepFactorCache
+/// @brief Factorizations kept from a full sweep
+/// @details A later sweep of the same grid and topology that only changes a
+/// few component values updates these solutions instead of solving the
+/// circuit again. The cache holds the circuit it was built for, so it does
+/// not depend on the current state of the engine.
+struct SweepFactorCache {
+  double f_start = 0.0;                   ///< Grid of the factorizations
+  double f_stop = 0.0;
+  int n_points = 0;
+  int numNodes = 0;
+  vector<Component_SPAR> components;      ///< Circuit of the factorizations
+  vector<Port> ports;
+  CompiledCircuit circuit;
+  vector<SweepFactorization> points;      ///< Factors of each grid point
+
+  // Update planned by the current sweep
+  vector<int> changed; ///< One changed parameter per edited component
+  vector<int> nodes;   ///< Nodes of the edited components (1-based)
+};
+
 /// @class SParameterCalculator
 /// @brief Calculates S-parameters using nodal analysis
 ///
@@ -130,6 +527,9 @@ class SParameterCalculator {
 private:
   vector<Component_SPAR> components;  ///< Circuit component list
   vector<Port> ports;                 ///< Port definitions
+  CompiledCircuit circuit;            ///< Typed components used by the solver
+  bool circuitCompiled = false;       ///< circuit is up to date with components
+  CompiledCascade cascade;            ///< ABCD chain form of the circuit
   int numNodes;                       ///< Total number of circuit nodes
   double frequency;                   ///< Current analysis frequency
   QString currentNetlist;             ///< Stored netlist string
@@ -140,32 +540,441 @@ private:
   /// @param rows Number of rows
   /// @param cols Number of columns
   /// @return Complex matrix with size (rows x cols)
-  vector<vector<Complex>> createMatrix(int rows, int cols) {
-    return vector<vector<Complex>>(rows, vector<Complex>(cols, Complex(0, 0)));
+  ComplexMatrix createMatrix(int rows, int cols) {
+    return ComplexMatrix(rows, cols);
   }
 
   /// @brief Inverts a complex square matrix using Gaussian elimination
   /// @param matrix Input square matrix to be inverted
-  /// @return Inverse matrix (matrix^-1)
+  /// @return Inverse matrix (matrix^-1). NaN if the matrix is singular
   /// @details Uses LU decomposition with row pivoting for numerical stability.
-  ///          Required for solving the augmented nodal equations in S-parameter extraction.
-  vector<vector<Complex>> invertMatrix(const vector<vector<Complex>>& matrix);
+  ///          Only used for the small S-to-Y conversions of the network
+  ///          blocks. The nodal equations are solved with luFactorize()/luSolve().
+  ///          The pivots are added to the status of the current point (see
+  ///          notePivotRatio())
+  ComplexMatrix invertMatrix(const ComplexMatrix& matrix);
+
+  /// @brief Factorizes a complex square matrix in place (PA = LU)
+  /// @param[in,out] A Matrix to factorize. On return it holds the unit lower
+  /// triangular factor L below the diagonal and the upper factor U on and
+  /// above it
+  /// @param[out] pivots Row interchange performed at each elimination step
+  /// @return Condition estimate: largest ratio between the magnitude of a row
+  /// before the elimination and its pivot, i.e. how much the elimination
+  /// cancelled. Infinite if the matrix is singular, in which case the
+  /// factorization is left incomplete
+  /// @details Gaussian elimination with partial (row) pivoting. The factors
+  /// can be reused to solve any number of right-hand sides with luSolve().
+  double luFactorize(ComplexMatrixView A, vector<int>& pivots);
+
+  /// @brief Solves A·X = B using the factors computed by luFactorize()
+  /// @param LU Factorized matrix returned by luFactorize()
+  /// @param pivots Row interchanges returned by luFactorize()
+  /// @param[in,out] B Right-hand side matrix (n x m). Overwritten with X
+  void luSolve(ConstComplexMatrixView LU, const vector<int>& pivots,
+               ComplexMatrixView B);
+
+  /// @brief Solves A^T·X = B using the factors computed by luFactorize()
+  /// @param LU Factorized matrix returned by luFactorize()
+  /// @param pivots Row interchanges returned by luFactorize()
+  /// @param[in,out] B Right-hand side matrix (n x m). Overwritten with X
+  void luSolveTransposed(ConstComplexMatrixView LU, const vector<int>& pivots,
+                         ComplexMatrixView B);
+
+  /// @brief Eliminates the leading unknowns of a square system in place
+  /// @param[in,out] A Matrix (n x n). On return its trailing (n-k) x (n-k)
+  /// block holds the Schur complement A22 - A21·A11^-1·A12
+  /// @param k Number of leading unknowns to eliminate
+  /// @return Condition estimate, as in luFactorize(). Infinite if the leading
+  /// block is singular
+  /// @details Gaussian elimination with row pivoting restricted to the first k
+  /// rows, so the trailing rows keep their meaning
+  double schurComplement(ComplexMatrixView A, int k);
+
+  /// @brief Magnitude of the leading rows of a matrix, for the condition
+  /// estimate of luFactorize() and schurComplement()
+  /// @param A Matrix
+  /// @param rows Number of leading rows
+  /// @param[out] scales Largest entry of each row
+  static void rowScales(ConstComplexMatrixView A, int rows,
+                        vector<double>& scales);
+
+  // Scratch storage reused across frequency points
+  ComplexMatrix scratchY;          ///< Nodal admittance matrix
+  ComplexMatrix scratchSystem;     ///< Augmented nodal system
+  ComplexMatrix scratchExcitation; ///< Port excitations / nodal solutions
+  vector<int> scratchPivots;       ///< Row interchanges of the LU factors
+  vector<double> scratchRowScales; ///< Row magnitudes for the condition estimate
+
+  /// Frequency-independent part of the nodal admittance matrix. Built by
+  /// compileCircuit() and copied at the start of every frequency point
+  /// solved with the dense LU
+  ComplexMatrix fixedY;
+
+  // Port node maps, set by compileCircuit()
+  vector<int> portNodes;        ///< Node (0-based) of each port
+  vector<int> reducedPortNodes; ///< Row of each port in the reduced Y-matrix
+  vector<int> kronOrder;        ///< Internal nodes followed by the port nodes
+  int numInternalNodes = 0;     ///< Number of nodes without a port
+  ComplexMatrix scratchReducedY; ///< Port-level Y-matrix (Kron reduction)
+
+  // Sparse solver. Analysed by compileCircuit() for large circuits
+  SparseLU sparseLU;                 ///< Ordering, pattern and factors
+  vector<Complex> sparseFixedValues; ///< fixedY in the sparseLU storage
+  vector<int> sparsePortSlots;       ///< Slots of the port equation entries
+
+  /// @brief Lowers the component list into the typed arrays of circuit
+  /// @details Parameters are looked up once here, so that the frequency sweep
+  /// works on plain structs. Frequency-independent data, such as the Y-matrix
+  /// of S-parameter blocks and ideal couplers, is also computed here and
+  /// stamped into fixedY.
+  void compileCircuit();
+
+  /// @brief Computes the sparse ordering and factor pattern of the augmented
+  /// nodal system from the compiled topology
+  /// @details Every element couples all its nodes, so the pattern is the
+  /// union of those cliques plus the port equations. The port equations are
+  /// ordered last, so the port conductances do not get folded into the node
+  /// diagonals before the nodes are eliminated
+  void analyzeSparsePattern();
+
+  /// @brief Eliminates the internal nodes of the nodal admittance matrix
+  /// (Kron reduction)
+  /// @param Y Nodal admittance matrix (numNodes x numNodes)
+  /// @param[out] reducedY Admittance matrix seen from the port nodes. Row i
+  /// corresponds to the node of the ports with reducedPortNodes == i
+  /// @return false (and a NaN reducedY) if the internal nodes are singular
+  bool reduceToPortNodes(const ComplexMatrix& Y, ComplexMatrix& reducedY);
+
+  /// @brief Terminates the ports and solves for the S-parameters with the
+  /// dense LU factors
+  /// @param Y Admittance matrix, either the full nodal matrix or the reduced
+  /// one
+  /// @param nodeOfPort Row of Y where each port is connected
+  /// @param[out] S S-parameter matrix. Resized to the number of ports. NaN if
+  /// the system is singular
+  /// @return false if the system is singular. Otherwise the factors are left
+  /// in scratchSystem/scratchPivots and the solution in scratchExcitation
+  bool solvePortSystem(const ComplexMatrix& Y, const vector<int>& nodeOfPort,
+                       ComplexMatrix& S);
+
+  /// @brief Solves the full augmented nodal system at the current frequency
+  /// @param[out] S S-parameter matrix. Resized to the number of ports. NaN if
+  /// the system is singular
+  /// @return true if the system was solved with the factors in sparseLU,
+  /// false if the dense factors in scratchSystem/scratchPivots were used
+  /// @details Analysed circuits are stamped straight into sparseLU, without
+  /// a dense Y-matrix. scratchY is only assembled for the dense solver, for
+  /// small circuits or when the sparse pivots are unstable
+  bool solveNodalSystem(ComplexMatrix& S);
+
+  /// @brief Sets scratchExcitation to the Norton excitation of the ports
+  /// @param n Size of the admittance matrix of the system
+  /// @param nodeOfPort Row of the admittance matrix of each port
+  void setPortExcitation(int n, const vector<int>& nodeOfPort);
+
+  /// @brief Reads the S-parameters from the solution in scratchExcitation
+  /// @param n Size of the admittance matrix of the system
+  /// @param[out] S S-parameter matrix. Resized to the number of ports
+  void readPortSolution(int n, ComplexMatrix& S);
+
+  /// How solveSweepPoints() solves each point
+  enum class PointSolver {
+    Full,   ///< Solve from scratch
+    Record, ///< Solve from scratch and keep the factors in factorCache
+    Update  ///< Update the factors in factorCache with the edited values
+  };
+
+  /// @brief Creates the per-worker copies of the engine used by the parallel
+  /// loops (sweep, Monte Carlo and optimizer)
+  /// @param count Number of workers
+  /// @return Copies that share the compiled circuit and the solver state of
+  /// this engine. They have no component list, netlist, results or scratch
+  /// storage, so each one only takes the memory the solver needs
+  vector<SParameterCalculator> createWorkers(int count);
+
+  /// @brief Exchanges the state the workers do not need (see
+  /// createWorkers()) with another engine
+  void swapWorkerlessState(SParameterCalculator& other);
+
+  /// @brief Solves the given points of the sweep grid
+  /// @param indices Grid indices to solve
+  /// @param engines Per-worker copies of the engine (empty: serial)
+  /// @param[out] errors Error message of each grid point (empty if solved).
+  /// Singular systems are not errors: their condition estimate is stored in
+  /// sweepData.condition
+  /// @param step Frequency step of the grid (Hz)
+  /// @param solver How the points are solved
+  void solveSweepPoints(const vector<int>& indices,
+                        vector<SParameterCalculator>& engines,
+                        vector<string>& errors, double step,
+                        PointSolver solver = PointSolver::Full);
+
+  /// Condition estimate above which a solved point is reported as
+  /// SolveStatus::NearSingular: fewer than two significant digits of the
+  /// pivots survive the elimination. Shorts and ideal elements routinely
+  /// stamp admittances around 1e12 S, which must not trip it
+  static constexpr double NearSingularCondition = 1e14;
+
+  /// Worst condition estimate of the factorizations of the point being
+  /// solved. It is reset by solveSweepPoints() before each point
+  double pivotCondition = 1.0;
+
+  /// @brief Adds a factorization to the condition estimate of the current
+  /// point (pivotCondition)
+  /// @param ratio Condition estimate returned by the factorization
+  void notePivotRatio(double ratio) {
+    pivotCondition =
+        std::isnan(ratio) ? INFINITY : std::max(pivotCondition, ratio);
+  }
+
+  /// @brief Prints a summary of the points of the last sweep that are
+  /// singular, ill-conditioned or failed
+  /// @param errors Error message of each failed point (empty if solved)
+  /// @details The points are aggregated, so that a sweep through a resonance
+  /// does not print one line per point
+  void reportSweepStatus(const vector<string>& errors) const;
+
+  /// Largest number of nodes touched by the edited components for which the
+  /// sweep is updated from factorCache
+  static constexpr int MaxUpdateNodes = 8;
+
+  /// Memory the factorizations of a sweep may take (bytes)
+  static constexpr double FactorCacheBudget = 256.0 * 1024 * 1024;
+
+  /// Factorizations of the last full sweep. Shared with the worker copies
+  std::shared_ptr<SweepFactorCache> factorCache;
+
+  /// @brief Checks whether the sweep can be updated from factorCache
+  /// @return true if the grid and the topology are those of the cache and
+  /// the edited components touch few enough nodes. The update is then
+  /// planned in factorCache->changed and factorCache->nodes
+  bool planSweepUpdate();
+
+  /// @brief Allocates factorCache for a full sweep of the current circuit
+  /// @return false (and no cache) if the factors would exceed
+  /// FactorCacheBudget
+  bool allocateFactorCache();
+
+  /// @brief Checks whether the circuit only differs from the one of the
+  /// cache in the values of circuit.parameters
+  bool sameTopology(const SweepFactorCache& cache) const;
+
+  /// @brief Solves the nodal system at the current frequency and keeps its
+  /// factors
+  /// @param[out] point Factors and solution
+  /// @param[out] S S-parameter matrix
+  void recordSweepPoint(SweepFactorization& point, ComplexMatrix& S);
+
+  /// @brief Calculates the S-parameters at the current frequency from the
+  /// factors of the cache (Sherman-Morrison-Woodbury update)
+  /// @param point Factors and solution of the cached circuit
+  /// @param cache Cache with the planned update
+  /// @param[out] S S-parameter matrix
+  /// @details The edited components change the nodal matrix A by a k x k
+  /// block D over their k nodes. With G = A^-1·P, where P selects those
+  /// nodes, the port unknowns of the new circuit are
+  /// X - G·(I + D·P^T·G)^-1·D·P^T·X, so each point takes k solves with the
+  /// cached factors instead of a new factorization
+  void updateSweepPoint(SweepFactorization& point,
+                        const SweepFactorCache& cache, ComplexMatrix& S);
+
+  /// @brief Stamps the component that owns a parameter at the current
+  /// frequency
+  /// @param parameter Component parameter
+  /// @param source Compiled circuit the component is taken from
+  /// @param[out] nodes Nodes of the component (0: ground)
+  /// @param[out] Y Local stamp (count x count). Not computed if nullptr
+  /// @return Number of nodes of the component (count)
+  int elementStamp(const SensitivityParameter& parameter,
+                   const CompiledCircuit& source, int nodes[4],
+                   ComplexMatrix* Y);
+
+  ComplexMatrix scratchUpdateY;      ///< Change of the nodal matrix (D)
+  ComplexMatrix scratchUpdateSolve;  ///< A^-1·P (G)
+  ComplexMatrix scratchUpdateSystem; ///< I + D·P^T·G
+  ComplexMatrix scratchUpdateRhs;    ///< D·P^T·X
+
+  /// Number of segments of the first pass of the adaptive sweep
+  static constexpr int AdaptiveInitialSegments = 32;
+
+  /// Number of solved points used by each local rational model
+  static constexpr int AdaptiveModelPoints = 7;
+
+  /// @brief Fills sweepResults by adaptive refinement of the sweep grid
+  /// @details The grid is first solved at AdaptiveInitialSegments + 1 points.
+  /// Each interval between solved points is then tested at its midpoint: the
+  /// point is predicted by a rational model of its neighbours and solved. If
+  /// the two disagree, both halves are tested again. The points that are
+  /// never solved are interpolated with the same models
+  void runAdaptiveSweep(vector<SParameterCalculator>& engines,
+                        vector<string>& errors, double step);
+
+  /// @brief Interpolates the S-matrix at a grid point from solved points
+  /// @param target Grid index to interpolate
+  /// @param support Solved grid indices, sorted
+  /// @param[out] S Interpolated S-parameter matrix
+  /// @details Barycentric rational interpolant with a common denominator for
+  /// all the S-parameters, so resonances shared by all of them are modelled
+  /// by the same poles. The weights come from the smallest singular vector of
+  /// the Loewner matrix (as in the AAA algorithm). If the model has a pole
+  /// at the target, Berrut's pole-free interpolant is used instead
+  void interpolateSweepPoint(int target, const vector<int>& support,
+                             ComplexMatrix& S);
+
+  /// @brief Looks for a two-port chain structure in the compiled circuit
+  /// @details Parallel branches and branches in series through internal nodes
+  /// are merged until only the chain remains. cascade.valid is left false if
+  /// the circuit is not a chain between its two ports
+  void analyzeCascade();
+
+  /// @brief Calculates the S-parameters of a two-port chain at the current
+  /// frequency by multiplying the ABCD matrices of its stages
+  /// @param[out] S S-parameter matrix (2 x 2)
+  /// @return false if the result is not finite (e.g. an open series branch),
+  /// in which case the point must be solved with nodal analysis
+  bool solveCascade(ComplexMatrix& S);
+
+  /// @brief Admittance of a cascade branch at the current frequency
+  Complex cascadeBranchAdmittance(const CascadeBranch& branch,
+                                  const vector<Complex>& admittances);
+
+  /// @brief Y-matrix of a two-port cascade stage at the current frequency
+  ComplexMatrix2 cascadeTwoPortY(const CascadeStage& stage);
+
+  ComplexMatrix scratchTwoPortY;            ///< Stamp target of two-port stages
+  vector<Complex> scratchBranchAdmittances; ///< Admittance of each branch
+
+  /// @brief Assembles the augmented nodal system at the current frequency in
+  /// the sparse storage and factorizes it
+  /// @details sparseFixedValues is copied into sparseLU and the
+  /// frequency-dependent elements are stamped on top through the pattern
+  /// @return false if the factorization found an unstable pivot
+  bool factorizeSparse();
+
+  /// @brief Calculates the S-parameters and their derivatives with respect to
+  /// circuit.parameters at the current frequency
+  /// @param[out] S S-parameter matrix
+  /// @param[out] dS dS/dp, one matrix per parameter
+  /// @param selection Indices of the parameters to differentiate against
+  /// (nullptr: all of them). dS[k] corresponds to (*selection)[k]
+  /// @details Adjoint method: the factors of the augmented nodal system are
+  /// reused to solve the transposed system for the port unknowns. The
+  /// derivative with respect to any parameter is then a product of the two
+  /// solutions over the nodes of its component, so the cost is one extra
+  /// solve regardless of the number of parameters
+  void solveSensitivities(ComplexMatrix& S, vector<ComplexMatrix>& dS,
+                          const vector<int>* selection = nullptr);
+
+  /// @brief Derivative of the stamp of a component with respect to one of
+  /// its parameters, at the current frequency
+  /// @param parameter Component parameter
+  /// @param[out] nodes Nodes of the component (0: ground)
+  /// @param[out] dY Derivative of the local stamp (count x count)
+  /// @return Number of nodes of the component (count)
+  /// @details Lumped elements are differentiated in closed form. The stamps
+  /// of distributed elements are differentiated by central differences
+  int sensitivityStamp(const SensitivityParameter& parameter, int nodes[4],
+                       ComplexMatrix& dY);
+
+  /// @brief Changes a component value of the compiled circuit
+  /// @param parameter Component parameter
+  /// @param value New value (SI units)
+  /// @details The circuit is not recompiled. Resistors are restamped into
+  /// fixedY and microstrip widths update the quasi-static model. The other
+  /// values are read from the compiled arrays at every frequency
+  void setParameterValue(const SensitivityParameter& parameter, double value);
+
+  /// @brief Puts back the nominal value of a component parameter
+  /// @param parameter Component parameter
+  /// @param nominal Engine the worker was copied from
+  /// @details Restores the compiled element and, for resistors, their
+  /// entries of fixedY. A new set of values is then applied with
+  /// setParameterValue() against the nominal circuit, so the result does not
+  /// depend on the values set before
+  void restoreParameterValue(const SensitivityParameter& parameter,
+                             const SParameterCalculator& nominal);
+
+  /// @brief Weighted violation of the goals and its gradient with respect to
+  /// the log of the selected parameters
+  /// @param engines Per-worker copies of the engine
+  /// @param selection Indices of the variables in circuit.parameters
+  /// @param values Values of the variables. They are set on every engine
+  /// @param points Sweep grid indices covered by at least one goal
+  /// @param goals Limit lines
+  /// @param[out] gradient Gradient of the cost
+  /// @return Cost, or infinity if a point could not be solved
+  double optimizationCost(vector<SParameterCalculator>& engines,
+                          const vector<int>& selection,
+                          const vector<double>& values,
+                          const vector<int>& points,
+                          const vector<SpecificationLimit>& goals,
+                          vector<double>& gradient);
+
+  /// @brief Tolerance of a component value (see setTolerance())
+  Tolerance getTolerance(const SensitivityParameter& parameter) const;
+
+  ComplexMatrix scratchAdjoint;         ///< Adjoint solutions of the ports
+  ComplexMatrix scratchStampDerivative; ///< Stamp derivative of a component
+  ComplexMatrix scratchStamp;           ///< Perturbed stamp of a component
+
+  /// @brief Throws if a port is connected to a node that does not exist
+  void checkPortNodes() const;
+
+  /// @brief Compiles the circuit if the component list changed
+  void ensureCircuitCompiled() {
+    if (!circuitCompiled) {
+      compileCircuit();
+    }
+  }
+
+  /// @brief Calculates the impedance of a lumped element
+  /// @param comp Lumped element
+  /// @param freq Frequency at which the impedance must be calculated
+  /// @return Complex value with the impedance
+  Complex getImpedance(const CompiledLumped& comp, double freq);
 
-  /// @brief Calculates frequency-dependent impedance for a component
-  /// @param comp Component_SPAR object, which indicates the component type and contains its parameters
+  /// @brief Calculates the input impedance of an ideal stub
+  /// @param stub Open or short-circuited stub
   /// @param freq Frequency at which the impedance must be calculated
   /// @return Complex value with the impedance
-  Complex getImpedance(const Component_SPAR& comp, double freq);
+  Complex getImpedance(const CompiledStub& stub, double freq);
+
+  /// @brief Adds a two-terminal admittance to the nodal matrix
+  /// @param Y Reference to circuit admittance matrix
+  /// @param node1 First terminal (0 is ground)
+  /// @param node2 Second terminal (0 is ground)
+  /// @param y Admittance between the two terminals
+  void addTwoTerminalAdmittance(StampTarget Y, int node1, int node2,
+                                Complex y);
 
   /// @brief Constructs nodal admittance matrix for the circuit
-  /// @return Admittance matrix of the network
-  vector<vector<Complex>> buildAdmittanceMatrix();
+  /// @param[out] Y Admittance matrix of the network. Resized to numNodes
+  /// @details Copies fixedY and adds the frequency-dependent stamps on top
+  void buildAdmittanceMatrix(ComplexMatrix& Y);
+
+  /// @brief Stamps the elements whose admittance does not change with
+  /// frequency (fixed impedances, ideal couplers, constant S-parameter blocks
+  /// and the gmin conductance)
+  /// @param Y Admittance matrix (numNodes x numNodes), cleared by the caller
+  void buildFixedAdmittanceMatrix(StampTarget Y);
+
+  /// @brief Adds the stamps of the frequency-dependent elements at the
+  /// current analysis frequency
+  /// @param Y Reference to circuit admittance matrix
+  void addFrequencyDependentAdmittance(StampTarget Y);
+
+  /// @brief Solves the nodal equations at the current frequency
+  /// @param[out] S S-parameter matrix. Resized to the number of ports
+  /// @details Works on the scratch matrices, so it does not allocate once
+  /// they have reached their final size
+  void solveSParameters(ComplexMatrix& S);
 
   /// @brief Adds coupled transmission line to admittance matrix
   /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component containing coupled line parameters (Z0e, Z0o, length)
-  void addCoupledLineToAdmittance(vector<vector<Complex>>& Y,
-                                  const Component_SPAR& comp);
+  /// @param line Coupled line parameters (Z0e, Z0o, length)
+  void addCoupledLineToAdmittance(StampTarget Y,
+                                  const CompiledCoupledLine& line);
 
   /// @brief Calculates Y-matrix for coupled transmission lines
   /// @param Z0e Even-mode characteristic impedance (Ω)
@@ -173,38 +982,38 @@ private:
   /// @param length Physical length of coupled section (m)
   /// @param freq Operating frequency (Hz)
   /// @return 4×4 complex Y-parameter matrix for coupled line
-  vector<vector<Complex>> calculateCoupledLineYMatrix(double Z0e, double Z0o,
-                                                      double length,
-                                                      double freq);
+  ComplexMatrix4 calculateCoupledLineYMatrix(double Z0e, double Z0o,
+                                             double length, double freq);
 
   /// @brief Adds ideal directional coupler to admittance matrix
   /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component containing coupler parameters (k, phase, Z0)
-  void addIdealCouplerToAdmittance(vector<vector<Complex>>& Y,
-                                   const Component_SPAR& comp);
+  /// @param coupler Coupler with its precomputed Y-matrix
+  void addIdealCouplerToAdmittance(StampTarget Y,
+                                   const CompiledIdealCoupler& coupler);
 
   /// @brief Calculates Y-matrix for ideal coupler with coupling coefficient and phase
   /// @param k Linear coupling coefficient (0 to 1, where k²=coupled power fraction)
   /// @param phase_deg Phase shift between coupled and through ports (degrees)
   /// @param Z0 Reference impedance for all ports (Ω)
   /// @return 4×4 complex Y-parameter matrix for ideal coupler
-  vector<vector<Complex>>
+  ComplexMatrix4
   calculateIdealCouplerYMatrix(double k, double phase_deg, double Z0);
 
 
   /// @brief Adds ideal transmission line to admittance matrix
   /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component containing line parameters (Z0, length)
-  void addTransmissionLineToAdmittance(vector<vector<Complex>>& Y,
-                                       const Component_SPAR& comp);
+  /// @param line Line parameters (Z0, length)
+  void addTransmissionLineToAdmittance(StampTarget Y,
+                                       const CompiledTransmissionLine& line);
 
   /// @brief Interpolates S-matrix from frequency-dependent data
-  /// @param comp Component containing S-parameter data
+  /// @param block Block containing the tabulated S-parameters
   /// @param freq Target frequency for interpolation (Hz)
   /// @return Interpolated S-parameter matrix at specified frequency
   /// @note Required for frequency-dependent components
-  vector<vector<Complex>>
-  interpolateFrequencyDependentSMatrix(const Component_SPAR& comp, double freq);
+  ComplexMatrix2
+  interpolateFrequencyDependentSMatrix(
+      const CompiledFrequencyDependentBlock& block, double freq);
 
   /// @brief Extracts S-matrix at specific frequency index
   /// @param comp Component containing frequency-dependent S-parameter data
@@ -212,35 +1021,42 @@ private:
   /// @return S-parameter matrix at the indexed frequency point
   /// @details Direct lookup without interpolation.
   /// @note Used when analysis frequency exactly matches a tabulated point, or as part of interpolation routine.
-  vector<vector<Complex>> extractSMatrixAtIndex(const Component_SPAR& comp,
+  ComplexMatrix extractSMatrixAtIndex(const Component_SPAR& comp,
                                                 int freqIndex);
 
   /// @brief Adds frequency-dependent S-parameter block to admittance matrix
   /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component with S-parameter data (multiple frequency points)
+  /// @param block Block with S-parameter data (multiple frequency points)
   /// @details Interpolates S-parameters at current analysis frequency from
   /// S-parameter data,
-  void addFrequencyDependentSParamBlockToAdmittance(vector<vector<Complex>>& Y,
-                                                    const Component_SPAR& comp);
+  void addFrequencyDependentSParamBlockToAdmittance(
+      StampTarget Y, const CompiledFrequencyDependentBlock& block);
 
   /// @brief Parses inline S-matrix from netlist string format
   /// @param matrixStr String containing S-parameters in format: (re,im) (re,im); ...
   /// @param numPorts Number of ports
   /// @return S-parameter matrix extracted from string
-  vector<vector<Complex>> parseInlineSMatrix(const QString& matrixStr,
+  ComplexMatrix parseInlineSMatrix(const QString& matrixStr,
                                              int numPorts);
 
-  /// @brief Adds one-port S-parameter device to admittance matrix
-  /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component containing single S11 parameter
-  void addOnePortSParamToAdmittance(vector<vector<Complex>>& Y,
-                                    const Component_SPAR& comp);
+  /// @brief Converts the S-parameters of a 1-port or 2-port block to Y
+  /// @param S S-parameter matrix. One-port blocks only use S[0][0]
+  /// @param numRFPorts 1 or 2
+  /// @param Z0 Reference impedance (Ω)
+  /// @return Y-parameters of the block. One-port blocks only set Y[0][0]
+  ComplexMatrix2 sParamBlockToY(const ComplexMatrix2& S, int numRFPorts,
+                                double Z0);
 
-  /// @brief Adds two-port S-parameter device to admittance matrix
+  /// @brief Adds the Y-parameters of a 1-port or 2-port block to the
+  /// admittance matrix
   /// @param Y Reference to circuit admittance matrix
-  /// @param comp Component containing 2×2 S-parameter matrix
-  void addTwoPortSParamToAdmittance(vector<vector<Complex>>& Y,
-                                    const Component_SPAR& comp);
+  /// @param node1 First node of the block
+  /// @param node2 Second node of the block
+  /// @param numRFPorts 1 (two-terminal device between node1 and node2) or 2
+  /// (port 1 at node1, port 2 at node2, both referred to ground)
+  /// @param Yblock Y-parameters returned by sParamBlockToY()
+  void addSParamBlockToAdmittance(StampTarget Y, int node1, int node2,
+                                  int numRFPorts, const ComplexMatrix2& Yblock);
 
   /// @brief Adds S-parameter device component to circuit
   /// @param name Component identifier string
@@ -249,7 +1065,7 @@ private:
   /// @param numRFPorts Number of RF ports (1, 2, 3, or 4)
   /// @param Z0 Reference impedance for S-parameters (typically 50Ω)
   void addSParameterDevice(const string& name, const vector<int>& nodes,
-                           const vector<vector<Complex>>& Smatrix,
+                           const ComplexMatrix& Smatrix,
                            int numRFPorts, double Z0);
 
   ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -257,9 +1073,9 @@ private:
 
   /// @brief Adds microstrip transmission line to admittance matrix
   /// @param Y Reference to circuit admittance matrix (modified in place)
-  /// @param comp Component with microstrip parameters (W, L, substrate properties)
-  void addMicrostripLineToAdmittance(vector<vector<Complex>>& Y,
-                                     const Component_SPAR& comp);
+  /// @param line Microstrip parameters (W, L, substrate properties)
+  void addMicrostripLineToAdmittance(StampTarget Y,
+                                     const CompiledMicrostripLine& line);
 
   /// @brief Calculates propagation parameters for microstrip line
   /// @param W Line width (m)
@@ -278,6 +1094,24 @@ private:
                                  double frequency, double& alpha, double& beta,
                                  double& zl, double& ereff);
 
+  /// @brief Calculates the propagation of a compiled microstrip line
+  /// @details Same model as the overload above, with the quasi-static
+  /// impedance, permittivity and loss factors taken from line.statics
+  void calcMicrostripPropagation(const CompiledMicrostripLine& line,
+                                 double frequency, double& alpha, double& beta,
+                                 double& zl, double& ereff);
+
+  /// @brief Computes the frequency-independent part of the microstrip model
+  /// @param W Line width (m)
+  /// @param h Substrate height (m)
+  /// @param er Relative permittivity
+  /// @param t Metal thickness (m)
+  /// @param tand Loss tangent
+  /// @param rho Metal resistivity (Ω·m)
+  MicrostripStatics analyseMicrostripStatics(double W, double h, double er,
+                                             double t, double tand,
+                                             double rho);
+
   /// @brief Analyzes quasi-static microstrip parameters
   /// @param W Line width (m)
   /// @param h Substrate height (m)
@@ -367,9 +1201,9 @@ private:
   // Microstrip step
   /// @brief Adds microstrip impedance step to admittance matrix
   /// @param Y Reference to circuit admittance matrix (modified in place)
-  /// @param comp Component with step parameters (W1, W2, substrate properties)
-  void addMicrostripStepToAdmittance(vector<vector<Complex>>& Y,
-                                     const Component_SPAR& comp);
+  /// @param step Step parameters (W1, W2, substrate properties)
+  void addMicrostripStepToAdmittance(StampTarget Y,
+                                     const CompiledMicrostripStep& step);
   void calcMicrostripStepZ(double W1, double W2, double h, double er, double t,
                            double frequency, const string& SModel,
                            const string& DModel, Complex& z11, Complex& z12,
@@ -380,9 +1214,9 @@ private:
   // Microstrip open
   /// @brief Adds microstrip open-end to admittance matrix
   /// @param Y Reference to circuit admittance matrix (modified in place)
-  /// @param comp Component with open-end parameters (W, substrate properties)
-  void addMicrostripOpenToAdmittance(vector<vector<Complex>>& Y,
-                                     const Component_SPAR& comp);
+  /// @param open Open-end parameters (W, substrate properties)
+  void addMicrostripOpenToAdmittance(StampTarget Y,
+                                     const CompiledMicrostripOpen& open);
 
   /// @brief Calculates admittance of microstrip open-end
   /// @param W Line width (m)
@@ -417,9 +1251,9 @@ private:
   /// Microstrip via
   /// @brief Adds microstrip via to admittance matrix
   /// @param Y Reference to circuit admittance matrix (modified in place)
-  /// @param comp Component with via parameters (D, h, substrate properties)
-  void addMicrostripViaToAdmittance(vector<vector<Complex>>& Y,
-                                    const Component_SPAR& comp);
+  /// @param via Via parameters (D, h, substrate properties)
+  void addMicrostripViaToAdmittance(StampTarget Y,
+                                    const CompiledMicrostripVia& via);
 
   /// @brief Calculates impedance of microstrip via
   /// @param D Via diameter (m)
@@ -444,9 +1278,9 @@ private:
   /// Microstrip coupled lines
   /// @brief Adds microstrip coupled lines to admittance matrix
   /// @param Y Reference to circuit admittance matrix (modified in place)
-  /// @param comp Component with coupled line parameters (W, S, L, substrate)
-  void addMicrostripCoupledLinesToAdmittance(vector<vector<Complex>>& Y,
-                                             const Component_SPAR& comp);
+  /// @param lines Coupled line parameters (W, S, L, substrate)
+  void addMicrostripCoupledLinesToAdmittance(
+      StampTarget Y, const CompiledMicrostripCoupledLines& lines);
 
   /// @brief Calculates propagation parameters for microstrip coupled lines
   /// @param W Line width (m)
@@ -473,6 +1307,29 @@ private:
                                         double& alpha_o, double& beta_o,
                                         double& zl_o, double& ereff_o);
 
+  /// @brief Calculates the even and odd mode propagation of compiled coupled
+  /// lines, with the quasi-static part taken from lines.even and lines.odd
+  void calcMicrostripCoupledPropagation(
+      const CompiledMicrostripCoupledLines& lines, double frequency,
+      double& alpha_e, double& beta_e, double& zl_e, double& ereff_e,
+      double& alpha_o, double& beta_o, double& zl_o, double& ereff_o);
+
+  /// @brief Computes the frequency-independent part of the even and odd
+  /// modes of coupled microstrip lines
+  /// @param W Line width (m)
+  /// @param S Spacing between lines (m)
+  /// @param h Substrate height (m)
+  /// @param er Relative permittivity
+  /// @param t Metal thickness (m)
+  /// @param tand Loss tangent
+  /// @param rho Metal resistivity (Ω·m)
+  /// @param[out] even Even mode
+  /// @param[out] odd Odd mode
+  void analyseMicrostripCoupledStatics(double W, double S, double h, double er,
+                                       double t, double tand, double rho,
+                                       MicrostripStatics& even,
+                                       MicrostripStatics& odd);
+
   /// @brief Analyzes quasi-static parameters for coupled microstrip lines
   /// @param W Line width (m)
   /// @param h Substrate height (m)
@@ -536,10 +1393,27 @@ private:
   double f_start = 1e6;   ///< Frequency sweep start (Hz)
   double f_stop = 1e9;    ///< Frequency sweep stop (Hz)
   int n_points = 20;      ///< Number of frequency points
+  int sweepThreads = 0;   ///< Sweep worker threads (0: one per hardware thread)
+  int sparseSolverThreshold = 60; ///< Node count above which the sparse
+                                  ///< solver is used (0: never)
+  bool kronReduction = false; ///< Reduce the nodal matrix to the port nodes
+  bool cascadeFastPath = true; ///< Solve two-port chains with ABCD matrices
+  bool adaptiveSweep = false;     ///< Solve a subset of the sweep points
+  double adaptiveTolerance = 1e-3; ///< Relative error of the adaptive model
+  int sweepSolves = 0;            ///< Points solved by the last sweep
+  bool sensitivityAnalysis = false; ///< Differentiate the sweep results
+  bool incrementalSweep = true;   ///< Update the last sweep after edits
+  int sweepUpdates = 0;           ///< Points updated by the last sweep
+  /// Tolerances by "component" or "component.parameter"
+  std::map<string, Tolerance> componentTolerances;
+  /// Tolerances by parameter kind
+  std::map<SensitivityParameter::Kind, Tolerance> defaultTolerances;
 
   // Simulation data
-  std::vector<std::vector<std::vector<Complex>>> sweepResults; ///< Stored S-parameter sweep data
-  QMap<QString, QList<double>> data; ///< Formatted sweep results for export
+  std::vector<ComplexMatrix> sweepResults; ///< Stored S-parameter sweep data
+  /// Derivatives of the sweep results, [point][parameter]
+  std::vector<vector<ComplexMatrix>> sweepSensitivities;
+  SParSweep sweepData; ///< Sweep results in frequency order, for export
 
   /// @brief Parses value with SI prefixes and unit conversion
   /// @param input String containing numerical value with optional SI prefix (k, M, G, m, u, n, p)
@@ -582,34 +1456,42 @@ public:
   void addPort(int node, double impedance = 50.0);
 
   /// @brief Calculates S-parameters at current frequency
-  /// @return S-parameter matrix
-  vector<vector<Complex>> calculateSParameters();
+  /// @return S-parameter matrix. NaN if the circuit is singular at this
+  /// frequency
+  ComplexMatrix calculateSParameters();
+
+  /// @brief Calculates the Y-matrix of the circuit seen from its ports at
+  /// the current frequency
+  /// @return Port admittance matrix (ports x ports). The circuit can be
+  /// embedded in a larger one as a block with this admittance
+  ComplexMatrix calculatePortAdmittance();
 
   // SPAR Block component
-  /// @brief Converts S-parameters to Y-parameters
-  vector<vector<Complex>> convertS2Y(const vector<vector<Complex>>& S,
-                                     double Z0);
+  /// @brief Converts S-parameters to Y-parameters. NaN if I + S is singular
+  ComplexMatrix convertS2Y(const ComplexMatrix& S, double Z0);
 
-  /// @brief Adds S-parameter block to admittance matrix
-  void addSParamBlockToAdmittance(vector<vector<Complex>>& Y,
-                                  const Component_SPAR& comp);
+  /// @brief Converts two-port S-parameters to Y-parameters (closed form). NaN
+  /// if I + S is singular
+  ComplexMatrix2 convertS2Y(const ComplexMatrix2& S, double Z0);
 
   /// @brief Adds S-parameter block component
 
   void addSParameterBlock(const string& name, const vector<int>& nodes,
-                          const vector<vector<Complex>>& Smatrix);
+                          const ComplexMatrix& Smatrix);
 
   /// @brief Prints S-parameters in readable format to console
-  void printSParameters(const vector<vector<Complex>>& S);
+  void printSParameters(const ComplexMatrix& S);
 
   /// @brief Exports S-parameters to Touchstone file format
   void exportTouchstone(const QString& filename,
-                        const vector<vector<Complex>>& S);
+                        const ComplexMatrix& S);
 
   /// @brief Clears all components and ports
   void clear(){
     components.clear();
     ports.clear();
+    circuit.clear();
+    circuitCompiled = false;
     numNodes = 0;
   }
 
@@ -626,9 +1508,6 @@ public:
   /// @brief Returns current analysis frequency
   double getFrequency() const { return frequency; }
 
-  /// @brief Returns formatted sweep data
-  QMap<QString, QList<double>> getData() { return data; }
-
   // Setter methods
   /// @brief Sets current analysis frequency
   void setFrequency(double freq) { frequency = freq; }
@@ -636,14 +1515,213 @@ public:
   /// @brief Configures frequency sweep parameters
   void setFrequencySweep(double start, double stop, int points);
 
+  /// @brief Sets the number of worker threads used by the frequency sweep
+  /// @param threads Number of threads. 0 uses one per hardware thread and 1
+  /// runs the sweep serially
+  void setSweepThreads(int threads) { sweepThreads = std::max(threads, 0); }
+
+  /// @brief Sets the circuit size from which the nodal equations are solved
+  /// with the sparse LU solver
+  /// @param nodes Minimum number of nodes. 0 always uses the dense solver
+  void setSparseSolverThreshold(int nodes) {
+    sparseSolverThreshold = std::max(nodes, 0);
+    circuitCompiled = false;
+  }
+
+  /// @brief Returns the node count from which the sparse solver is used
+  int getSparseSolverThreshold() const { return sparseSolverThreshold; }
+
+  /// @brief Enables the Kron reduction of the internal nodes
+  /// @details The internal nodes are eliminated from the nodal matrix at each
+  /// frequency and the S-parameters are calculated from the port-level
+  /// Y-matrix. Only applies to the dense solver
+  void setKronReduction(bool enable) { kronReduction = enable; }
+
+  /// @brief Returns true if the Kron reduction is enabled
+  bool getKronReduction() const { return kronReduction; }
+
+  /// @brief Enables the ABCD cascade evaluation of two-port chains
+  /// @details Circuits that are a chain of series/shunt branches and two-port
+  /// sections between two ports (ladder filters, stepped lines, matching
+  /// sections) are evaluated by multiplying 2x2 ABCD matrices instead of
+  /// solving the nodal equations. Other circuits always use nodal analysis
+  void setCascadeFastPath(bool enable) { cascadeFastPath = enable; }
+
+  /// @brief Returns true if the ABCD cascade evaluation is enabled
+  bool getCascadeFastPath() const { return cascadeFastPath; }
+
+  /// @brief Returns the number of worker threads used by the frequency sweep
+  int getSweepThreads() const {
+    if (sweepThreads > 0) {
+      return sweepThreads;
+    }
+    return std::max(1, (int)std::thread::hardware_concurrency());
+  }
+
+  /// @brief Enables the adaptive frequency sweep
+  /// @param enable If true, only a subset of the sweep points is solved. The
+  /// rest are interpolated with local rational models
+  /// @param tolerance Relative error accepted between the model and a solved
+  /// point before the sweep stops refining an interval
+  void setAdaptiveSweep(bool enable, double tolerance = 1e-3) {
+    adaptiveSweep = enable;
+    adaptiveTolerance = tolerance;
+  }
+
+  /// @brief Returns true if the adaptive frequency sweep is enabled
+  bool getAdaptiveSweep() const { return adaptiveSweep; }
+
+  /// @brief Returns the number of frequency points solved by the last sweep
+  int getSweepSolveCount() const { return sweepSolves; }
+
+  /// @brief Enables the incremental update of the frequency sweep
+  /// @details A full sweep keeps the factors of the nodal system at every
+  /// point (up to FactorCacheBudget). When the next sweep has the same grid
+  /// and topology and only a few component values changed (e.g. a value
+  /// tuned in a netlist), the previous solutions are updated with a
+  /// low-rank correction instead of being solved again. Sweeps through the
+  /// ABCD cascade, the adaptive sweep and the sensitivity analysis are
+  /// always solved from scratch
+  void setIncrementalSweep(bool enable) {
+    incrementalSweep = enable;
+    if (!enable) {
+      factorCache.reset();
+    }
+  }
+
+  /// @brief Returns true if the incremental sweep update is enabled
+  bool getIncrementalSweep() const { return incrementalSweep; }
+
+  /// @brief Returns the number of frequency points the last sweep updated
+  /// from the factors of an earlier sweep
+  int getSweepUpdateCount() const { return sweepUpdates; }
+
+  /// @brief Enables the sensitivity analysis in calculateSParameterSweep()
+  /// @details The derivatives of the S-parameters with respect to
+  /// getSensitivityParameters() are calculated at every point and returned by
+  /// getSweepSensitivities(). The cascade and adaptive shortcuts are not used
+  /// while it is enabled
+  void setSensitivityAnalysis(bool enable) { sensitivityAnalysis = enable; }
+
+  /// @brief Returns true if the sensitivity analysis is enabled
+  bool getSensitivityAnalysis() const { return sensitivityAnalysis; }
+
+  /// @brief Returns the component values the S-parameters are differentiated
+  /// against: R, C, L, the Z0 and length of stubs and transmission lines and
+  /// the width and length of microstrip lines
+  const vector<SensitivityParameter>& getSensitivityParameters() {
+    ensureCircuitCompiled();
+    return circuit.parameters;
+  }
+
+  /// @brief Calculates the derivatives of the S-parameters at the current
+  /// frequency
+  /// @return dS/dp for each entry of getSensitivityParameters()
+  vector<ComplexMatrix> calculateSensitivities();
+
+  /// @brief Returns the derivatives calculated by the last sweep
+  /// @return [point][parameter] matrices. Empty if the sensitivity analysis
+  /// was disabled
+  const vector<vector<ComplexMatrix>>& getSweepSensitivities() const {
+    return sweepSensitivities;
+  }
+
+  /// @brief Sets the tolerance of a component for the Monte Carlo analysis
+  /// @param component Component name
+  /// @param tolerance Distribution of its values
+  /// @param parameter Parameter name (e.g. "Z0"). Empty applies to all the
+  /// parameters of the component
+  void setTolerance(const string& component, const Tolerance& tolerance,
+                    const string& parameter = "") {
+    string key = parameter.empty() ? component : component + "." + parameter;
+    componentTolerances[key] = tolerance;
+  }
+
+  /// @brief Sets the tolerance of all the parameters of a kind (e.g. all the
+  /// capacitances) that have no tolerance of their own
+  void setDefaultTolerance(SensitivityParameter::Kind kind,
+                           const Tolerance& tolerance) {
+    defaultTolerances[kind] = tolerance;
+  }
+
+  /// @brief Removes all the tolerances
+  void clearTolerances() {
+    componentTolerances.clear();
+    defaultTolerances.clear();
+  }
+
+  /// @brief Runs a Monte Carlo tolerance analysis over the frequency sweep
+  /// @param trials Number of perturbed circuits
+  /// @param limits Specification the circuits are tested against
+  /// @param seed Seed of the random samples
+  /// @param control Progress (one step per trial and block of points) and
+  /// abort flag, checked before each trial. Optional
+  /// @return Envelopes of the S-parameters and yield against the limits
+  /// @details Each trial draws all the toleranced values from its own random
+  /// stream, so the result does not depend on the number of threads. The
+  /// trials are spread across getSweepThreads() workers. They reuse the
+  /// compiled circuit and only update the perturbed values. Long sweeps are
+  /// run in blocks of points, so that the magnitudes kept for the envelopes
+  /// stay within a fixed memory budget
+  MonteCarloResult runMonteCarlo(int trials,
+                                 const vector<SpecificationLimit>& limits = {},
+                                 unsigned seed = 1,
+                                 AnalysisControl* control = nullptr);
+
+  /// @brief Tunes component values until the S-parameters meet the goals
+  /// @param variables Component values to tune
+  /// @param goals Limit lines the S-parameters must meet
+  /// @param maxIterations Maximum number of quasi-Newton iterations
+  /// @param control Progress (one step per iteration) and abort flag, checked
+  /// before each cost evaluation. An aborted optimization returns the best
+  /// values found so far. Optional
+  /// @return Optimized values and the netlist with those values
+  /// @details Minimises the weighted sum of the squared violations (in dB)
+  /// of the goals over the sweep points they cover. The cost gradient comes
+  /// from the adjoint sensitivities and drives a BFGS search on the log of
+  /// the values. Only the points covered by the goals are solved, spread
+  /// across getSweepThreads() workers, and the circuit is not recompiled
+  /// between iterations. The circuit of this engine is left unchanged
+  OptimizationResult optimize(const vector<OptimizationVariable>& variables,
+                              const vector<SpecificationLimit>& goals,
+                              int maxIterations = 100,
+                              AnalysisControl* control = nullptr);
+
+  /// @brief Writes component values into the netlist
+  /// @param parameters Component parameters with the values to write.
+  /// Parameters without a netlist field (SensitivityParameter::field) are
+  /// skipped
+  /// @return Copy of the current netlist with those values replaced
+  QString writeParameterValues(
+      const vector<SensitivityParameter>& parameters) const;
+
+  /// @brief Formats a parameter value the way the netlist parser reads it
+  /// @param parameter Component parameter, with its value
+  /// @return Lengths in mm, other values with an SI prefix and their unit
+  static QString formatParameterValue(const SensitivityParameter& parameter);
+
   /// @brief Performs S-parameter calculation over frequency sweep
+  /// @details The frequency points are spread across getSweepThreads()
+  /// workers, each one running on its own copy of the engine. The results
+  /// are stored in frequency order and are identical to the serial sweep.
+  /// With setAdaptiveSweep(), the grid is sampled coarsely and refined only
+  /// where the interpolated response disagrees with the solved one.
   void calculateSParameterSweep();
 
+  /// @brief Returns the S-parameter matrices calculated by the last sweep
+  /// @return One matrix per frequency point
+  const vector<ComplexMatrix>& getSweepResults() const { return sweepResults; }
+
+  /// @brief Returns the frequencies and S-parameters of the last sweep
+  /// @details Points where the solve failed hold NaN
+  const SParSweep& getSweep() const { return sweepData; }
+
   /// @brief Prints all S-parameters from stored sweep
   void printSParameterSweep() const;
 
   /// @brief Exports frequency sweep to Touchstone file
-  void exportSweepTouchstone(const QString& filename) const;
+  /// @return false if the file could not be created or written
+  bool exportSweepTouchstone(const QString& filename) const;
 
 private:
   /// @brief Parses netlist from currentNetlist string line by line and populates
@@ -0,0 +1,99 @@
+/// @file SparseLU.h
+/// @brief Sparse LU factorization of the nodal equations
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef SPARSELU_H
+#define SPARSELU_H
+
+#include <complex>
+#include <vector>
+
+#include "ComplexMatrix.h"
+
+/// @class SparseLU
+/// @brief LU factorization of a structurally symmetric sparse matrix
+/// @details The work is split in two stages:
+/// - analyze(): computes a minimum degree ordering and the pattern of the
+///   factors (including fill-in). It only depends on the circuit topology.
+/// - factorize(): numeric factorization. It is repeated at every frequency
+///   point and reuses the ordering and the storage of the analysis.
+///
+/// The factors are stored row by row in the permuted order. Each row holds
+/// its L part, the diagonal and its U part in ascending column order. There
+/// are no row interchanges during the numeric stage, so factorize() reports
+/// an unstable pivot instead. The caller is expected to fall back to the
+/// dense solver in that case.
+class SparseLU {
+public:
+  using Complex = std::complex<double>;
+
+  /// @brief Computes the ordering and the pattern of the factors
+  /// @param n Matrix size
+  /// @param adjacency Off-diagonal pattern. adjacency[i] lists the columns
+  /// of the nonzero entries in row i. It must be symmetric
+  /// @param numTrailing Number of trailing rows/columns that must be ordered
+  /// after all the others
+  void analyze(int n, const std::vector<std::vector<int>> &adjacency,
+               int numTrailing = 0);
+
+  /// @brief Discards the analysis
+  void clear();
+
+  /// @brief Returns true if analyze() has been called
+  bool isAnalyzed() const { return n > 0; }
+
+  /// @brief Matrix size
+  int size() const { return n; }
+
+  /// @brief Number of entries in the factors, including fill-in
+  int nonZeros() const { return (int)colIndex.size(); }
+
+  /// @brief Looks up the storage slot of an entry of the original matrix
+  /// @param row Row (original numbering)
+  /// @param col Column (original numbering)
+  /// @return Index into values(), or -1 if the entry is not in the pattern
+  int find(int row, int col) const;
+
+  /// @brief Sets all the values to zero before the matrix is assembled
+  void setZero();
+
+  /// @brief Storage of the matrix entries. Written by the caller through the
+  /// indices returned by find(), overwritten with the factors by factorize()
+  Complex *values() { return vals.data(); }
+
+  /// @brief Factorizes the assembled matrix in place
+  /// @param pivotTolerance Smallest accepted ratio between the magnitude of
+  /// a pivot and the largest entry of its row in U
+  /// @return false if a pivot is zero or too small, true otherwise
+  bool factorize(double pivotTolerance = 1e-3);
+
+  /// @brief Condition estimate of the last factorize(): largest ratio
+  /// between the magnitude of a row before the elimination and its pivot
+  double getPivotRatio() const { return pivotRatio; }
+
+  /// @brief Solves A·X = B with the factors from factorize()
+  /// @param[in,out] B Right-hand side (n x m, original numbering). Overwritten
+  /// with X
+  void solve(ComplexMatrixView B);
+
+  /// @brief Solves A^T·X = B with the factors from factorize()
+  /// @param[in,out] B Right-hand side (n x m, original numbering). Overwritten
+  /// with X
+  void solveTransposed(ComplexMatrixView B);
+
+private:
+  int n = 0;
+  std::vector<int> perm;      ///< Position in the ordering -> original index
+  std::vector<int> invPerm;   ///< Original index -> position in the ordering
+  std::vector<int> rowStart;  ///< Start of each row in colIndex/vals (n + 1)
+  std::vector<int> diagIndex; ///< Slot of the diagonal entry of each row
+  std::vector<int> colIndex;  ///< Column (permuted numbering) of each slot
+  std::vector<Complex> vals;  ///< Matrix entries / LU factors
+  std::vector<Complex> work;  ///< Dense row accumulator (n)
+  double pivotRatio = 1.0;    ///< See getPivotRatio()
+};
+
+#endif // SPARSELU_H
@@ -8,7 +8,7 @@
 
 #include "SPAR/SParameterCalculator.h"
 
-vector<vector<Complex>>
+ComplexMatrix4
 SParameterCalculator::calculateIdealCouplerYMatrix(double k, double phase_deg,
                                                    double Z0) {
   // k is the linear coupling coefficient (not dB)
@@ -29,7 +29,7 @@ SParameterCalculator::calculateIdealCouplerYMatrix(double k, double phase_deg,
   //     [0   k*e^(jφ)  0   t     ]
   //     [k*e^(jφ)  0   t   0     ]
 
-  vector<vector<Complex>> S = createMatrix(4, 4);
+  ComplexMatrix4 S;
 
   // Calculate coupling with phase shift
   Complex k_phase = k * phase_factor;
@@ -45,14 +45,9 @@ SParameterCalculator::calculateIdealCouplerYMatrix(double k, double phase_deg,
   S[3][2] = Complex(t, 0); // S34 = t (through)
 
   // Convert S-parameters to Y-parameters using: Y = G0 * (I - S) * inv(I + S)
-  vector<vector<Complex>> I = createMatrix(4, 4);
-  vector<vector<Complex>> I_minus_S = createMatrix(4, 4);
-  vector<vector<Complex>> I_plus_S = createMatrix(4, 4);
-
-  // Identity matrix
-  for (int i = 0; i < 4; i++) {
-    I[i][i] = Complex(1, 0);
-  }
+  ComplexMatrix4 I = ComplexMatrix4::identity();
+  ComplexMatrix4 I_minus_S;
+  ComplexMatrix4 I_plus_S;
 
   // Calculate I - S and I + S
   for (int i = 0; i < 4; i++) {
@@ -62,55 +57,44 @@ SParameterCalculator::calculateIdealCouplerYMatrix(double k, double phase_deg,
     }
   }
 
-  vector<vector<Complex>> Y = createMatrix(4, 4);
+  ComplexMatrix4 Y;
 
-  try {
-    // Y = G0 * (I - S) * inv(I + S)
-    vector<vector<Complex>> I_plus_S_inv = invertMatrix(I_plus_S);
+  // Y = G0 * (I - S) * inv(I + S). I + S is factorized in place
+  ComplexMatrix4 I_plus_S_inv = ComplexMatrix4::identity();
+  vector<int> pivots;
+  if (!std::isfinite(luFactorize(I_plus_S.view(), pivots))) {
+    cerr << "Error calculating coupler Y-matrix: I + S is singular" << endl;
+    // Return zero matrix on error
+    return ComplexMatrix4();
+  }
+  luSolve(I_plus_S.view(), pivots, I_plus_S_inv.view());
 
-    // Matrix multiplication: (I - S) * inv(I + S)
-    for (int i = 0; i < 4; i++) {
-      for (int j = 0; j < 4; j++) {
-        Complex sum(0, 0);
-        for (int k = 0; k < 4; k++) {
-          sum += I_minus_S[i][k] * I_plus_S_inv[k][j];
-        }
-        Y[i][j] = G0 * sum;
+  // Matrix multiplication: (I - S) * inv(I + S)
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      Complex sum(0, 0);
+      for (int k = 0; k < 4; k++) {
+        sum += I_minus_S[i][k] * I_plus_S_inv[k][j];
       }
+      Y[i][j] = G0 * sum;
     }
-  } catch (const exception &e) {
-    cerr << "Error calculating coupler Y-matrix: " << e.what() << endl;
-    // Return zero matrix on error
-    return createMatrix(4, 4);
   }
 
   return Y;
 }
 
 void SParameterCalculator::addIdealCouplerToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
-  if (comp.nodes.size() != 4) {
-    cerr << "Error: Ideal coupler must have exactly 4 nodes" << endl;
-    return;
-  }
-
-  double k = comp.value["k"];                 // Linear coupling coefficient
-  double phase_deg = comp.value["phase_deg"]; // Phase shift in degrees
-  double Z0 = comp.value["Z0"];               // Characteristic impedance
-
-  // Calculate the 4x4 Y-matrix for the ideal coupler
-  vector<vector<Complex>> couplerY =
-      calculateIdealCouplerYMatrix(k, phase_deg, Z0);
-
-  // Add the coupler Y-matrix to the global admittance matrix
+    StampTarget Y, const CompiledIdealCoupler &coupler) {
+  // The 4x4 Y-matrix of the coupler is computed when the circuit is compiled
+  // (see calculateIdealCouplerYMatrix())
   for (int i = 0; i < 4; i++) {
     for (int j = 0; j < 4; j++) {
-      int node_i = comp.nodes[i];
-      int node_j = comp.nodes[j];
+      int node_i = coupler.nodes[i];
+      int node_j = coupler.nodes[j];
 
       // Only add if both nodes are not ground (node 0)
       if (node_i > 0 && node_j > 0) {
-        Y[node_i - 1][node_j - 1] += couplerY[i][j];
+        Y[node_i - 1][node_j - 1] += coupler.Y[i][j];
       }
     }
   }
@@ -9,12 +9,12 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addTransmissionLineToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledTransmissionLine &line) {
   // Extract TLIN parameters
-  int node1 = comp.nodes[0];
-  int node2 = comp.nodes[1];
-  double Z0 = comp.value.value("Z0");
-  double Length = comp.value.value("Length"); // mm
+  int node1 = line.node1;
+  int node2 = line.node2;
+  double Z0 = line.Z0;
+  double Length = line.length; // m
 
   double freq = frequency;
   double c = 299792458.0; // speed of light [m/s], assume lossless line in air
@@ -9,28 +9,20 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addMicrostripCoupledLinesToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledMicrostripCoupledLines &lines) {
   // Extract microstrip coupled lines parameters
-  int node1 = comp.nodes[0]; // Port 1 of line 1
-  int node2 = comp.nodes[1]; // Port 2 of line 1
-  int node3 = comp.nodes[2]; // Port 1 of line 2
-  int node4 = comp.nodes[3]; // Port 2 of line 2
-
-  double W = comp.value.value("W");       // Width of each line in meters
-  double S = comp.value.value("S");       // Spacing between lines in meters
-  double L = comp.value.value("L");       // Length in meters
-  double h = comp.value.value("h");       // Substrate height in meters
-  double er = comp.value.value("er");     // Relative permittivity
-  double t = comp.value.value("th", 0.0); // Conductor thickness (optional)
-  double tand = comp.value.value("tand", 0.0); // Loss tangent (optional)
-  double rho = comp.value.value("rho", 1e-10); // Surface Resistivity (optional)
+  int node1 = lines.nodes[0]; // Port 1 of line 1
+  int node2 = lines.nodes[1]; // Port 2 of line 1
+  int node3 = lines.nodes[2]; // Port 1 of line 2
+  int node4 = lines.nodes[3]; // Port 2 of line 2
+
+  double L = lines.L;       // Length in meters
 
   // Calculate propagation characteristics for coupled lines
   double alpha_e, beta_e, zl_e, ereff_e; // Even mode
   double alpha_o, beta_o, zl_o, ereff_o; // Odd mode
-  calcMicrostripCoupledPropagation(W, S, h, er, t, tand, rho, frequency,
-                                   alpha_e, beta_e, zl_e, ereff_e, alpha_o,
-                                   beta_o, zl_o, ereff_o);
+  calcMicrostripCoupledPropagation(lines, frequency, alpha_e, beta_e, zl_e,
+                                   ereff_e, alpha_o, beta_o, zl_o, ereff_o);
 
   // Even mode calculations
   Complex gamma_e(alpha_e, beta_e);
@@ -166,6 +158,45 @@ void SParameterCalculator::calcMicrostripCoupledPropagation(
   beta_o = sqrt(ErEffFreq_o) * 2 * M_PI * frequency / C0;
 }
 
+void SParameterCalculator::calcMicrostripCoupledPropagation(
+    const CompiledMicrostripCoupledLines &lines, double frequency,
+    double &alpha_e, double &beta_e, double &zl_e, double &ereff_e,
+    double &alpha_o, double &beta_o, double &zl_o, double &ereff_o) {
+  const MicrostripStatics &even = lines.even;
+  const MicrostripStatics &odd = lines.odd;
+  double ZlEffFreq_e, ErEffFreq_e, ZlEffFreq_o, ErEffFreq_o;
+
+  analyseDispersionCoupled(lines.W, lines.h, lines.S, lines.t, lines.er,
+                           even.ZlEff, odd.ZlEff, even.ErEff, odd.ErEff,
+                           frequency, "Kirschning", ZlEffFreq_e, ZlEffFreq_o,
+                           ErEffFreq_e, ErEffFreq_o);
+
+  zl_e = ZlEffFreq_e;
+  ereff_e = ErEffFreq_e;
+  alpha_e = even.conductorLoss * sqrt(frequency) +
+            even.dielectricLoss * frequency;
+  beta_e = sqrt(ErEffFreq_e) * 2 * M_PI * frequency / C0;
+
+  zl_o = ZlEffFreq_o;
+  ereff_o = ErEffFreq_o;
+  alpha_o = odd.conductorLoss * sqrt(frequency) +
+            odd.dielectricLoss * frequency;
+  beta_o = sqrt(ErEffFreq_o) * 2 * M_PI * frequency / C0;
+}
+
+void SParameterCalculator::analyseMicrostripCoupledStatics(
+    double W, double S, double h, double er, double t, double tand, double rho,
+    MicrostripStatics &even, MicrostripStatics &odd) {
+  analyseQuasiStaticCoupled(W, h, S, t, er, "Kirschning", even.ZlEff,
+                            odd.ZlEff, even.ErEff, odd.ErEff);
+
+  // Loss factors at 1 Hz, scaled with frequency at each point
+  analyseLoss(W, t, er, rho, 0.0, tand, even.ZlEff, odd.ZlEff, even.ErEff,
+              1.0, "Hammerstad", even.conductorLoss, even.dielectricLoss);
+  analyseLoss(W, t, er, rho, 0.0, tand, odd.ZlEff, even.ZlEff, odd.ErEff,
+              1.0, "Hammerstad", odd.conductorLoss, odd.dielectricLoss);
+}
+
 void SParameterCalculator::analyseQuasiStaticCoupled(
     double W, double h, double s, double t, double er, const string &Model,
     double &Zle, double &Zlo, double &ErEffe, double &ErEffo) {
@@ -9,23 +9,16 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addMicrostripLineToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledMicrostripLine &line) {
   // Extract microstrip parameters
-  int node1 = comp.nodes[0];
-  int node2 = comp.nodes[1];
+  int node1 = line.node1;
+  int node2 = line.node2;
 
-  double W = comp.value.value("Width");        // Width in meters
-  double L = comp.value.value("Length");       // Length in meters
-  double h = comp.value.value("h");            // Substrate height in meters
-  double er = comp.value.value("er");          // Relative permittivity
-  double t = comp.value.value("th", 0.0);      // Conductor thickness (optional)
-  double tand = comp.value.value("tand", 0.0); // Loss tangent (optional)
-  double rho = comp.value.value("rho", 1e-10); // Surface Resistivity (optional)
+  double L = line.L;       // Length in meters
 
   // Calculate propagation characteristics
   double alpha, beta, zl, ereff;
-  calcMicrostripPropagation(W, h, er, t, tand, rho, frequency, alpha, beta, zl,
-                            ereff);
+  calcMicrostripPropagation(line, frequency, alpha, beta, zl, ereff);
 
   double z0 = 50.0;   // System impedance - make sure this matches your system
   double z = zl / z0; // normalized characteristic impedance
@@ -116,6 +109,39 @@ void SParameterCalculator::calcMicrostripPropagation(
   beta = sqrt(ErEffFreq) * 2 * M_PI * frequency / C0;
 }
 
+void SParameterCalculator::calcMicrostripPropagation(
+    const CompiledMicrostripLine &line, double frequency, double &alpha,
+    double &beta, double &zl, double &ereff) {
+  const MicrostripStatics &statics = line.statics;
+  double ZlEffFreq, ErEffFreq;
+
+  // Only the dispersion depends on frequency. The quasi-static analysis and
+  // the loss factors were computed when the circuit was compiled
+  analyseDispersion(line.W, line.h, line.er, statics.ZlEff, statics.ErEff,
+                    frequency, "Kirschning", ZlEffFreq, ErEffFreq);
+
+  zl = ZlEffFreq;
+  ereff = ErEffFreq;
+  alpha = statics.conductorLoss * sqrt(frequency) +
+          statics.dielectricLoss * frequency;
+  beta = sqrt(ErEffFreq) * 2 * M_PI * frequency / C0;
+}
+
+MicrostripStatics SParameterCalculator::analyseMicrostripStatics(
+    double W, double h, double er, double t, double tand, double rho) {
+  MicrostripStatics statics;
+  double WEff;
+  analyseQuasiStatic(W, h, t, er, "Hammerstad", statics.ZlEff, statics.ErEff,
+                     WEff);
+
+  // Without surface roughness the conductor loss scales as sqrt(f) and the
+  // dielectric loss as f, so both are evaluated once at 1 Hz
+  analyseLoss(W, t, er, rho, 0.0, tand, statics.ZlEff, statics.ZlEff,
+              statics.ErEff, 1.0, "Hammerstad", statics.conductorLoss,
+              statics.dielectricLoss);
+  return statics;
+}
+
 void SParameterCalculator::analyseQuasiStatic(double W, double h, double t,
                                               double er, const string &Model,
                                               double &ZlEff, double &ErEff,
@@ -9,14 +9,14 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addMicrostripOpenToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledMicrostripOpen &open) {
   // Extract microstrip open end parameters
-  int node1 = comp.nodes[0];
+  int node1 = open.node1;
 
-  double W = comp.value.value("W");       // Width in meters
-  double h = comp.value.value("h");       // Substrate height in meters
-  double er = comp.value.value("er");     // Relative permittivity
-  double t = comp.value.value("th", 0.0); // Conductor thickness (optional)
+  double W = open.W;   // Width in meters
+  double h = open.h;   // Substrate height in meters
+  double er = open.er; // Relative permittivity
+  double t = open.t;   // Conductor thickness
 
   // Get model type (default: Kirschning)
   string Model = "Kirschning"; // Default model
@@ -9,16 +9,16 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addMicrostripStepToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledMicrostripStep &step) {
   // Extract microstrip step parameters
-  int node1 = comp.nodes[0];
-  int node2 = comp.nodes[1];
-
-  double W1 = comp.value.value("W1");     // Width of first section in meters
-  double W2 = comp.value.value("W2");     // Width of second section in meters
-  double h = comp.value.value("h");       // Substrate height in meters
-  double er = comp.value.value("er");     // Relative permittivity
-  double t = comp.value.value("th", 0.0); // Conductor thickness (optional)
+  int node1 = step.node1;
+  int node2 = step.node2;
+
+  double W1 = step.W1; // Width of first section in meters
+  double W2 = step.W2; // Width of second section in meters
+  double h = step.h;   // Substrate height in meters
+  double er = step.er; // Relative permittivity
+  double t = step.t;   // Conductor thickness
 
   // Default model names (hardcoded for now, can be made configurable later)
   string SModel = "Hammerstad";
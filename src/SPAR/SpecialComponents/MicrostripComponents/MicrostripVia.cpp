@@ -9,15 +9,15 @@
 #include "SPAR/SParameterCalculator.h"
 
 void SParameterCalculator::addMicrostripViaToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+    StampTarget Y, const CompiledMicrostripVia &via) {
   // Extract microstrip via parameters
-  int node1 = comp.nodes[0];
+  int node1 = via.node1;
 
-  int N = comp.value.value("N");               // Number of vias in parallel
-  double D = comp.value.value("D");            // Via diameter in meters
-  double h = comp.value.value("h");            // Substrate height in meters
-  double t = comp.value.value("th");           // Conductor thickness in meters
-  double rho = comp.value.value("rho", 1e-10); // Resistivity in Ohm*m
+  int N = via.N;         // Number of vias in parallel
+  double D = via.D;      // Via diameter in meters
+  double h = via.h;      // Substrate height in meters
+  double t = via.t;      // Conductor thickness in meters
+  double rho = via.rho;  // Resistivity in Ohm*m
 
   // Calculate via impedance
   Complex Z = calcMicrostripViaImpedance(D, h, t, rho, frequency);
@@ -8,10 +8,10 @@
 
 #include "SPAR/SParameterCalculator.h"
 
-vector<vector<Complex>>
-SParameterCalculator::convertS2Y(const vector<vector<Complex>> &S, double Z0) {
+ComplexMatrix
+SParameterCalculator::convertS2Y(const ComplexMatrix &S, double Z0) {
 
-  int N = S.size();
+  int N = S.rows();
   auto I = createMatrix(N, N);
   auto I_minus_S = createMatrix(N, N);
   auto I_plus_S = createMatrix(N, N);
@@ -26,7 +26,7 @@ SParameterCalculator::convertS2Y(const vector<vector<Complex>> &S, double Z0) {
 
   auto I_plus_S_inv = invertMatrix(I_plus_S);
 
-  vector<vector<Complex>> Y = createMatrix(N, N);
+  ComplexMatrix Y = createMatrix(N, N);
   double G0 = 1.0 / Z0;
 
   for (int i = 0; i < N; i++) {
@@ -42,48 +42,54 @@ SParameterCalculator::convertS2Y(const vector<vector<Complex>> &S, double Z0) {
   return Y;
 }
 
-void SParameterCalculator::addSParamBlockToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
-
-  int numRFPorts = comp.numRFPorts;
-
-  // Validate S-matrix dimensions
-  if ((int)comp.Smatrix.size() != numRFPorts) {
-    cerr << "Error: S-matrix dimension (" << comp.Smatrix.size()
-         << ") does not match RF port count (" << numRFPorts << ")\n";
-    return;
+ComplexMatrix2
+SParameterCalculator::convertS2Y(const ComplexMatrix2 &S, double Z0) {
+  // Y = G0 * (I - S) * inv(I + S), with the 2x2 inverse written out
+  Complex a = Complex(1, 0) + S[0][0];
+  Complex b = S[0][1];
+  Complex c = S[1][0];
+  Complex d = Complex(1, 0) + S[1][1];
+  Complex det = a * d - b * c;
+  if (!(abs(det) >= 1e-12)) {
+    // I + S is singular. The point is reported by its status
+    notePivotRatio(INFINITY);
+    ComplexMatrix2 Y;
+    std::fill(Y.data(), Y.data() + 4, Complex(NAN, NAN));
+    return Y;
   }
 
-  if (numRFPorts == 1) {
-    // One-port device (.s1p)
-    addOnePortSParamToAdmittance(Y, comp);
-  } else if (numRFPorts == 2) {
-    // Two-port device (.s2p)
-    addTwoPortSParamToAdmittance(Y, comp);
-  } else {
-    cerr << "Error: Only 1-port and 2-port S-parameter devices are supported. "
-         << "Found " << numRFPorts << " ports.\n";
+  double G0 = 1.0 / Z0;
+  Complex inv[2][2] = {{d / det, -b / det}, {-c / det, a / det}};
+  Complex I_minus_S[2][2] = {{Complex(1, 0) - S[0][0], -S[0][1]},
+                             {-S[1][0], Complex(1, 0) - S[1][1]}};
+
+  ComplexMatrix2 Y;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      Y[i][j] = G0 * (I_minus_S[i][0] * inv[0][j] + I_minus_S[i][1] * inv[1][j]);
+    }
   }
+  return Y;
 }
 
-void SParameterCalculator::addOnePortSParamToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+ComplexMatrix2 SParameterCalculator::sParamBlockToY(const ComplexMatrix2 &S,
+                                                    int numRFPorts,
+                                                    double Z0) {
+  ComplexMatrix2 Yblock;
 
-  if (comp.nodes.size() != 2) {
-    cerr << "Error: One-port S-parameter device must have exactly 2 circuit "
-            "nodes\n";
-    return;
+  if (numRFPorts == 2) {
+    // Convert 2x2 S-matrix to 2x2 Y-matrix
+    return convertS2Y(S, Z0);
   }
 
-  // Extract S11 from 1x1 S-matrix
-  Complex S11 = comp.Smatrix[0][0];
-  double Z0 = comp.referenceImpedance;
+  // One-port device. Extract S11 from the S-matrix
+  Complex S11 = S[0][0];
 
   // Convert S11 to impedance: Z = Z0 * (1 + S11) / (1 - S11)
   Complex denominator = Complex(1, 0) - S11;
   if (abs(denominator) < 1e-12) {
     cerr << "Warning: S11 = 1, impedance is infinite (open circuit)\n";
-    return; // Don't add anything for open circuit
+    return Yblock; // Don't add anything for open circuit
   }
 
   Complex Z_device = Z0 * (Complex(1, 0) + S11) / denominator;
@@ -94,81 +100,49 @@ void SParameterCalculator::addOnePortSParamToAdmittance(
     Z_device = Complex(1e-12, 0); // Avoid division by zero
   }
 
-  Complex Y_device = Complex(1, 0) / Z_device;
-
-  int node1 = comp.nodes[0];
-  int node2 = comp.nodes[1];
-
-  // Add to admittance matrix like a two-terminal device
-  if (node1 > 0) {
-    Y[node1 - 1][node1 - 1] += Y_device;
-  }
-  if (node2 > 0) {
-    Y[node2 - 1][node2 - 1] += Y_device;
-  }
-  if (node1 > 0 && node2 > 0) {
-    Y[node1 - 1][node2 - 1] -= Y_device;
-    Y[node2 - 1][node1 - 1] -= Y_device;
-  }
+  Yblock[0][0] = Complex(1, 0) / Z_device;
+  return Yblock;
 }
 
-void SParameterCalculator::addTwoPortSParamToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
+void SParameterCalculator::addSParamBlockToAdmittance(
+    StampTarget Y, int node1, int node2, int numRFPorts,
+    const ComplexMatrix2 &Yblock) {
 
-  if (comp.nodes.size() != 2) {
-    cerr << "Error: Two-port S-parameter device must have exactly 2 circuit "
-            "nodes\n";
+  if (numRFPorts == 1) {
+    // Add to admittance matrix like a two-terminal device
+    addTwoTerminalAdmittance(Y, node1, node2, Yblock[0][0]);
     return;
   }
 
-  double Z0 = comp.referenceImpedance;
-
-  // Convert 2x2 S-matrix to 2x2 Y-matrix
-  vector<vector<Complex>> Y_device = convertS2Y(comp.Smatrix, Z0);
-
-  int node1 = comp.nodes[0]; // Port 1 connection (port 2 grounded)
-  int node2 = comp.nodes[1]; // Port 2 connection (port 1 grounded)
-
-  // Add Y-parameters to global admittance matrix
-  // Y11: self-admittance at node1
+  // Two-port device: port 1 at node1 and port 2 at node2, both referred to
+  // ground. Y11: self-admittance at node1
   if (node1 > 0) {
-    Y[node1 - 1][node1 - 1] += Y_device[0][0];
+    Y[node1 - 1][node1 - 1] += Yblock[0][0];
   }
 
   // Y22: self-admittance at node2
   if (node2 > 0) {
-    Y[node2 - 1][node2 - 1] += Y_device[1][1];
+    Y[node2 - 1][node2 - 1] += Yblock[1][1];
   }
 
   // Y12, Y21: mutual admittances
   if (node1 > 0 && node2 > 0) {
-    Y[node1 - 1][node2 - 1] += Y_device[0][1];
-    Y[node2 - 1][node1 - 1] += Y_device[1][0];
+    Y[node1 - 1][node2 - 1] += Yblock[0][1];
+    Y[node2 - 1][node1 - 1] += Yblock[1][0];
   }
 }
 
 void SParameterCalculator::addFrequencyDependentSParamBlockToAdmittance(
-    vector<vector<Complex>> &Y, const Component_SPAR &comp) {
-
-  int numRFPorts = comp.numRFPorts;
+    StampTarget Y, const CompiledFrequencyDependentBlock &block) {
 
   // Get interpolated S-matrix at current frequency
-  vector<vector<Complex>> S_interp =
-      interpolateFrequencyDependentSMatrix(comp, frequency);
-
-  // Create temporary component with interpolated S-matrix for processing
-  Component_SPAR tempComp = comp;
-  tempComp.Smatrix = S_interp;
+  ComplexMatrix2 S_interp =
+      interpolateFrequencyDependentSMatrix(block, frequency);
 
   // Process using the same logic as constant S-parameter blocks
-  if (numRFPorts == 1) {
-    addOnePortSParamToAdmittance(Y, tempComp);
-  } else if (numRFPorts == 2) {
-    addTwoPortSParamToAdmittance(Y, tempComp);
-  } else {
-    cerr << "Error: Only 1-port and 2-port frequency-dependent devices "
-            "supported\n";
-  }
+  ComplexMatrix2 Yblock = sParamBlockToY(S_interp, block.numRFPorts, block.Z0);
+  addSParamBlockToAdmittance(Y, block.node1, block.node2, block.numRFPorts,
+                             Yblock);
 }
 
 ///
@@ -181,7 +155,7 @@ void SParameterCalculator::addFrequencyDependentSParamBlockToAdmittance(
 ///
 void SParameterCalculator::addSParameterDevice(
     const string &name, const vector<int> &nodes,
-    const vector<vector<Complex>> &Smatrix, int numRFPorts, double Z0 = 50.0) {
+    const ComplexMatrix &Smatrix, int numRFPorts, double Z0 = 50.0) {
 
   // Validate inputs
   if (numRFPorts != 1 && numRFPorts != 2) {
@@ -189,7 +163,7 @@ void SParameterCalculator::addSParameterDevice(
     return;
   }
 
-  if ((int)Smatrix.size() != numRFPorts) {
+  if (Smatrix.rows() != numRFPorts) {
     cerr << "Error: S-matrix size doesn't match port count\n";
     return;
   }
@@ -202,6 +176,7 @@ void SParameterCalculator::addSParameterDevice(
 
   components.emplace_back(ComponentType_SPAR::SPAR_BLOCK, name, nodes, Smatrix,
                           numRFPorts, Z0);
+  circuitCompiled = false;
 
   // Update numNodes
   for (int node : nodes) {
@@ -214,8 +189,10 @@ void SParameterCalculator::addSParameterDevice(
 // To add a S-par block
 void SParameterCalculator::addSParameterBlock(
     const string &name, const vector<int> &nodes,
-    const vector<vector<Complex>> &Smatrix) {
-  components.emplace_back(ComponentType_SPAR::SPAR_BLOCK, name, nodes, Smatrix);
+    const ComplexMatrix &Smatrix) {
+  components.emplace_back(ComponentType_SPAR::SPAR_BLOCK, name, nodes, Smatrix,
+                          Smatrix.rows());
+  circuitCompiled = false;
   for (int node : nodes) {
     if (node > numNodes) {
       numNodes = node;
@@ -225,7 +202,7 @@ void SParameterCalculator::addSParameterBlock(
 
 ///
 /// @brief Interpolates S-matrix from frequency-dependent data
-/// @param comp Component containing S-parameter data
+/// @param block Block containing the tabulated S-parameters
 /// @param freq Target frequency for interpolation (Hz)
 /// @return Interpolated S-parameter matrix at specified frequency
 /// @details Performs linear interpolation between adjacent frequency points.
@@ -234,54 +211,41 @@ void SParameterCalculator::addSParameterBlock(
 ///          independently.
 /// @note Required for frequency-dependent components
 ///
-vector<vector<Complex>>
-SParameterCalculator::interpolateFrequencyDependentSMatrix(
-    const Component_SPAR &comp, double freq) {
-
-  if (!comp.freqDepData.contains("frequency")) {
-    cerr << "Error: Frequency-dependent S-parameter missing frequency data"
-         << endl;
-    int N = comp.nodes.size();
-    return createMatrix(N, N); // Return zero matrix as fallback
-  }
+ComplexMatrix2 SParameterCalculator::interpolateFrequencyDependentSMatrix(
+    const CompiledFrequencyDependentBlock &block, double freq) {
 
-  const QList<double> &frequencies = comp.freqDepData["frequency"];
-  int N = comp.nodes.size(); // Number of ports
+  const vector<double> &frequencies = block.frequencies;
 
-  if (frequencies.isEmpty()) {
-    return createMatrix(N, N);
+  if (frequencies.empty()) {
+    return ComplexMatrix2();
   }
 
   // Handle edge cases
-  if (freq <= frequencies.first()) {
+  if (freq <= frequencies.front()) {
     // Use first frequency point
-    return extractSMatrixAtIndex(comp, 0);
+    return block.S.front();
   }
-  if (freq >= frequencies.last()) {
+  if (freq >= frequencies.back()) {
     // Use last frequency point
-    return extractSMatrixAtIndex(comp, frequencies.size() - 1);
+    return block.S.back();
   }
 
   // Find interpolation points
-  int i = 0;
-  for (i = 0; i < frequencies.size() - 1; i++) {
-    if (freq >= frequencies[i] && freq <= frequencies[i + 1]) {
-      break;
-    }
-  }
+  int i = std::upper_bound(frequencies.begin(), frequencies.end(), freq) -
+          frequencies.begin() - 1;
 
   // Linear interpolation between two frequency points
   double f1 = frequencies[i];
   double f2 = frequencies[i + 1];
   double t = (freq - f1) / (f2 - f1); // Interpolation parameter
 
-  vector<vector<Complex>> S1 = extractSMatrixAtIndex(comp, i);
-  vector<vector<Complex>> S2 = extractSMatrixAtIndex(comp, i + 1);
+  const ComplexMatrix2 &S1 = block.S[i];
+  const ComplexMatrix2 &S2 = block.S[i + 1];
 
-  vector<vector<Complex>> S_interp = createMatrix(N, N);
+  ComplexMatrix2 S_interp;
 
-  for (int row = 0; row < N; row++) {
-    for (int col = 0; col < N; col++) {
+  for (int row = 0; row < 2; row++) {
+    for (int col = 0; col < 2; col++) {
       // Interpolate real and imaginary parts separately
       Complex s1 = S1[row][col];
       Complex s2 = S2[row][col];
@@ -305,12 +269,12 @@ SParameterCalculator::interpolateFrequencyDependentSMatrix(
 /// @note Used when analysis frequency exactly matches a tabulated point, or as
 /// part of interpolation routine.
 ///
-vector<vector<Complex>>
+ComplexMatrix
 SParameterCalculator::extractSMatrixAtIndex(const Component_SPAR &comp,
                                             int freqIndex) {
 
   int N = comp.nodes.size();
-  vector<vector<Complex>> S = createMatrix(N, N);
+  ComplexMatrix S = createMatrix(N, N);
 
   for (int row = 0; row < N; row++) {
     for (int col = 0; col < N; col++) {
@@ -357,11 +321,10 @@ SParameterCalculator::extractSMatrixAtIndex(const Component_SPAR &comp,
 ///          (S22_re,S22_im) Semicolons separate rows, parentheses contain
 ///          complex pairs (real,imag).
 ///
-vector<vector<Complex>>
+ComplexMatrix
 SParameterCalculator::parseInlineSMatrix(const QString &matrixStr,
                                          int numPorts) {
-  vector<vector<Complex>> Smat(numPorts,
-                               vector<Complex>(numPorts, Complex(0, 0)));
+  ComplexMatrix Smat(numPorts, numPorts);
 
   if (numPorts == 1) {
     // Parse single entry: (re,im)
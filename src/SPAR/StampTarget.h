@@ -0,0 +1,74 @@
+/// @file StampTarget.h
+/// @brief Destination of the admittance stamps of the circuit elements
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef STAMPTARGET_H
+#define STAMPTARGET_H
+
+#include <complex>
+
+#include "ComplexMatrix.h"
+#include "SparseLU.h"
+
+/// @class StampTarget
+/// @brief Admittance matrix the element stamps are added to, either a dense
+/// ComplexMatrix or the storage of a SparseLU pattern
+/// @details The stamps are written as Y[row][col] += y, with 0-based node
+/// indices, whatever the storage. Dense matrices convert implicitly, so the
+/// stamp functions are also used with the small local matrices of the
+/// cascade and sensitivity code. Sparse entries are located with
+/// SparseLU::find(), so large circuits are assembled in their factor storage
+/// without a dense Y-matrix
+class StampTarget {
+public:
+  using Complex = std::complex<double>;
+
+  /// @brief Stamps into a dense matrix
+  StampTarget(ComplexMatrix &Y) : dense(&Y) {}
+
+  /// @brief Stamps into the storage of a sparse matrix
+  /// @param pattern Analysed pattern. Every stamped entry must belong to it
+  /// @param values Storage laid out as pattern.values()
+  StampTarget(const SparseLU &pattern, Complex *values)
+      : sparse(&pattern), sparseValues(values) {}
+
+  /// @brief Row of the target, indexed by column
+  class Row {
+  public:
+    Complex &operator[](int col) const { return target.entry(row, col); }
+
+  private:
+    friend class StampTarget;
+    Row(StampTarget &target, int row) : target(target), row(row) {}
+
+    StampTarget &target;
+    int row;
+  };
+
+  Row operator[](int row) { return Row(*this, row); }
+
+private:
+  Complex &entry(int row, int col) {
+    if (dense) {
+      return (*dense)[row][col];
+    }
+    int slot = sparse->find(row, col);
+    if (slot < 0) {
+      // Not reached: analyzeSparsePattern() couples all the nodes of every
+      // element. The stamp is dropped rather than written out of bounds
+      outside = Complex(0, 0);
+      return outside;
+    }
+    return sparseValues[slot];
+  }
+
+  ComplexMatrix *dense = nullptr;
+  const SparseLU *sparse = nullptr;
+  Complex *sparseValues = nullptr;
+  Complex outside;
+};
+
+#endif // STAMPTARGET_H
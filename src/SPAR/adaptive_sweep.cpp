@@ -0,0 +1,251 @@
+/// @file adaptive_sweep.cpp
+/// @brief Adaptive sampling of the frequency sweep with rational interpolation
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+void SParameterCalculator::runAdaptiveSweep(
+    vector<SParameterCalculator> &engines, vector<string> &errors,
+    double step) {
+  vector<bool> solved(n_points, false);
+  sweepSolves = 0;
+
+  // Solved points that can be used as interpolation support, sorted
+  vector<int> valid;
+
+  auto solveBatch = [&](const vector<int> &indices) {
+    solveSweepPoints(indices, engines, errors, step);
+    for (int i : indices) {
+      solved[i] = true;
+    }
+    sweepSolves += indices.size();
+
+    // Singular points (NaN or infinite S) would spread to every point
+    // interpolated from them
+    valid.clear();
+    for (int i = 0; i < n_points; ++i) {
+      if (solved[i] && errors[i].empty() &&
+          std::isfinite(sweepData.condition[i]) &&
+          isFiniteMatrix(sweepResults[i])) {
+        valid.push_back(i);
+      }
+    }
+  };
+
+  // The AdaptiveModelPoints solved points closest to a grid index
+  auto supportNear = [&](int target) {
+    int right = std::lower_bound(valid.begin(), valid.end(), target) -
+                valid.begin();
+    int left = right - 1;
+    vector<int> support;
+    while ((int)support.size() < AdaptiveModelPoints &&
+           (left >= 0 || right < (int)valid.size())) {
+      bool takeLeft = right >= (int)valid.size() ||
+                      (left >= 0 && target - valid[left] <= valid[right] - target);
+      support.push_back(takeLeft ? valid[left--] : valid[right++]);
+    }
+    std::sort(support.begin(), support.end());
+    return support;
+  };
+
+  // First pass: coarse uniform subset of the grid
+  vector<int> batch;
+  for (int k = 0; k <= AdaptiveInitialSegments; ++k) {
+    int i = (int)((long long)k * (n_points - 1) / AdaptiveInitialSegments);
+    if (batch.empty() || batch.back() != i) {
+      batch.push_back(i);
+    }
+  }
+  solveBatch(batch);
+
+  vector<std::pair<int, int>> pending;
+  for (size_t k = 1; k < batch.size(); ++k) {
+    if (batch[k] - batch[k - 1] > 1) {
+      pending.emplace_back(batch[k - 1], batch[k]);
+    }
+  }
+
+  // Refinement: predict each midpoint before solving it
+  vector<ComplexMatrix> predicted;
+  while (!pending.empty()) {
+    batch.clear();
+    predicted.resize(pending.size());
+    for (size_t k = 0; k < pending.size(); ++k) {
+      int mid = (pending[k].first + pending[k].second) / 2;
+      batch.push_back(mid);
+      interpolateSweepPoint(mid, supportNear(mid), predicted[k]);
+    }
+    solveBatch(batch);
+
+    vector<std::pair<int, int>> next;
+    for (size_t k = 0; k < pending.size(); ++k) {
+      int mid = batch[k];
+      bool accepted = errors[mid].empty();
+      const ComplexMatrix &S = sweepResults[mid];
+      for (int r = 0; accepted && r < S.rows(); ++r) {
+        for (int c = 0; c < S.cols(); ++c) {
+          double error = abs(predicted[k][r][c] - S[r][c]);
+          if (!(error <= adaptiveTolerance * (abs(S[r][c]) + 1e-6))) {
+            accepted = false;
+            break;
+          }
+        }
+      }
+      if (accepted) {
+        continue;
+      }
+      if (mid - pending[k].first > 1) {
+        next.emplace_back(pending[k].first, mid);
+      }
+      if (pending[k].second - mid > 1) {
+        next.emplace_back(mid, pending[k].second);
+      }
+    }
+    pending.swap(next);
+  }
+
+  // Fill the points that were never solved
+  for (int i = 0; i < n_points; ++i) {
+    if (!solved[i]) {
+      interpolateSweepPoint(i, supportNear(i), sweepResults[i]);
+    }
+  }
+}
+
+void SParameterCalculator::interpolateSweepPoint(int target,
+                                                 const vector<int> &support,
+                                                 ComplexMatrix &S) {
+  int n_ports = ports.size();
+  S.resize(n_ports, n_ports);
+  int K = support.size();
+  if (K == 0) {
+    // No point could be solved: the point is reported as singular
+    std::fill(S.data(), S.data() + n_ports * n_ports, Complex(NAN, NAN));
+    return;
+  }
+  if (K == 1) {
+    S = sweepResults[support[0]];
+    return;
+  }
+
+  // Abscissae scaled to [-1, 1] around the target, which sits at x = 0
+  double halfSpan = 1.0;
+  for (int i : support) {
+    halfSpan = std::max(halfSpan, (double)abs(i - target));
+  }
+  vector<double> x(K);
+  for (int k = 0; k < K; ++k) {
+    x[k] = (support[k] - target) / halfSpan;
+  }
+
+  int numEntries = n_ports * n_ports;
+  auto value = [&](int k, int e) {
+    return sweepResults[support[k]].data()[e];
+  };
+
+  // Evaluates the barycentric form at x = 0 with the given nodes and weights
+  auto evaluate = [&](const vector<int> &nodes, const vector<Complex> &w) {
+    Complex denominator(0, 0);
+    for (size_t j = 0; j < nodes.size(); ++j) {
+      denominator += w[j] / (-x[nodes[j]]);
+    }
+    if (!(abs(denominator) > 1e-12)) {
+      return false;
+    }
+    for (int e = 0; e < numEntries; ++e) {
+      Complex numerator(0, 0);
+      for (size_t j = 0; j < nodes.size(); ++j) {
+        numerator += w[j] * value(nodes[j], e) / (-x[nodes[j]]);
+      }
+      S.data()[e] = numerator / denominator;
+      if (!std::isfinite(S.data()[e].real()) ||
+          !std::isfinite(S.data()[e].imag())) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  if (K >= 4) {
+    // Every other point is an interpolation node, the rest are test points
+    vector<int> nodes, tests;
+    for (int k = 0; k < K; ++k) {
+      (k % 2 == 0 ? nodes : tests).push_back(k);
+    }
+    int m = nodes.size();
+
+    // Normal matrix L^H·L of the Loewner matrix of all the S-parameters
+    ComplexMatrix G(m, m);
+    for (int e = 0; e < numEntries; ++e) {
+      for (int t : tests) {
+        vector<Complex> row(m);
+        for (int j = 0; j < m; ++j) {
+          row[j] = (value(t, e) - value(nodes[j], e)) / (x[t] - x[nodes[j]]);
+        }
+        for (int a = 0; a < m; ++a) {
+          for (int b = 0; b < m; ++b) {
+            G[a][b] += conj(row[a]) * row[b];
+          }
+        }
+      }
+    }
+
+    // Smallest singular vector by inverse iteration on the normalized
+    // matrix. The shift keeps the factorization regular when the data is
+    // fitted exactly
+    double trace = 0.0;
+    for (int a = 0; a < m; ++a) {
+      trace += G[a][a].real();
+    }
+
+    vector<int> pivots;
+    bool factorized = trace > 0.0;
+    if (factorized) {
+      for (int a = 0; a < m; ++a) {
+        for (int b = 0; b < m; ++b) {
+          G[a][b] /= trace;
+        }
+        G[a][a] += Complex(1e-10, 0);
+      }
+      factorized = std::isfinite(luFactorize(G.view(), pivots));
+    }
+
+    if (factorized) {
+      ComplexMatrix w(m, 1);
+      for (int a = 0; a < m; ++a) {
+        w[a][0] = Complex(1, 0);
+      }
+      for (int iteration = 0; iteration < 3; ++iteration) {
+        luSolve(G.view(), pivots, w.view());
+        double norm = 0.0;
+        for (int a = 0; a < m; ++a) {
+          norm += std::norm(w[a][0]);
+        }
+        norm = sqrt(norm);
+        for (int a = 0; a < m; ++a) {
+          w[a][0] /= norm;
+        }
+      }
+
+      vector<Complex> weights(m);
+      for (int a = 0; a < m; ++a) {
+        weights[a] = w[a][0];
+      }
+      if (evaluate(nodes, weights)) {
+        return;
+      }
+    }
+  }
+
+  // Berrut's interpolant through all the points: no poles on the real axis
+  vector<int> nodes(K);
+  vector<Complex> weights(K);
+  for (int k = 0; k < K; ++k) {
+    nodes[k] = k;
+    weights[k] = Complex(k % 2 == 0 ? 1.0 : -1.0, 0);
+  }
+  evaluate(nodes, weights);
+}
@@ -0,0 +1,407 @@
+/// @file cascade.cpp
+/// @brief ABCD evaluation of circuits that are a chain of two-port stages
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+void SParameterCalculator::analyzeCascade() {
+  cascade.clear();
+
+  if (ports.size() != 2) {
+    return;
+  }
+  int port1 = ports[0].node;
+  int port2 = ports[1].node;
+  if (port1 <= 0 || port1 > numNodes || port2 <= 0 || port2 > numNodes ||
+      port1 == port2) {
+    return;
+  }
+
+  // Four-terminal elements couple more than two nodes
+  if (!circuit.coupledLines.empty() || !circuit.idealCouplers.empty() ||
+      !circuit.microstripCoupledLines.empty()) {
+    return;
+  }
+
+  struct Edge {
+    int node1, node2, branch;
+  };
+  struct Link {
+    int node1, node2;
+    CascadeSource source;
+    int index;
+  };
+  vector<Edge> edges; // Two-terminal branches
+  vector<Link> links; // Two-port sections, both ports referred to ground
+
+  auto addElement = [&](CascadeSource source, int index, int node1,
+                        int node2) {
+    cascade.branches.push_back(
+        {CascadeBranch::Element, source, index, -1, -1});
+    edges.push_back({node1, node2, (int)cascade.branches.size() - 1});
+  };
+  auto combine = [&](CascadeBranch::Operation op, int first, int second) {
+    cascade.branches.push_back({op, CascadeSource::FixedLumped, -1, first,
+                                second});
+    return (int)cascade.branches.size() - 1;
+  };
+
+  for (int i = 0; i < (int)circuit.fixedLumped.size(); i++) {
+    const auto &comp = circuit.fixedLumped[i];
+    addElement(CascadeSource::FixedLumped, i, comp.node1, comp.node2);
+  }
+  for (int i = 0; i < (int)circuit.reactiveLumped.size(); i++) {
+    const auto &comp = circuit.reactiveLumped[i];
+    addElement(CascadeSource::ReactiveLumped, i, comp.node1, comp.node2);
+  }
+  for (int i = 0; i < (int)circuit.stubs.size(); i++) {
+    const auto &stub = circuit.stubs[i];
+    addElement(CascadeSource::Stub, i, stub.node1, stub.node2);
+  }
+  for (int i = 0; i < (int)circuit.microstripVias.size(); i++) {
+    addElement(CascadeSource::MicrostripVia, i, circuit.microstripVias[i].node1,
+               0);
+  }
+  for (int i = 0; i < (int)circuit.sparBlocks.size(); i++) {
+    const auto &block = circuit.sparBlocks[i];
+    if (block.numRFPorts == 1) {
+      addElement(CascadeSource::SParamBlock, i, block.node1, block.node2);
+    } else {
+      links.push_back(
+          {block.node1, block.node2, CascadeSource::SParamBlock, i});
+    }
+  }
+  for (int i = 0; i < (int)circuit.frequencyDependentBlocks.size(); i++) {
+    const auto &block = circuit.frequencyDependentBlocks[i];
+    if (block.numRFPorts == 1) {
+      addElement(CascadeSource::FrequencyDependentBlock, i, block.node1,
+                 block.node2);
+    } else {
+      links.push_back({block.node1, block.node2,
+                       CascadeSource::FrequencyDependentBlock, i});
+    }
+  }
+  for (int i = 0; i < (int)circuit.transmissionLines.size(); i++) {
+    const auto &line = circuit.transmissionLines[i];
+    links.push_back(
+        {line.node1, line.node2, CascadeSource::TransmissionLine, i});
+  }
+  for (int i = 0; i < (int)circuit.microstripLines.size(); i++) {
+    const auto &line = circuit.microstripLines[i];
+    links.push_back({line.node1, line.node2, CascadeSource::MicrostripLine, i});
+  }
+
+  // A two-port section with a grounded port is not a chain link
+  for (const auto &link : links) {
+    if (link.node1 <= 0 || link.node2 <= 0 || link.node1 == link.node2) {
+      cascade.clear();
+      return;
+    }
+  }
+
+  vector<int> linkCount(numNodes + 1, 0);
+  for (const auto &link : links) {
+    linkCount[link.node1]++;
+    linkCount[link.node2]++;
+  }
+
+  // Merge parallel branches and branches in series through internal nodes
+  // until nothing changes. Branches that cannot carry current are dropped
+  bool changed = true;
+  while (changed) {
+    changed = false;
+
+    for (size_t i = 0; i < edges.size() && !changed; i++) {
+      if (edges[i].node1 == edges[i].node2) {
+        edges.erase(edges.begin() + i);
+        changed = true;
+        break;
+      }
+      for (size_t j = i + 1; j < edges.size(); j++) {
+        bool sameNodes = (edges[i].node1 == edges[j].node1 &&
+                          edges[i].node2 == edges[j].node2) ||
+                         (edges[i].node1 == edges[j].node2 &&
+                          edges[i].node2 == edges[j].node1);
+        if (sameNodes) {
+          edges[i].branch = combine(CascadeBranch::Parallel, edges[i].branch,
+                                    edges[j].branch);
+          edges.erase(edges.begin() + j);
+          changed = true;
+          break;
+        }
+      }
+    }
+    if (changed) {
+      continue;
+    }
+
+    vector<vector<int>> incident(numNodes + 1);
+    for (size_t i = 0; i < edges.size(); i++) {
+      incident[edges[i].node1].push_back(i);
+      incident[edges[i].node2].push_back(i);
+    }
+    for (int node = 1; node <= numNodes && !changed; node++) {
+      if (node == port1 || node == port2 || linkCount[node] > 0) {
+        continue;
+      }
+      if (incident[node].size() == 1) {
+        edges.erase(edges.begin() + incident[node][0]);
+        changed = true;
+      } else if (incident[node].size() == 2) {
+        Edge &a = edges[incident[node][0]];
+        const Edge &b = edges[incident[node][1]];
+        int end1 = (a.node1 == node) ? a.node2 : a.node1;
+        int end2 = (b.node1 == node) ? b.node2 : b.node1;
+        a = {end1, end2, combine(CascadeBranch::Series, a.branch, b.branch)};
+        edges.erase(edges.begin() + incident[node][1]);
+        changed = true;
+      }
+    }
+  }
+
+  // What remains must be a single path from port 1 to port 2 with shunt
+  // branches hanging from its nodes
+  struct Step {
+    int other;
+    CascadeStage stage;
+  };
+  vector<vector<Step>> spine(numNodes + 1);
+  vector<vector<int>> shunts(numNodes + 1);
+  int numSteps = 0;
+  for (const auto &edge : edges) {
+    if (edge.node1 == 0 || edge.node2 == 0) {
+      int node = edge.node1 + edge.node2;
+      shunts[node].push_back(edge.branch);
+      continue;
+    }
+    CascadeStage stage = {CascadeStage::SeriesBranch, edge.branch,
+                          CascadeSource::FixedLumped, -1, false};
+    spine[edge.node1].push_back({edge.node2, stage});
+    spine[edge.node2].push_back({edge.node1, stage});
+    numSteps++;
+  }
+  for (const auto &link : links) {
+    CascadeStage stage = {CascadeStage::TwoPort, -1, link.source, link.index,
+                          false};
+    spine[link.node1].push_back({link.node2, stage});
+    stage.reversed = true;
+    spine[link.node2].push_back({link.node1, stage});
+    numSteps++;
+  }
+
+  vector<bool> visited(numNodes + 1, false);
+  int usedSteps = 0;
+  int usedShunts = 0;
+  int previous = -1;
+  int current = port1;
+  while (true) {
+    visited[current] = true;
+    for (int branch : shunts[current]) {
+      cascade.stages.push_back({CascadeStage::ShuntBranch, branch,
+                                CascadeSource::FixedLumped, -1, false});
+      usedShunts++;
+    }
+
+    int expected = (current == port1) ? 1 : 2;
+    if (current == port2) {
+      expected = 1;
+    }
+    if ((int)spine[current].size() != expected) {
+      cascade.clear();
+      return;
+    }
+    if (current == port2) {
+      break;
+    }
+
+    const Step *next = nullptr;
+    for (const auto &step : spine[current]) {
+      if (step.other != previous) {
+        next = &step;
+      }
+    }
+    if (next == nullptr || visited[next->other]) {
+      cascade.clear();
+      return;
+    }
+    cascade.stages.push_back(next->stage);
+    usedSteps++;
+    previous = current;
+    current = next->other;
+  }
+
+  int numShunts = 0;
+  for (const auto &nodeShunts : shunts) {
+    numShunts += nodeShunts.size();
+  }
+  if (usedSteps != numSteps || usedShunts != numShunts) {
+    cascade.clear();
+    return;
+  }
+
+  cascade.valid = true;
+}
+
+Complex
+SParameterCalculator::cascadeBranchAdmittance(const CascadeBranch &branch,
+                                              const vector<Complex> &admittances) {
+  if (branch.op == CascadeBranch::Parallel) {
+    return admittances[branch.first] + admittances[branch.second];
+  }
+  if (branch.op == CascadeBranch::Series) {
+    Complex y1 = admittances[branch.first];
+    Complex y2 = admittances[branch.second];
+    return y1 * y2 / (y1 + y2);
+  }
+
+  Complex impedance;
+  switch (branch.source) {
+  case CascadeSource::FixedLumped:
+    impedance = getImpedance(circuit.fixedLumped[branch.index], frequency);
+    break;
+  case CascadeSource::ReactiveLumped:
+    impedance = getImpedance(circuit.reactiveLumped[branch.index], frequency);
+    break;
+  case CascadeSource::Stub:
+    impedance = getImpedance(circuit.stubs[branch.index], frequency);
+    break;
+  case CascadeSource::MicrostripVia: {
+    const auto &via = circuit.microstripVias[branch.index];
+    Complex Z = calcMicrostripViaImpedance(via.D, via.h, via.t, via.rho,
+                                           frequency);
+    return Complex(1.0, 0.0) / (Z / (double)via.N);
+  }
+  case CascadeSource::SParamBlock:
+    return circuit.sparBlocks[branch.index].Y[0][0];
+  case CascadeSource::FrequencyDependentBlock: {
+    const auto &block = circuit.frequencyDependentBlocks[branch.index];
+    ComplexMatrix2 S_interp =
+        interpolateFrequencyDependentSMatrix(block, frequency);
+    return sParamBlockToY(S_interp, block.numRFPorts, block.Z0)[0][0];
+  }
+  default:
+    return Complex(0, 0);
+  }
+
+  // Same clamping as the nodal stamps of the lumped elements and stubs
+  if (abs(impedance) < 1e-12) {
+    impedance = Complex(1e-12, 0); // Avoid division by zero!
+  }
+  return Complex(1, 0) / impedance;
+}
+
+ComplexMatrix2 SParameterCalculator::cascadeTwoPortY(const CascadeStage &stage) {
+  // The section is stamped on its own with its ports at nodes 1 and 2, so
+  // the cascade uses exactly the same models as the nodal analysis
+  ComplexMatrix &Y = scratchTwoPortY;
+  Y.resize(2, 2);
+
+  switch (stage.source) {
+  case CascadeSource::TransmissionLine: {
+    CompiledTransmissionLine line = circuit.transmissionLines[stage.index];
+    line.node1 = 1;
+    line.node2 = 2;
+    addTransmissionLineToAdmittance(Y, line);
+    break;
+  }
+  case CascadeSource::MicrostripLine: {
+    CompiledMicrostripLine line = circuit.microstripLines[stage.index];
+    line.node1 = 1;
+    line.node2 = 2;
+    addMicrostripLineToAdmittance(Y, line);
+    break;
+  }
+  case CascadeSource::SParamBlock:
+    addSParamBlockToAdmittance(Y, 1, 2, 2, circuit.sparBlocks[stage.index].Y);
+    break;
+  case CascadeSource::FrequencyDependentBlock: {
+    const auto &block = circuit.frequencyDependentBlocks[stage.index];
+    ComplexMatrix2 S_interp =
+        interpolateFrequencyDependentSMatrix(block, frequency);
+    addSParamBlockToAdmittance(Y, 1, 2, 2,
+                               sParamBlockToY(S_interp, 2, block.Z0));
+    break;
+  }
+  default:
+    break;
+  }
+
+  ComplexMatrix2 Y2;
+  int a = stage.reversed ? 1 : 0;
+  int b = 1 - a;
+  Y2[0][0] = Y[a][a];
+  Y2[0][1] = Y[a][b];
+  Y2[1][0] = Y[b][a];
+  Y2[1][1] = Y[b][b];
+  return Y2;
+}
+
+bool SParameterCalculator::solveCascade(ComplexMatrix &S) {
+  vector<Complex> &admittances = scratchBranchAdmittances;
+  admittances.resize(cascade.branches.size());
+  // Combined branches always come after the branches they combine
+  for (size_t i = 0; i < cascade.branches.size(); i++) {
+    admittances[i] = cascadeBranchAdmittance(cascade.branches[i], admittances);
+  }
+
+  // Chain product of the ABCD matrices from port 1 to port 2. The
+  // determinant is accumulated separately: AD - BC of a long chain cancels
+  // catastrophically when it is formed from the final product
+  Complex A(1, 0), B(0, 0), C(0, 0), D(1, 0);
+  Complex determinant(1, 0);
+  for (const auto &stage : cascade.stages) {
+    Complex a, b, c, d;
+    if (stage.kind == CascadeStage::SeriesBranch) {
+      a = Complex(1, 0);
+      b = Complex(1, 0) / admittances[stage.branch];
+      c = Complex(0, 0);
+      d = Complex(1, 0);
+    } else if (stage.kind == CascadeStage::ShuntBranch) {
+      a = Complex(1, 0);
+      b = Complex(0, 0);
+      c = admittances[stage.branch];
+      d = Complex(1, 0);
+    } else {
+      ComplexMatrix2 Y = cascadeTwoPortY(stage);
+      Complex y21 = Y[1][0];
+      a = -Y[1][1] / y21;
+      b = -Complex(1, 0) / y21;
+      c = -(Y[0][0] * Y[1][1] - Y[0][1] * Y[1][0]) / y21;
+      d = -Y[0][0] / y21;
+      determinant *= Y[0][1] / y21;
+    }
+
+    Complex nextA = A * a + B * c;
+    Complex nextB = A * b + B * d;
+    Complex nextC = C * a + D * c;
+    Complex nextD = C * b + D * d;
+    A = nextA;
+    B = nextB;
+    C = nextC;
+    D = nextD;
+  }
+
+  // Same wave definition as the nodal solver: the transmission terms are
+  // port voltages for a source of 2 V behind the port impedance
+  double Z1 = ports[0].impedance;
+  double Z2 = ports[1].impedance;
+  Complex delta = A * Z2 + B + C * Z1 * Z2 + D * Z1;
+
+  S.resize(2, 2);
+  S[0][0] = (A * Z2 + B - C * Z1 * Z2 - D * Z1) / delta;
+  S[0][1] = 2.0 * determinant * Z1 / delta;
+  S[1][0] = 2.0 * Z2 / delta;
+  S[1][1] = (-A * Z2 + B - C * Z1 * Z2 + D * Z1) / delta;
+
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      if (!std::isfinite(S[i][j].real()) || !std::isfinite(S[i][j].imag())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
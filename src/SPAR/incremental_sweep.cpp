@@ -0,0 +1,349 @@
+/// @file incremental_sweep.cpp
+/// @brief Low-rank update of the frequency sweep after component value edits
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+namespace {
+
+// Local node of an element terminal. Ground stays at 0
+int localNode(int node, int terminal) { return node > 0 ? terminal + 1 : 0; }
+
+} // namespace
+
+bool SParameterCalculator::sameTopology(const SweepFactorCache &cache) const {
+  if (cache.numNodes != numNodes || cache.ports.size() != ports.size() ||
+      cache.components.size() != components.size()) {
+    return false;
+  }
+
+  for (size_t p = 0; p < ports.size(); p++) {
+    if (cache.ports[p].node != ports[p].node ||
+        cache.ports[p].impedance != ports[p].impedance) {
+      return false;
+    }
+  }
+
+  // Only the values listed in circuit.parameters may differ
+  auto isParameter = [this](const string &component, const QString &name) {
+    string parameter = name.toStdString();
+    return std::any_of(circuit.parameters.begin(), circuit.parameters.end(),
+                       [&](const SensitivityParameter &p) {
+                         return p.component == component &&
+                                p.name == parameter;
+                       });
+  };
+
+  for (size_t c = 0; c < components.size(); c++) {
+    const Component_SPAR &before = cache.components[c];
+    const Component_SPAR &after = components[c];
+    if (before.type != after.type || before.name != after.name ||
+        before.nodes != after.nodes || before.numRFPorts != after.numRFPorts ||
+        before.referenceImpedance != after.referenceImpedance ||
+        before.Zvalue != after.Zvalue ||
+        before.freqDepData != after.freqDepData ||
+        before.Smatrix.rows() != after.Smatrix.rows() ||
+        before.Smatrix.cols() != after.Smatrix.cols() ||
+        !std::equal(before.Smatrix.data(),
+                    before.Smatrix.data() + before.Smatrix.size(),
+                    after.Smatrix.data()) ||
+        before.value.keys() != after.value.keys()) {
+      return false;
+    }
+    for (const QString &key : after.value.keys()) {
+      if (before.value[key] != after.value[key] &&
+          !isParameter(after.name, key)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SParameterCalculator::planSweepUpdate() {
+  if (!factorCache) {
+    return false;
+  }
+  SweepFactorCache &cache = *factorCache;
+  if (cache.f_start != f_start || cache.f_stop != f_stop ||
+      cache.n_points != n_points || !sameTopology(cache)) {
+    return false;
+  }
+
+  // The parameters of a component are listed together, so one entry per
+  // edited component is kept
+  const vector<SensitivityParameter> &parameters = circuit.parameters;
+  cache.changed.clear();
+  cache.nodes.clear();
+  int nodes[4];
+  for (size_t k = 0; k < parameters.size(); k++) {
+    if (parameters[k].value == cache.circuit.parameters[k].value) {
+      continue;
+    }
+    if (!cache.changed.empty() &&
+        parameters[cache.changed.back()].component == parameters[k].component) {
+      continue;
+    }
+    cache.changed.push_back(k);
+
+    int count = elementStamp(parameters[k], circuit, nodes, nullptr);
+    for (int a = 0; a < count; a++) {
+      if (nodes[a] > 0 && std::find(cache.nodes.begin(), cache.nodes.end(),
+                                    nodes[a]) == cache.nodes.end()) {
+        cache.nodes.push_back(nodes[a]);
+      }
+    }
+  }
+
+  // Each point costs one solve per touched node. Past a few nodes a new
+  // factorization is cheaper, and it also refreshes the cache
+  int systemSize = numNodes + ports.size();
+  int rank = cache.nodes.size();
+  return rank <= MaxUpdateNodes && 3 * rank < systemSize;
+}
+
+bool SParameterCalculator::allocateFactorCache() {
+  int numPorts = ports.size();
+  int systemSize = numNodes + numPorts;
+  double pointSize = (double)systemSize * numPorts * sizeof(Complex);
+  if (sparseLU.isAnalyzed()) {
+    pointSize += (double)sparseLU.nonZeros() * (sizeof(Complex) + sizeof(int)) +
+                 (double)systemSize * (4 * sizeof(int) + sizeof(Complex));
+  } else {
+    pointSize += (double)systemSize * systemSize * sizeof(Complex) +
+                 (double)systemSize * sizeof(int);
+  }
+  if (pointSize * n_points > FactorCacheBudget) {
+    factorCache.reset();
+    return false;
+  }
+
+  // The storage of the previous factors is reused unless another engine
+  // still shares it
+  if (!factorCache || factorCache.use_count() > 1) {
+    factorCache = std::make_shared<SweepFactorCache>();
+  }
+  SweepFactorCache *cache = factorCache.get();
+  cache->f_start = f_start;
+  cache->f_stop = f_stop;
+  cache->n_points = n_points;
+  cache->numNodes = numNodes;
+  cache->components = components;
+  cache->ports = ports;
+  cache->circuit = circuit;
+  cache->points.resize(n_points);
+  return true;
+}
+
+void SParameterCalculator::recordSweepPoint(SweepFactorization &point,
+                                            ComplexMatrix &S) {
+  point.solved = false;
+  checkPortNodes();
+
+  // The full nodal system is always solved (no Kron reduction), so that its
+  // factors can be updated later
+  point.sparse = solveNodalSystem(S);
+  if (!isFiniteMatrix(S)) {
+    return; // Singular: there are no factors to update
+  }
+  if (point.sparse) {
+    point.sparseFactors = sparseLU;
+  } else {
+    point.dense = scratchSystem;
+    point.pivots = scratchPivots;
+  }
+  point.solution = scratchExcitation;
+  point.solved = true;
+}
+
+void SParameterCalculator::updateSweepPoint(SweepFactorization &point,
+                                            const SweepFactorCache &cache,
+                                            ComplexMatrix &S) {
+  if (!point.solved) {
+    solveSParameters(S);
+    return;
+  }
+
+  int numPorts = ports.size();
+  const ComplexMatrix &X = point.solution;
+  int systemSize = X.rows();
+  int n = systemSize - numPorts;
+  int rank = cache.nodes.size();
+  S.resize(numPorts, numPorts);
+
+  if (rank > 0) {
+    // D: new stamps minus the cached ones, over the touched nodes
+    ComplexMatrix &D = scratchUpdateY;
+    D.resize(rank, rank);
+    int nodes[4], position[4];
+    for (int k : cache.changed) {
+      for (int side = 0; side < 2; side++) {
+        const CompiledCircuit &source = side == 0 ? circuit : cache.circuit;
+        double sign = side == 0 ? 1.0 : -1.0;
+        int count = elementStamp(circuit.parameters[k], source, nodes,
+                                 &scratchStamp);
+        for (int a = 0; a < count; a++) {
+          position[a] = std::find(cache.nodes.begin(), cache.nodes.end(),
+                                  nodes[a]) -
+                        cache.nodes.begin();
+        }
+        for (int a = 0; a < count; a++) {
+          for (int b = 0; b < count; b++) {
+            if (nodes[a] > 0 && nodes[b] > 0) {
+              D[position[a]][position[b]] += sign * scratchStamp[a][b];
+            }
+          }
+        }
+      }
+    }
+
+    // G = A^-1·P
+    ComplexMatrix &G = scratchUpdateSolve;
+    G.resize(systemSize, rank);
+    for (int a = 0; a < rank; a++) {
+      G[cache.nodes[a] - 1][a] = Complex(1, 0);
+    }
+    if (point.sparse) {
+      point.sparseFactors.solve(G.view());
+    } else {
+      luSolve(point.dense.view(), point.pivots, G.view());
+    }
+
+    // (I + D·P^T·G)·T = D·P^T·X
+    ComplexMatrix &M = scratchUpdateSystem;
+    ComplexMatrix &T = scratchUpdateRhs;
+    M.resize(rank, rank);
+    T.resize(rank, numPorts);
+    for (int a = 0; a < rank; a++) {
+      M[a][a] = Complex(1, 0);
+      for (int b = 0; b < rank; b++) {
+        const Complex d = D[a][b];
+        if (d == Complex(0, 0)) {
+          continue;
+        }
+        const Complex *Grow = G[cache.nodes[b] - 1];
+        const Complex *Xrow = X[cache.nodes[b] - 1];
+        for (int c = 0; c < rank; c++) {
+          M[a][c] += d * Grow[c];
+        }
+        for (int p = 0; p < numPorts; p++) {
+          T[a][p] += d * Xrow[p];
+        }
+      }
+    }
+    if (!std::isfinite(luFactorize(M.view(), scratchPivots))) {
+      // The edit makes the correction singular: solve the point instead
+      solveSParameters(S);
+      return;
+    }
+    luSolve(M.view(), scratchPivots, T.view());
+
+    for (int i = 0; i < numPorts; i++) {
+      const Complex *Grow = G[n + i];
+      for (int j = 0; j < numPorts; j++) {
+        Complex correction(0, 0);
+        for (int a = 0; a < rank; a++) {
+          correction += Grow[a] * T[a][j];
+        }
+        S[i][j] = -correction;
+      }
+    }
+  }
+
+  for (int i = 0; i < numPorts; i++) {
+    const Complex *portVoltages = X[n + i];
+    for (int j = 0; j < numPorts; j++) {
+      S[i][j] += portVoltages[j];
+    }
+    S[i][i] -= Complex(1, 0);
+  }
+}
+
+int SParameterCalculator::elementStamp(const SensitivityParameter &parameter,
+                                       const CompiledCircuit &source,
+                                       int nodes[4], ComplexMatrix *Y) {
+  auto twoTerminal = [&](int node1, int node2, auto impedance) {
+    nodes[0] = node1;
+    nodes[1] = node2;
+    if (Y) {
+      Y->resize(2, 2);
+      Complex z = impedance();
+      if (abs(z) < 1e-12) {
+        z = Complex(1e-12, 0); // Avoid division by zero!
+      }
+      addTwoTerminalAdmittance(*Y, localNode(node1, 0), localNode(node2, 1),
+                               Complex(1, 0) / z);
+    }
+    return 2;
+  };
+
+  switch (parameter.kind) {
+  case SensitivityParameter::Resistance: {
+    // Stamped in fixedY, at 0 Hz
+    const CompiledLumped &comp = source.fixedLumped[parameter.index];
+    return twoTerminal(comp.node1, comp.node2,
+                       [&] { return getImpedance(comp, 0); });
+  }
+
+  case SensitivityParameter::Capacitance:
+  case SensitivityParameter::Inductance: {
+    const CompiledLumped &comp = source.reactiveLumped[parameter.index];
+    return twoTerminal(comp.node1, comp.node2,
+                       [&] { return getImpedance(comp, frequency); });
+  }
+
+  case SensitivityParameter::StubImpedance:
+  case SensitivityParameter::StubLength: {
+    const CompiledStub &stub = source.stubs[parameter.index];
+    return twoTerminal(stub.node1, stub.node2,
+                       [&] { return getImpedance(stub, frequency); });
+  }
+
+  case SensitivityParameter::LineImpedance:
+  case SensitivityParameter::LineLength: {
+    CompiledTransmissionLine line = source.transmissionLines[parameter.index];
+    nodes[0] = line.node1;
+    nodes[1] = line.node2;
+    if (Y) {
+      Y->resize(2, 2);
+      line.node1 = localNode(line.node1, 0);
+      line.node2 = localNode(line.node2, 1);
+      addTransmissionLineToAdmittance(*Y, line);
+    }
+    return 2;
+  }
+
+  case SensitivityParameter::MicrostripWidth:
+  case SensitivityParameter::MicrostripLength: {
+    CompiledMicrostripLine line = source.microstripLines[parameter.index];
+    nodes[0] = line.node1;
+    nodes[1] = line.node2;
+    if (Y) {
+      Y->resize(2, 2);
+      line.node1 = localNode(line.node1, 0);
+      line.node2 = localNode(line.node2, 1);
+      addMicrostripLineToAdmittance(*Y, line);
+    }
+    return 2;
+  }
+
+  case SensitivityParameter::CoupledMicrostripWidth:
+  case SensitivityParameter::CoupledMicrostripLength: {
+    CompiledMicrostripCoupledLines lines =
+        source.microstripCoupledLines[parameter.index];
+    for (int k = 0; k < 4; k++) {
+      nodes[k] = lines.nodes[k];
+      lines.nodes[k] = localNode(lines.nodes[k], k);
+    }
+    if (Y) {
+      Y->resize(4, 4);
+      addMicrostripCoupledLinesToAdmittance(*Y, lines);
+    }
+    return 4;
+  }
+  }
+  return 0;
+}
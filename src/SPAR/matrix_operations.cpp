@@ -6,63 +6,272 @@
 /// @license GPL-3.0-or-later
 
 #include "SParameterCalculator.h"
+#include "Misc/profiler.h"
 
-vector<vector<Complex>>
-SParameterCalculator::invertMatrix(const vector<vector<Complex>> &matrix) {
-  int n = matrix.size();
-  vector<vector<Complex>> augmented(n, vector<Complex>(2 * n, Complex(0, 0)));
+ComplexMatrix
+SParameterCalculator::invertMatrix(const ComplexMatrix &matrix) {
+  PROFILE_SCOPE("invertMatrix");
+  int n = matrix.rows();
+  ComplexMatrix LU = matrix;
+  ComplexMatrix inverse = ComplexMatrix::identity(n);
+  vector<int> pivots;
 
-  // Create augmented matrix [A|I]
-  for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      augmented[i][j] = matrix[i][j];
+  double ratio = luFactorize(LU.view(), pivots);
+  notePivotRatio(ratio);
+  if (!std::isfinite(ratio)) {
+    std::fill(inverse.data(), inverse.data() + inverse.size(),
+              Complex(NAN, NAN));
+    return inverse;
+  }
+  luSolve(LU.view(), pivots, inverse.view());
+
+  return inverse;
+}
+
+void SParameterCalculator::rowScales(ConstComplexMatrixView A, int rows,
+                                     vector<double> &scales) {
+  // max(|re|, |im|) is within a factor of sqrt(2) of the magnitude and needs
+  // no square root
+  scales.assign(rows, 0.0);
+  for (int i = 0; i < rows; i++) {
+    const Complex *row = A[i];
+    double scale = 0.0;
+    for (int j = 0; j < A.cols(); j++) {
+      scale = std::max(
+          scale, std::max(std::abs(row[j].real()), std::abs(row[j].imag())));
     }
-    augmented[i][i + n] = Complex(1, 0);
+    scales[i] = scale;
   }
+}
 
-  // Forward elimination
-  for (int i = 0; i < n; i++) {
+double SParameterCalculator::luFactorize(ComplexMatrixView A,
+                                         vector<int> &pivots) {
+  int n = A.rows();
+  pivots.assign(n, 0);
+  vector<double> &scales = scratchRowScales;
+  rowScales(A, n, scales);
+  double ratio = 1.0;
+
+  for (int k = 0; k < n; k++) {
     // Find pivot
-    int pivot = i;
-    for (int j = i + 1; j < n; j++) {
-      if (abs(augmented[j][i]) > abs(augmented[pivot][i])) {
-        pivot = j;
+    int pivot = k;
+    for (int i = k + 1; i < n; i++) {
+      if (abs(A[i][k]) > abs(A[pivot][k])) {
+        pivot = i;
       }
     }
+    pivots[k] = pivot;
 
     // Swap rows
-    if (pivot != i) {
-      swap(augmented[i], augmented[pivot]);
+    A.swapRows(k, pivot);
+    std::swap(scales[k], scales[pivot]);
+
+    Complex diag = A[k][k];
+    double pivotMagnitude = abs(diag);
+    if (!(pivotMagnitude >= 1e-12)) {
+      return INFINITY; // Singular (or NaN entries)
     }
+    ratio = std::max(ratio, scales[k] / pivotMagnitude);
 
-    // Make diagonal element 1
-    Complex diag = augmented[i][i];
-    if (abs(diag) < 1e-12) {
-      throw runtime_error("Matrix is singular and cannot be inverted");
+    // Store the multipliers (L) and update the trailing submatrix (U)
+    const Complex *rowK = A[k];
+    for (int i = k + 1; i < n; i++) {
+      Complex *rowI = A[i];
+      Complex factor = rowI[k] / diag;
+      rowI[k] = factor;
+      if (factor == Complex(0, 0)) {
+        continue;
+      }
+      for (int j = k + 1; j < n; j++) {
+        rowI[j] -= factor * rowK[j];
+      }
     }
+  }
+  return ratio;
+}
+
+void SParameterCalculator::luSolve(ConstComplexMatrixView LU,
+                                   const vector<int> &pivots,
+                                   ComplexMatrixView B) {
+  int n = LU.rows();
+  int m = B.cols();
+  if (n == 0 || m == 0) {
+    return;
+  }
 
-    for (int j = 0; j < 2 * n; j++) {
-      augmented[i][j] /= diag;
+  // Apply the row interchanges to the right-hand side
+  for (int k = 0; k < n; k++) {
+    B.swapRows(k, pivots[k]);
+  }
+
+  // Forward substitution (L has a unit diagonal)
+  for (int i = 1; i < n; i++) {
+    Complex *rowI = B[i];
+    for (int k = 0; k < i; k++) {
+      Complex l = LU[i][k];
+      if (l == Complex(0, 0)) {
+        continue;
+      }
+      const Complex *rowK = B[k];
+      for (int c = 0; c < m; c++) {
+        rowI[c] -= l * rowK[c];
+      }
     }
+  }
 
-    // Eliminate column
-    for (int j = 0; j < n; j++) {
-      if (i != j) {
-        Complex factor = augmented[j][i];
-        for (int k = 0; k < 2 * n; k++) {
-          augmented[j][k] -= factor * augmented[i][k];
-        }
+  // Back substitution
+  for (int i = n - 1; i >= 0; i--) {
+    Complex *rowI = B[i];
+    for (int k = i + 1; k < n; k++) {
+      Complex u = LU[i][k];
+      if (u == Complex(0, 0)) {
+        continue;
+      }
+      const Complex *rowK = B[k];
+      for (int c = 0; c < m; c++) {
+        rowI[c] -= u * rowK[c];
       }
     }
+    Complex diag = LU[i][i];
+    for (int c = 0; c < m; c++) {
+      rowI[c] /= diag;
+    }
   }
+}
 
-  // Extract inverse matrix
-  vector<vector<Complex>> inverse(n, vector<Complex>(n));
+void SParameterCalculator::luSolveTransposed(ConstComplexMatrixView LU,
+                                             const vector<int> &pivots,
+                                             ComplexMatrixView B) {
+  int n = LU.rows();
+  int m = B.cols();
+  if (n == 0 || m == 0) {
+    return;
+  }
+
+  // A^T = U^T·L^T·P. Forward substitution with U^T
   for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      inverse[i][j] = augmented[i][j + n];
+    Complex *rowI = B[i];
+    for (int k = 0; k < i; k++) {
+      Complex u = LU[k][i];
+      if (u == Complex(0, 0)) {
+        continue;
+      }
+      const Complex *rowK = B[k];
+      for (int c = 0; c < m; c++) {
+        rowI[c] -= u * rowK[c];
+      }
+    }
+    Complex diag = LU[i][i];
+    for (int c = 0; c < m; c++) {
+      rowI[c] /= diag;
     }
   }
 
-  return inverse;
+  // Back substitution with L^T (unit diagonal)
+  for (int i = n - 2; i >= 0; i--) {
+    Complex *rowI = B[i];
+    for (int k = i + 1; k < n; k++) {
+      Complex l = LU[k][i];
+      if (l == Complex(0, 0)) {
+        continue;
+      }
+      const Complex *rowK = B[k];
+      for (int c = 0; c < m; c++) {
+        rowI[c] -= l * rowK[c];
+      }
+    }
+  }
+
+  // Undo the row interchanges in reverse order
+  for (int k = n - 1; k >= 0; k--) {
+    B.swapRows(k, pivots[k]);
+  }
+}
+
+double SParameterCalculator::schurComplement(ComplexMatrixView A, int k) {
+  int n = A.rows();
+  vector<double> &scales = scratchRowScales;
+  rowScales(A, k, scales);
+  double ratio = 1.0;
+
+  for (int j = 0; j < k; j++) {
+    // Find pivot among the rows that are being eliminated
+    int pivot = j;
+    for (int i = j + 1; i < k; i++) {
+      if (abs(A[i][j]) > abs(A[pivot][j])) {
+        pivot = i;
+      }
+    }
+    A.swapRows(j, pivot);
+    std::swap(scales[j], scales[pivot]);
+
+    Complex diag = A[j][j];
+    double pivotMagnitude = abs(diag);
+    if (!(pivotMagnitude >= 1e-12)) {
+      return INFINITY; // Singular (or NaN entries)
+    }
+    ratio = std::max(ratio, scales[j] / pivotMagnitude);
+
+    const Complex *rowJ = A[j];
+    for (int i = j + 1; i < n; i++) {
+      Complex *rowI = A[i];
+      Complex factor = rowI[j] / diag;
+      if (factor == Complex(0, 0)) {
+        continue;
+      }
+      for (int c = j + 1; c < n; c++) {
+        rowI[c] -= factor * rowJ[c];
+      }
+    }
+  }
+  return ratio;
+}
+
+bool SParameterCalculator::reduceToPortNodes(const ComplexMatrix &Y,
+                                             ComplexMatrix &reducedY) {
+  ComplexMatrix &A = scratchSystem;
+  A.resize(numNodes, numNodes);
+  for (int i = 0; i < numNodes; i++) {
+    const Complex *row = Y[kronOrder[i]];
+    Complex *out = A[i];
+    for (int j = 0; j < numNodes; j++) {
+      out[j] = row[kronOrder[j]];
+    }
+  }
+
+  int k = numInternalNodes;
+  double ratio = schurComplement(A.view(), k);
+  notePivotRatio(ratio);
+
+  int m = numNodes - k;
+  reducedY.resize(m, m);
+  if (!std::isfinite(ratio)) {
+    std::fill(reducedY.data(), reducedY.data() + reducedY.size(),
+              Complex(NAN, NAN));
+    return false;
+  }
+  for (int i = 0; i < m; i++) {
+    std::copy(A[k + i] + k, A[k + i] + numNodes, reducedY[i]);
+  }
+  return true;
+}
+
+bool SParameterCalculator::factorizeSparse() {
+  PROFILE_SCOPE("factorizeSparse");
+  Complex *values = sparseLU.values();
+  std::copy(sparseFixedValues.begin(), sparseFixedValues.end(), values);
+  addFrequencyDependentAdmittance(StampTarget(sparseLU, values));
+
+  // Port equations, same entries as in the dense augmented system
+  for (size_t p = 0; p < ports.size(); p++) {
+    values[sparsePortSlots[3 * p]] = Complex(1, 0);
+    values[sparsePortSlots[3 * p + 1]] = Complex(-1, 0);
+    values[sparsePortSlots[3 * p + 2]] = Complex(1.0 / ports[p].impedance, 0);
+  }
+
+  if (!sparseLU.factorize()) {
+    return false;
+  }
+  notePivotRatio(sparseLU.getPivotRatio());
+  return true;
 }
@@ -0,0 +1,371 @@
+/// @file monte_carlo.cpp
+/// @brief Monte Carlo tolerance and yield analysis
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+#include <limits>
+#include <random>
+
+namespace {
+
+// Draws a component value from its tolerance distribution
+double sampleValue(double nominal, const Tolerance &tolerance,
+                   std::mt19937_64 &generator) {
+  double x;
+  if (tolerance.distribution == Tolerance::Gaussian) {
+    // Truncated at the 3σ bound
+    std::normal_distribution<double> distribution(0.0, 1.0 / 3.0);
+    do {
+      x = distribution(generator);
+    } while (abs(x) > 1.0);
+  } else {
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    x = distribution(generator);
+  }
+  return nominal * (1.0 + tolerance.relative * x);
+}
+
+// Checks a magnitude against a limit line. Frequencies outside the line pass
+bool meetsLimit(const SpecificationLimit &limit, double freq, double dB) {
+  double y;
+  if (!limit.valueAt(freq, y)) {
+    return true;
+  }
+  return limit.upper ? dB <= y : dB >= y;
+}
+
+} // namespace
+
+Tolerance
+SParameterCalculator::getTolerance(const SensitivityParameter &parameter) const {
+  auto it = componentTolerances.find(parameter.component + "." + parameter.name);
+  if (it != componentTolerances.end()) {
+    return it->second;
+  }
+  it = componentTolerances.find(parameter.component);
+  if (it != componentTolerances.end()) {
+    return it->second;
+  }
+  auto kind = defaultTolerances.find(parameter.kind);
+  if (kind != defaultTolerances.end()) {
+    return kind->second;
+  }
+  return Tolerance();
+}
+
+void SParameterCalculator::setParameterValue(
+    const SensitivityParameter &parameter, double value) {
+  int i = parameter.index;
+  switch (parameter.kind) {
+  case SensitivityParameter::Resistance: {
+    // Resistors are part of fixedY (and of its sparse copy), so only the
+    // change of their admittance is stamped
+    CompiledLumped &comp = circuit.fixedLumped[i];
+    auto admittance = [this](const CompiledLumped &element) {
+      Complex impedance = getImpedance(element, 0);
+      if (abs(impedance) < 1e-12) {
+        impedance = Complex(1e-12, 0); // Avoid division by zero!
+      }
+      return Complex(1, 0) / impedance;
+    };
+    Complex before = admittance(comp);
+    comp.value = value;
+    Complex change = admittance(comp) - before;
+    addTwoTerminalAdmittance(fixedY, comp.node1, comp.node2, change);
+    if (sparseLU.isAnalyzed()) {
+      addTwoTerminalAdmittance(StampTarget(sparseLU, sparseFixedValues.data()),
+                               comp.node1, comp.node2, change);
+    }
+    break;
+  }
+
+  case SensitivityParameter::Capacitance:
+  case SensitivityParameter::Inductance:
+    circuit.reactiveLumped[i].value = value;
+    break;
+
+  case SensitivityParameter::StubImpedance:
+    circuit.stubs[i].Z0 = value;
+    break;
+
+  case SensitivityParameter::StubLength:
+    circuit.stubs[i].length = value;
+    break;
+
+  case SensitivityParameter::LineImpedance:
+    circuit.transmissionLines[i].Z0 = value;
+    break;
+
+  case SensitivityParameter::LineLength:
+    circuit.transmissionLines[i].length = value;
+    break;
+
+  case SensitivityParameter::MicrostripWidth: {
+    CompiledMicrostripLine &line = circuit.microstripLines[i];
+    line.W = value;
+    line.statics = analyseMicrostripStatics(line.W, line.h, line.er, line.t,
+                                            line.tand, line.rho);
+    break;
+  }
+
+  case SensitivityParameter::MicrostripLength:
+    circuit.microstripLines[i].L = value;
+    break;
+
+  case SensitivityParameter::CoupledMicrostripWidth: {
+    CompiledMicrostripCoupledLines &lines = circuit.microstripCoupledLines[i];
+    lines.W = value;
+    analyseMicrostripCoupledStatics(lines.W, lines.S, lines.h, lines.er,
+                                    lines.t, lines.tand, lines.rho, lines.even,
+                                    lines.odd);
+    break;
+  }
+
+  case SensitivityParameter::CoupledMicrostripLength:
+    circuit.microstripCoupledLines[i].L = value;
+    break;
+  }
+}
+
+void SParameterCalculator::restoreParameterValue(
+    const SensitivityParameter &parameter, const SParameterCalculator &nominal) {
+  int i = parameter.index;
+  switch (parameter.kind) {
+  case SensitivityParameter::Resistance: {
+    const CompiledLumped &comp = nominal.circuit.fixedLumped[i];
+    circuit.fixedLumped[i] = comp;
+    // The resistor only touches the entries between its own nodes
+    for (int a : {comp.node1, comp.node2}) {
+      for (int b : {comp.node1, comp.node2}) {
+        if (a <= 0 || b <= 0) {
+          continue;
+        }
+        fixedY[a - 1][b - 1] = nominal.fixedY[a - 1][b - 1];
+        if (sparseLU.isAnalyzed()) {
+          int slot = sparseLU.find(a - 1, b - 1);
+          sparseFixedValues[slot] = nominal.sparseFixedValues[slot];
+        }
+      }
+    }
+    break;
+  }
+
+  case SensitivityParameter::Capacitance:
+  case SensitivityParameter::Inductance:
+    circuit.reactiveLumped[i] = nominal.circuit.reactiveLumped[i];
+    break;
+
+  case SensitivityParameter::StubImpedance:
+  case SensitivityParameter::StubLength:
+    circuit.stubs[i] = nominal.circuit.stubs[i];
+    break;
+
+  case SensitivityParameter::LineImpedance:
+  case SensitivityParameter::LineLength:
+    circuit.transmissionLines[i] = nominal.circuit.transmissionLines[i];
+    break;
+
+  case SensitivityParameter::MicrostripWidth:
+  case SensitivityParameter::MicrostripLength:
+    circuit.microstripLines[i] = nominal.circuit.microstripLines[i];
+    break;
+
+  case SensitivityParameter::CoupledMicrostripWidth:
+  case SensitivityParameter::CoupledMicrostripLength:
+    circuit.microstripCoupledLines[i] = nominal.circuit.microstripCoupledLines[i];
+    break;
+  }
+}
+
+MonteCarloResult SParameterCalculator::runMonteCarlo(
+    int trials, const vector<SpecificationLimit> &limits, unsigned seed,
+    AnalysisControl *control) {
+  MonteCarloResult result;
+  if (ports.empty() || trials <= 0 || n_points <= 0) {
+    return result;
+  }
+
+  ensureCircuitCompiled();
+
+  int n_ports = ports.size();
+  int numEntries = n_ports * n_ports;
+  double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
+
+  for (const auto &limit : limits) {
+    if (limit.row < 0 || limit.row >= n_ports || limit.col < 0 ||
+        limit.col >= n_ports) {
+      throw runtime_error("Limit on S" + to_string(limit.row + 1) +
+                          to_string(limit.col + 1) + " is out of bounds");
+    }
+  }
+
+  // Parameters without a tolerance keep their nominal value
+  const vector<SensitivityParameter> &parameters = circuit.parameters;
+  vector<int> varied;
+  vector<Tolerance> tolerances;
+  for (size_t k = 0; k < parameters.size(); k++) {
+    Tolerance tolerance = getTolerance(parameters[k]);
+    if (tolerance.relative > 0.0) {
+      varied.push_back(k);
+      tolerances.push_back(tolerance);
+    }
+  }
+
+  // The exact median needs the magnitudes of all the trials, so the sweep is
+  // processed in blocks of points whose magnitudes fit in MaxBlockBytes,
+  // [point][entry][trial]. Every block draws the same values for each trial
+  const size_t MaxBlockBytes = 32 << 20;
+  size_t pointBytes = (size_t)numEntries * trials * sizeof(double);
+  int blockPoints =
+      (int)std::clamp<size_t>(MaxBlockBytes / pointBytes, 1, n_points);
+  vector<double> magnitudes((size_t)blockPoints * numEntries * trials);
+  if (control) {
+    int numBlocks = (n_points + blockPoints - 1) / blockPoints;
+    control->done = 0;
+    control->total = (int)std::min<long long>(
+        (long long)numBlocks * trials, std::numeric_limits<int>::max());
+  }
+  vector<char> passed(trials, 1);
+  bool singleSolve = circuit.isFrequencyIndependent();
+
+  // Every worker perturbs its own copy of the compiled circuit. Each trial
+  // starts from the nominal values, so the perturbed matrices do not depend
+  // on the trials the worker ran before
+  int numWorkers = std::min(getSweepThreads(), trials);
+  vector<SParameterCalculator> engines = createWorkers(numWorkers);
+
+  std::atomic<int> nextTrial(0);
+  int firstPoint = 0;
+  int lastPoint = 0;
+  auto runWorker = [&](SParameterCalculator &engine) {
+    ComplexMatrix S;
+    for (int t = nextTrial++; t < trials; t = nextTrial++) {
+      if (control && control->abort) {
+        break;
+      }
+      std::seed_seq sequence{seed, (unsigned)t};
+      std::mt19937_64 generator(sequence);
+      for (int k : varied) {
+        engine.restoreParameterValue(parameters[k], *this);
+      }
+      for (size_t k = 0; k < varied.size(); k++) {
+        const SensitivityParameter &parameter = parameters[varied[k]];
+        engine.setParameterValue(
+            parameter, sampleValue(parameter.value, tolerances[k], generator));
+      }
+
+      bool pass = passed[t];
+      bool solved = true;
+      for (int i = firstPoint; i < lastPoint; i++) {
+        double freq = f_start + i * step;
+        if (i == firstPoint || !singleSolve) {
+          engine.frequency = freq;
+          try {
+            engine.solveSParameters(S);
+            solved = isFiniteMatrix(S);
+          } catch (const std::exception &) {
+            solved = false;
+          }
+        }
+        pass = pass && solved;
+
+        double *point = &magnitudes[(size_t)(i - firstPoint) * numEntries * trials];
+        for (int e = 0; e < numEntries; e++) {
+          point[(size_t)e * trials + t] =
+              solved ? 20.0 * log10(abs(S.data()[e]))
+                     : std::numeric_limits<double>::quiet_NaN();
+        }
+        for (const auto &limit : limits) {
+          if (!pass) {
+            break;
+          }
+          pass = meetsLimit(limit, freq,
+                            point[(size_t)(limit.row * n_ports + limit.col) *
+                                      trials +
+                                  t]);
+        }
+      }
+      passed[t] = pass;
+      if (control) {
+        control->done++;
+      }
+    }
+  };
+
+  result.trials = trials;
+  QList<double> &frequencies = result.data["frequency"];
+  for (int i = 0; i < n_points; i++) {
+    frequencies.append(f_start + i * step);
+  }
+
+  // Envelopes over the trials that could be solved at each point
+  vector<QList<double> *> minimum(numEntries), median(numEntries),
+      maximum(numEntries);
+  for (int row = 1; row <= n_ports; ++row) {
+    for (int col = 1; col <= n_ports; ++col) {
+      int e = (row - 1) * n_ports + (col - 1);
+      minimum[e] = &result.data[QString("S%1%2_dB_min").arg(row).arg(col)];
+      median[e] = &result.data[QString("S%1%2_dB_median").arg(row).arg(col)];
+      maximum[e] = &result.data[QString("S%1%2_dB_max").arg(row).arg(col)];
+    }
+  }
+
+  vector<double> values;
+  values.reserve(trials);
+  for (firstPoint = 0; firstPoint < n_points; firstPoint = lastPoint) {
+    lastPoint = std::min(firstPoint + blockPoints, n_points);
+    nextTrial = 0;
+    if (numWorkers == 1) {
+      runWorker(engines[0]);
+    } else {
+      vector<std::thread> pool;
+      for (auto &engine : engines) {
+        pool.emplace_back(runWorker, std::ref(engine));
+      }
+      for (auto &worker : pool) {
+        worker.join();
+      }
+    }
+    if (control && control->abort) {
+      MonteCarloResult aborted;
+      aborted.aborted = true;
+      return aborted;
+    }
+
+    for (int i = firstPoint; i < lastPoint; i++) {
+      for (int e = 0; e < numEntries; e++) {
+        const double *trial =
+            &magnitudes[((size_t)(i - firstPoint) * numEntries + e) * trials];
+        values.clear();
+        for (int t = 0; t < trials; t++) {
+          if (!std::isnan(trial[t])) {
+            values.push_back(trial[t]);
+          }
+        }
+        if (values.empty()) {
+          double nan = std::numeric_limits<double>::quiet_NaN();
+          minimum[e]->append(nan);
+          median[e]->append(nan);
+          maximum[e]->append(nan);
+          continue;
+        }
+
+        std::sort(values.begin(), values.end());
+        size_t middle = values.size() / 2;
+        minimum[e]->append(values.front());
+        median[e]->append(values.size() % 2
+                              ? values[middle]
+                              : 0.5 * (values[middle - 1] + values[middle]));
+        maximum[e]->append(values.back());
+      }
+    }
+  }
+
+  result.passed = std::count(passed.begin(), passed.end(), 1);
+  result.yield = (double)result.passed / trials;
+  return result;
+}
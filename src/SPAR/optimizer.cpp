@@ -0,0 +1,399 @@
+/// @file optimizer.cpp
+/// @brief Gradient-based optimization of component values against limit lines
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+#include <limits>
+
+QString SParameterCalculator::formatParameterValue(
+    const SensitivityParameter &parameter) {
+  double value = parameter.value;
+  QString unit;
+  switch (parameter.kind) {
+  case SensitivityParameter::Resistance:
+  case SensitivityParameter::StubImpedance:
+  case SensitivityParameter::LineImpedance:
+    unit = "Ohm";
+    break;
+  case SensitivityParameter::Capacitance:
+    unit = "F";
+    break;
+  case SensitivityParameter::Inductance:
+    unit = "H";
+    break;
+  default:
+    return QString::number(value * 1e3, 'g', 8) + "mm";
+  }
+
+  static const char *prefixes[] = {"f", "p", "n", "u", "m", "",
+                                   "k", "M", "G", "T"};
+  int exponent = 0;
+  if (value != 0.0) {
+    exponent = (int)std::floor(std::log10(std::abs(value)) / 3.0);
+    exponent = std::max(-5, std::min(4, exponent));
+  }
+  return QString::number(value / std::pow(10.0, 3 * exponent), 'g', 8) +
+         prefixes[exponent + 5] + unit;
+}
+
+OptimizationResult
+SParameterCalculator::optimize(const vector<OptimizationVariable> &variables,
+                               const vector<SpecificationLimit> &goals,
+                               int maxIterations, AnalysisControl *control) {
+  OptimizationResult result;
+  if (ports.empty() || variables.empty() || n_points <= 0) {
+    return result;
+  }
+
+  ensureCircuitCompiled();
+
+  int n_ports = ports.size();
+  for (const auto &goal : goals) {
+    if (goal.row < 0 || goal.row >= n_ports || goal.col < 0 ||
+        goal.col >= n_ports) {
+      throw runtime_error("Goal on S" + to_string(goal.row + 1) +
+                          to_string(goal.col + 1) + " is out of bounds");
+    }
+  }
+
+  // Variables are handled as log(value): they stay positive and values of
+  // very different magnitudes (pF, nH, mm) get comparable steps
+  const vector<SensitivityParameter> &parameters = circuit.parameters;
+  int n = variables.size();
+  vector<int> selection(n);
+  vector<double> x(n), lower(n), upper(n);
+  for (int v = 0; v < n; v++) {
+    const OptimizationVariable &variable = variables[v];
+    auto it = std::find_if(parameters.begin(), parameters.end(),
+                           [&](const SensitivityParameter &parameter) {
+                             return parameter.component == variable.component &&
+                                    parameter.name == variable.parameter;
+                           });
+    if (it == parameters.end() || it->value <= 0.0) {
+      throw runtime_error("Cannot optimize " + variable.component + "." +
+                          variable.parameter);
+    }
+    selection[v] = it - parameters.begin();
+    lower[v] = variable.minimum > 0.0
+                   ? log(variable.minimum)
+                   : -std::numeric_limits<double>::infinity();
+    upper[v] = variable.maximum > 0.0
+                   ? log(variable.maximum)
+                   : std::numeric_limits<double>::infinity();
+    x[v] = std::max(lower[v], std::min(upper[v], log(it->value)));
+  }
+
+  // Only the sweep points covered by a goal take part in the cost
+  double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
+  vector<int> points;
+  for (int i = 0; i < n_points; i++) {
+    double y;
+    for (const auto &goal : goals) {
+      if (goal.valueAt(f_start + i * step, y)) {
+        points.push_back(i);
+        break;
+      }
+    }
+  }
+
+  int numWorkers = std::max(1, std::min(getSweepThreads(), (int)points.size()));
+  vector<SParameterCalculator> engines = createWorkers(numWorkers);
+
+  vector<double> values(n);
+  auto evaluate = [&](const vector<double> &point, vector<double> &gradient) {
+    for (int v = 0; v < n; v++) {
+      values[v] = exp(point[v]);
+    }
+    result.evaluations++;
+    double cost =
+        optimizationCost(engines, selection, values, points, goals, gradient);
+    // Chain rule for the log variables
+    for (int v = 0; v < n; v++) {
+      gradient[v] *= values[v];
+    }
+    return cost;
+  };
+
+  // Components at a bound that the gradient pushes outwards are frozen
+  auto freeze = [&](const vector<double> &point, const vector<double> &g,
+                    vector<double> &d) {
+    for (int v = 0; v < n; v++) {
+      if ((point[v] <= lower[v] && g[v] > 0.0) ||
+          (point[v] >= upper[v] && g[v] < 0.0)) {
+        d[v] = 0.0;
+      }
+    }
+  };
+
+  vector<double> g(n), d(n), xNew(n), gNew(n), s(n), y(n), Hy(n);
+  double f = evaluate(x, g);
+  result.initialCost = f;
+
+  // Inverse Hessian approximation (BFGS), row-major
+  vector<double> H(n * n, 0.0);
+  if (control) {
+    control->done = 0;
+    control->total = maxIterations;
+  }
+  auto resetHessian = [&]() {
+    std::fill(H.begin(), H.end(), 0.0);
+    for (int v = 0; v < n; v++) {
+      H[v * n + v] = 1.0;
+    }
+  };
+  resetHessian();
+
+  for (int iteration = 0; iteration < maxIterations && std::isfinite(f);
+       iteration++) {
+    if (control) {
+      control->done = iteration;
+      if (control->abort) {
+        result.aborted = true;
+        break;
+      }
+    }
+    if (f <= 0.0) {
+      result.converged = true;
+      break;
+    }
+
+    double slope = 0.0;
+    for (int a = 0; a < n; a++) {
+      d[a] = 0.0;
+      for (int b = 0; b < n; b++) {
+        d[a] -= H[a * n + b] * g[b];
+      }
+    }
+    freeze(x, g, d);
+    for (int v = 0; v < n; v++) {
+      slope += g[v] * d[v];
+    }
+    if (!(slope < 0.0)) {
+      // Not a descent direction: restart from steepest descent
+      resetHessian();
+      for (int v = 0; v < n; v++) {
+        d[v] = -g[v];
+      }
+      freeze(x, g, d);
+      slope = 0.0;
+      for (int v = 0; v < n; v++) {
+        slope += g[v] * d[v];
+      }
+      if (!(slope < 0.0)) {
+        result.converged = true; // Stationary point
+        break;
+      }
+    }
+
+    // Backtracking line search (Armijo). A step changes no value by more
+    // than a factor e
+    double alpha = 1.0;
+    double largest = 0.0;
+    for (int v = 0; v < n; v++) {
+      largest = std::max(largest, std::abs(d[v]));
+    }
+    if (largest > 1.0) {
+      alpha = 1.0 / largest;
+    }
+
+    double fNew = f;
+    bool accepted = false;
+    for (int trial = 0; trial < 30 && !(control && control->abort); trial++) {
+      double decrease = 0.0;
+      for (int v = 0; v < n; v++) {
+        xNew[v] = std::max(lower[v], std::min(upper[v], x[v] + alpha * d[v]));
+        decrease += g[v] * (xNew[v] - x[v]);
+      }
+      fNew = evaluate(xNew, gNew);
+      if (fNew <= f + 1e-4 * decrease) {
+        accepted = true;
+        break;
+      }
+      alpha *= 0.5;
+    }
+    result.iterations = iteration + 1;
+    if (control && control->abort) {
+      // The line search was cut short: the values stay at the last iterate
+      result.aborted = true;
+      break;
+    }
+    if (!accepted) {
+      result.converged = true; // No further progress along any direction
+      break;
+    }
+
+    // BFGS update: H = (I - r·s·y^T)·H·(I - r·y·s^T) + r·s·s^T
+    double sy = 0.0;
+    for (int v = 0; v < n; v++) {
+      s[v] = xNew[v] - x[v];
+      y[v] = gNew[v] - g[v];
+      sy += s[v] * y[v];
+    }
+    if (sy > 1e-12) {
+      double r = 1.0 / sy;
+      double yHy = 0.0;
+      for (int a = 0; a < n; a++) {
+        Hy[a] = 0.0;
+        for (int b = 0; b < n; b++) {
+          Hy[a] += H[a * n + b] * y[b];
+        }
+        yHy += y[a] * Hy[a];
+      }
+      for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+          H[a * n + b] += (1.0 + r * yHy) * r * s[a] * s[b] -
+                          r * (Hy[a] * s[b] + s[a] * Hy[b]);
+        }
+      }
+    }
+
+    double previous = f;
+    x.swap(xNew);
+    g.swap(gNew);
+    f = fNew;
+    if (previous - f <= 1e-10 * previous) {
+      result.converged = true;
+      break;
+    }
+  }
+
+  result.finalCost = f;
+  result.converged = result.converged || f <= 0.0;
+  for (int v = 0; v < n; v++) {
+    SensitivityParameter parameter = parameters[selection[v]];
+    parameter.value = exp(x[v]);
+    result.variables.push_back(parameter);
+  }
+  result.netlist = writeParameterValues(result.variables);
+  return result;
+}
+
+double SParameterCalculator::optimizationCost(
+    vector<SParameterCalculator> &engines, const vector<int> &selection,
+    const vector<double> &values, const vector<int> &points,
+    const vector<SpecificationLimit> &goals, vector<double> &gradient) {
+  int numVariables = selection.size();
+  int numWorkers = engines.size();
+  double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
+
+  // Values are set against the nominal circuit, so that the rounding of the
+  // resistor restamps does not build up over the iterations
+  for (auto &engine : engines) {
+    for (int v = 0; v < numVariables; v++) {
+      engine.restoreParameterValue(circuit.parameters[selection[v]], *this);
+    }
+    for (int v = 0; v < numVariables; v++) {
+      engine.setParameterValue(circuit.parameters[selection[v]], values[v]);
+    }
+  }
+
+  // Contributions are stored per point and added up in point order, so the
+  // result does not depend on the number of workers
+  int numPoints = points.size();
+  vector<double> costs(numPoints, 0.0);
+  vector<double> gradients((size_t)numPoints * numVariables, 0.0);
+  const double dBPerNeper = 20.0 / log(10.0);
+
+  std::atomic<int> nextPoint(0);
+  auto runWorker = [&](SParameterCalculator &engine) {
+    ComplexMatrix S;
+    vector<ComplexMatrix> dS;
+    for (int k = nextPoint++; k < numPoints; k = nextPoint++) {
+      double freq = f_start + points[k] * step;
+      engine.frequency = freq;
+      bool solved;
+      try {
+        engine.solveSensitivities(S, dS, &selection);
+        solved = isFiniteMatrix(S);
+      } catch (const std::exception &) {
+        solved = false;
+      }
+      if (!solved) {
+        costs[k] = std::numeric_limits<double>::infinity();
+        continue;
+      }
+
+      double *pointGradient = &gradients[(size_t)k * numVariables];
+      for (const auto &goal : goals) {
+        double limit;
+        if (!goal.valueAt(freq, limit)) {
+          continue;
+        }
+        Complex s = S[goal.row][goal.col];
+        double power = norm(s);
+        double dB = 10.0 * log10(power);
+        double violation = goal.upper ? dB - limit : limit - dB;
+        if (!(violation > 0.0)) {
+          continue;
+        }
+        costs[k] += goal.weight * violation * violation;
+
+        // d|S|dB/dp = 20/ln(10)·Re(conj(S)·dS/dp)/|S|^2
+        for (int v = 0; v < numVariables; v++) {
+          double slope =
+              dBPerNeper * real(conj(s) * dS[v][goal.row][goal.col]) / power;
+          pointGradient[v] +=
+              2.0 * goal.weight * violation * (goal.upper ? slope : -slope);
+        }
+      }
+    }
+  };
+
+  if (numWorkers == 1) {
+    runWorker(engines[0]);
+  } else {
+    vector<std::thread> pool;
+    for (auto &engine : engines) {
+      pool.emplace_back(runWorker, std::ref(engine));
+    }
+    for (auto &worker : pool) {
+      worker.join();
+    }
+  }
+
+  // Mean over the points, so the cost does not depend on the grid density
+  double cost = 0.0;
+  gradient.assign(numVariables, 0.0);
+  for (int k = 0; k < numPoints; k++) {
+    cost += costs[k];
+    for (int v = 0; v < numVariables; v++) {
+      gradient[v] += gradients[(size_t)k * numVariables + v];
+    }
+  }
+  double scale = numPoints > 0 ? 1.0 / numPoints : 0.0;
+  for (int v = 0; v < numVariables; v++) {
+    gradient[v] *= scale;
+  }
+  return cost * scale;
+}
+
+QString SParameterCalculator::writeParameterValues(
+    const vector<SensitivityParameter> &parameters) const {
+  QStringList lines = currentNetlist.split('\n');
+  for (QString &line : lines) {
+    QString trimmedLine = line.trimmed();
+    if (trimmedLine.isEmpty() || trimmedLine.startsWith('*')) {
+      continue;
+    }
+
+    QStringList parts =
+        trimmedLine.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    bool changed = false;
+    for (const auto &parameter : parameters) {
+      int field = parameter.field;
+      if (field > 0 && field < parts.size() &&
+          parts[0].toStdString() == parameter.component) {
+        parts[field] = formatParameterValue(parameter);
+        changed = true;
+      }
+    }
+    if (changed) {
+      line = parts.join(" ");
+    }
+  }
+  return lines.join("\n");
+}
@@ -9,7 +9,7 @@
 #include "SParameterCalculator.h"
 
 void SParameterCalculator::exportTouchstone(const QString &filename,
-                                            const vector<vector<Complex>> &S) {
+                                            const ComplexMatrix &S) {
   QFile file(filename);
   if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
     cerr << "Error: Cannot create output file " << filename.toStdString()
@@ -27,8 +27,8 @@ void SParameterCalculator::exportTouchstone(const QString &filename,
   double freqGHz = frequency / 1e9;
   out << freqGHz;
 
-  for (size_t i = 0; i < S.size(); i++) {
-    for (size_t j = 0; j < S[i].size(); j++) {
+  for (int i = 0; i < S.rows(); i++) {
+    for (int j = 0; j < S.cols(); j++) {
       double mag = abs(S[i][j]);
       double phase = arg(S[i][j]) * 180.0 / M_PI;
       out << " " << mag << " " << phase;
@@ -41,48 +41,75 @@ void SParameterCalculator::exportTouchstone(const QString &filename,
   cout << "S-parameters exported to " << filename.toStdString() << endl;
 }
 
-void SParameterCalculator::exportSweepTouchstone(
+bool SParameterCalculator::exportSweepTouchstone(
     const QString &filename) const {
   QFile file(filename);
   if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
     cerr << "Error: Cannot create output file " << filename.toStdString()
          << endl;
-    return;
+    return false;
   }
 
   QTextStream out(&file);
+  out.setRealNumberPrecision(12);
 
   // Write header
   out << "! Touchstone file generated by SParameterCalculator\n";
-  out << "# GHz S MA R " << (ports.empty() ? 50.0 : ports[0].impedance) << "\n";
-
-  // Write S-parameters for each frequency
-  double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
-
-  for (int i = 0; i < n_points; ++i) {
-    double freq = f_start + i * step;
-    double freqGHz = freq / 1e9;
-    const auto &S = sweepResults[i];
+  out << "# GHz S MA R " << sweepData.Z0 << "\n";
+
+  // Write S-parameters for each frequency. Touchstone has no notation for an
+  // undefined value, so the points that could not be solved are left out
+  for (size_t i = 0; i < sweepData.size(); ++i) {
+    if (sweepData.status[i] == SolveStatus::Singular ||
+        sweepData.status[i] == SolveStatus::Failed) {
+      continue;
+    }
+    double freqGHz = sweepData.frequency[i] / 1e9;
+    ConstComplexMatrixView S = sweepData.matrix(i);
 
     out << freqGHz;
 
-    for (const auto &rowVec : S) {
-      for (const auto &value : rowVec) {
-        double mag = abs(value);
-        double phase = arg(value) * 180.0 / M_PI;
-        out << " " << mag << " " << phase;
-      }
+    auto writeEntry = [&out](const Complex &value) {
+      out << " " << abs(value) << " " << arg(value) * 180.0 / M_PI;
+    };
+
+    if (S.rows() == 2) {
+      // Two-port data goes in the order S11 S21 S12 S22
+      writeEntry(S[0][0]);
+      writeEntry(S[1][0]);
+      writeEntry(S[0][1]);
+      writeEntry(S[1][1]);
+      out << "\n";
+      continue;
     }
 
-    out << "\n";
+    // Otherwise row by row, with at most four pairs per line
+    for (int r = 0; r < S.rows(); r++) {
+      for (int c = 0; c < S.cols(); c++) {
+        if (c > 0 && c % 4 == 0) {
+          out << "\n";
+        }
+        writeEntry(S[r][c]);
+      }
+      out << "\n";
+    }
   }
 
+  // A full disk only shows up when the buffers are written out
+  out.flush();
+  bool written = out.status() == QTextStream::Ok;
   file.close();
+  if (!written || file.error() != QFileDevice::NoError) {
+    cerr << "Error: Cannot write output file " << filename.toStdString()
+         << endl;
+    return false;
+  }
   cout << "Frequency sweep exported to " << filename.toStdString() << endl;
+  return true;
 }
 
-void SParameterCalculator::printSParameters(const vector<vector<Complex>> &S) {
-  int numPorts = S.size();
+void SParameterCalculator::printSParameters(const ComplexMatrix &S) {
+  int numPorts = S.rows();
 
   cout << "S-Parameters at frequency " << frequency / 1e9 << " GHz:" << endl;
   cout << "----------------------------------------" << endl;
@@ -100,12 +127,10 @@ void SParameterCalculator::printSParameters(const vector<vector<Complex>> &S) {
 }
 
 void SParameterCalculator::printSParameterSweep() const {
-  double step = (n_points == 1) ? 0 : (f_stop - f_start) / (n_points - 1);
-
-  for (int i = 0; i < n_points; ++i) {
-    double freq = f_start + i * step;
-    const auto &S = sweepResults[i];
-    int numPorts = S.size();
+  for (size_t i = 0; i < sweepData.size(); ++i) {
+    double freq = sweepData.frequency[i];
+    ConstComplexMatrixView S = sweepData.matrix(i);
+    int numPorts = S.rows();
 
     std::cout << "S-Parameters at frequency " << freq / 1e9 << " GHz (" << freq
               << " Hz):\n";
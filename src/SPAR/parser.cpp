@@ -6,8 +6,10 @@
 /// @license GPL-3.0-or-later
 
 #include "SParameterCalculator.h"
+#include "Misc/profiler.h"
 
 bool SParameterCalculator::parseNetlist() {
+  PROFILE_SCOPE("parseNetlist");
   if (currentNetlist.isEmpty()) {
     cerr << "Error: No netlist content provided" << endl;
     return false;
@@ -55,6 +57,7 @@ bool SParameterCalculator::parseNetlist() {
       value["R"] = R;
       addComponent(ComponentType_SPAR::RESISTOR, name.toStdString(),
                    {node1, node2}, value);
+      components.back().netlistField["R"] = 3;
     } else if (type == QString("C") && parts.size() >= 4) {
       // Capacitor: C1 node1 node2 value
       int node1 = parts[1].toInt();
@@ -63,6 +66,7 @@ bool SParameterCalculator::parseNetlist() {
       value["C"] = C;
       addComponent(ComponentType_SPAR::CAPACITOR, name.toStdString(),
                    {node1, node2}, value);
+      components.back().netlistField["C"] = 3;
     } else if (type == QString("L") && parts.size() >= 4) {
       // Inductor: L1 node1 node2 value
       int node1 = parts[1].toInt();
@@ -71,6 +75,7 @@ bool SParameterCalculator::parseNetlist() {
       value["L"] = L;
       addComponent(ComponentType_SPAR::INDUCTOR, name.toStdString(),
                    {node1, node2}, value);
+      components.back().netlistField["L"] = 3;
     } else if (name.startsWith("Z", Qt::CaseInsensitive)) {
       if (parts.size() < 4) {
         cerr << "Error: Invalid complex impedance definition: "
@@ -141,6 +146,8 @@ bool SParameterCalculator::parseNetlist() {
                        {node1, node2}, value);
         }
       }
+      components.back().netlistField["Z0"] = 3;
+      components.back().netlistField["Length"] = 4;
     } else if ((type == QString("MLIN"))) {
       // Microstrip Transmission Line: MLIN node1 node2 length width er h cond
       // th tand
@@ -167,6 +174,8 @@ bool SParameterCalculator::parseNetlist() {
 
       addComponent(ComponentType_SPAR::MICROSTRIP_LINE, name.toStdString(),
                    {node1, node2}, value);
+      components.back().netlistField["Width"] = 3;
+      components.back().netlistField["Length"] = 4;
 
     } else if ((type == QString("MSCOUP"))) {
       // Microstrip Coupled Transmission Lines: MCOUP node1 node2 node3 node4
@@ -198,6 +207,8 @@ bool SParameterCalculator::parseNetlist() {
 
       addComponent(ComponentType_SPAR::MICROSTRIP_COUPLED_LINES,
                    name.toStdString(), {node1, node2, node3, node4}, value);
+      components.back().netlistField["W"] = 5;
+      components.back().netlistField["L"] = 6;
     } else if ((type == QString("MSTEP"))) {
       // Microstrip Transmission Line step model: MSTEP node1 node2 length width
       // er h cond th tand
@@ -408,10 +419,9 @@ bool SParameterCalculator::parseNetlist() {
           matrixStr += parts[k] + " ";
         }
 
-        vector<vector<Complex>> Smat =
-            parseInlineSMatrix(matrixStr, numRFPorts);
+        ComplexMatrix Smat = parseInlineSMatrix(matrixStr, numRFPorts);
 
-        if ((int)Smat.size() == numRFPorts) {
+        if (Smat.rows() == numRFPorts) {
           components.emplace_back(
               ComponentType_SPAR::SPAR_BLOCK, name.toStdString(),
               std::vector<int>(nodes.constBegin(), nodes.constEnd()), Smat,
@@ -427,5 +437,432 @@ bool SParameterCalculator::parseNetlist() {
   }
   cout << "Parsed " << components.size()
        << " components, numNodes = " << numNodes << endl;
+
+  compileCircuit();
   return true;
 }
+
+void SParameterCalculator::compileCircuit() {
+  PROFILE_SCOPE("compileCircuit");
+  circuit.clear();
+
+  // Microstrip quasi-static models, shared by the lines with the same
+  // geometry and substrate
+  std::map<std::array<double, 6>, MicrostripStatics> lineStatics;
+  std::map<std::array<double, 7>, std::pair<MicrostripStatics, MicrostripStatics>>
+      coupledStatics;
+
+  // Component values the sensitivity analysis differentiates against. The
+  // netlist field is kept so that the optimizer can write the value back
+  auto addParameter = [&](const Component_SPAR &comp, const string &name,
+                          SensitivityParameter::Kind kind, int index,
+                          double parameterValue) {
+    int field = comp.netlistField.value(QString::fromStdString(name), -1);
+    circuit.parameters.push_back(
+        {comp.name, name, kind, index, parameterValue, field});
+  };
+
+  for (const auto &comp : components) {
+    const QMap<QString, double> &value = comp.value;
+
+    switch (comp.type) {
+    case ComponentType_SPAR::RESISTOR:
+    case ComponentType_SPAR::CAPACITOR:
+    case ComponentType_SPAR::INDUCTOR:
+    case ComponentType_SPAR::COMPLEX_IMPEDANCE: {
+      if (comp.nodes.size() != 2) {
+        break;
+      }
+      CompiledLumped lumped;
+      lumped.type = comp.type;
+      lumped.node1 = comp.nodes[0];
+      lumped.node2 = comp.nodes[1];
+      lumped.value = 0.0;
+      if (comp.type == ComponentType_SPAR::RESISTOR) {
+        lumped.value = value["R"];
+      } else if (comp.type == ComponentType_SPAR::CAPACITOR) {
+        lumped.value = value["C"];
+      } else if (comp.type == ComponentType_SPAR::INDUCTOR) {
+        lumped.value = value["L"];
+      }
+      lumped.Z = comp.Zvalue["Z"];
+      if (comp.type == ComponentType_SPAR::CAPACITOR ||
+          comp.type == ComponentType_SPAR::INDUCTOR) {
+        circuit.reactiveLumped.push_back(lumped);
+        int index = circuit.reactiveLumped.size() - 1;
+        if (comp.type == ComponentType_SPAR::CAPACITOR) {
+          addParameter(comp, "C", SensitivityParameter::Capacitance, index,
+                       lumped.value);
+        } else {
+          addParameter(comp, "L", SensitivityParameter::Inductance, index,
+                       lumped.value);
+        }
+      } else {
+        circuit.fixedLumped.push_back(lumped);
+        if (comp.type == ComponentType_SPAR::RESISTOR) {
+          addParameter(comp, "R", SensitivityParameter::Resistance,
+                       circuit.fixedLumped.size() - 1, lumped.value);
+        }
+      }
+      break;
+    }
+
+    case ComponentType_SPAR::OPEN_STUB:
+    case ComponentType_SPAR::SHORT_STUB: {
+      if (comp.nodes.size() != 2) {
+        break;
+      }
+      CompiledStub stub;
+      stub.type = comp.type;
+      stub.node1 = comp.nodes[0];
+      stub.node2 = comp.nodes[1];
+      stub.Z0 = value["Z0"];
+      stub.length = value["Length"];
+      circuit.stubs.push_back(stub);
+      addParameter(comp, "Z0", SensitivityParameter::StubImpedance,
+                   circuit.stubs.size() - 1, stub.Z0);
+      addParameter(comp, "Length", SensitivityParameter::StubLength,
+                   circuit.stubs.size() - 1, stub.length);
+      break;
+    }
+
+    case ComponentType_SPAR::TRANSMISSION_LINE: {
+      CompiledTransmissionLine line;
+      line.node1 = comp.nodes[0];
+      line.node2 = comp.nodes[1];
+      line.Z0 = value.value("Z0");
+      line.length = value.value("Length");
+      circuit.transmissionLines.push_back(line);
+      addParameter(comp, "Z0", SensitivityParameter::LineImpedance,
+                   circuit.transmissionLines.size() - 1, line.Z0);
+      addParameter(comp, "Length", SensitivityParameter::LineLength,
+                   circuit.transmissionLines.size() - 1, line.length);
+      break;
+    }
+
+    case ComponentType_SPAR::COUPLED_LINE: {
+      if (comp.nodes.size() != 4) {
+        cerr << "Error: Coupled line must have exactly 4 nodes" << endl;
+        break;
+      }
+      CompiledCoupledLine line;
+      std::copy(comp.nodes.begin(), comp.nodes.end(), line.nodes);
+      line.Z0e = value["Z0e"];
+      line.Z0o = value["Z0o"];
+      line.length = value["Length"];
+      circuit.coupledLines.push_back(line);
+      break;
+    }
+
+    case ComponentType_SPAR::IDEAL_COUPLER: {
+      if (comp.nodes.size() != 4) {
+        cerr << "Error: Ideal coupler must have exactly 4 nodes" << endl;
+        break;
+      }
+      CompiledIdealCoupler coupler;
+      std::copy(comp.nodes.begin(), comp.nodes.end(), coupler.nodes);
+      coupler.k = value["k"];                 // Linear coupling coefficient
+      coupler.phase_deg = value["phase_deg"]; // Phase shift in degrees
+      coupler.Z0 = value["Z0"];               // Characteristic impedance
+      coupler.Y =
+          calculateIdealCouplerYMatrix(coupler.k, coupler.phase_deg, coupler.Z0);
+      circuit.idealCouplers.push_back(coupler);
+      break;
+    }
+
+    case ComponentType_SPAR::SPAR_BLOCK: {
+      int numRFPorts = comp.numRFPorts;
+
+      // Validate S-matrix dimensions
+      if (comp.Smatrix.rows() != numRFPorts) {
+        cerr << "Error: S-matrix dimension (" << comp.Smatrix.rows()
+             << ") does not match RF port count (" << numRFPorts << ")\n";
+        break;
+      }
+      if (numRFPorts != 1 && numRFPorts != 2) {
+        cerr << "Error: Only 1-port and 2-port S-parameter devices are "
+                "supported. "
+             << "Found " << numRFPorts << " ports.\n";
+        break;
+      }
+      if (comp.nodes.size() != 2) {
+        cerr << "Error: " << numRFPorts
+             << "-port S-parameter device must have exactly 2 circuit "
+                "nodes\n";
+        break;
+      }
+
+      ComplexMatrix2 S;
+      for (int i = 0; i < numRFPorts; i++) {
+        for (int j = 0; j < numRFPorts; j++) {
+          S[i][j] = comp.Smatrix[i][j];
+        }
+      }
+
+      CompiledSParamBlock block;
+      block.node1 = comp.nodes[0];
+      block.node2 = comp.nodes[1];
+      block.numRFPorts = numRFPorts;
+      block.Z0 = comp.referenceImpedance;
+      block.Y = sParamBlockToY(S, numRFPorts, block.Z0);
+      if (!isFiniteMatrix(block.Y)) {
+        cerr << "Error converting " << comp.name
+             << " to Y-parameters: I + S is singular" << endl;
+        break;
+      }
+      circuit.sparBlocks.push_back(block);
+      break;
+    }
+
+    case ComponentType_SPAR::FREQUENCY_DEPENDENT_SPAR_BLOCK: {
+      int numRFPorts = comp.numRFPorts;
+      if (numRFPorts != 1 && numRFPorts != 2) {
+        cerr << "Error: Only 1-port and 2-port frequency-dependent devices "
+                "supported\n";
+        break;
+      }
+
+      CompiledFrequencyDependentBlock block;
+      block.node1 = comp.nodes[0];
+      block.node2 = comp.nodes[1];
+      block.numRFPorts = numRFPorts;
+      block.Z0 = comp.referenceImpedance;
+
+      if (!comp.freqDepData.contains("frequency")) {
+        cerr << "Error: Frequency-dependent S-parameter missing frequency data"
+             << endl;
+      } else {
+        const QList<double> &frequencies = comp.freqDepData["frequency"];
+        block.frequencies.assign(frequencies.begin(), frequencies.end());
+        block.S.resize(frequencies.size());
+        for (int k = 0; k < frequencies.size(); k++) {
+          ComplexMatrix S = extractSMatrixAtIndex(comp, k);
+          for (int i = 0; i < min(2, S.rows()); i++) {
+            for (int j = 0; j < min(2, S.cols()); j++) {
+              block.S[k][i][j] = S[i][j];
+            }
+          }
+        }
+      }
+      circuit.frequencyDependentBlocks.push_back(std::move(block));
+      break;
+    }
+
+    case ComponentType_SPAR::MICROSTRIP_LINE: {
+      CompiledMicrostripLine line;
+      line.node1 = comp.nodes[0];
+      line.node2 = comp.nodes[1];
+      line.W = value.value("Width");
+      line.L = value.value("Length");
+      line.h = value.value("h");
+      line.er = value.value("er");
+      line.t = value.value("th", 0.0);
+      line.tand = value.value("tand", 0.0);
+      line.rho = value.value("rho", 1e-10);
+
+      std::array<double, 6> key = {line.W, line.h, line.er,
+                                   line.t, line.tand, line.rho};
+      auto cached = lineStatics.find(key);
+      if (cached == lineStatics.end()) {
+        cached = lineStatics
+                     .emplace(key, analyseMicrostripStatics(
+                                       line.W, line.h, line.er, line.t,
+                                       line.tand, line.rho))
+                     .first;
+      }
+      line.statics = cached->second;
+      circuit.microstripLines.push_back(line);
+      addParameter(comp, "Width", SensitivityParameter::MicrostripWidth,
+                   circuit.microstripLines.size() - 1, line.W);
+      addParameter(comp, "Length", SensitivityParameter::MicrostripLength,
+                   circuit.microstripLines.size() - 1, line.L);
+      break;
+    }
+
+    case ComponentType_SPAR::MICROSTRIP_COUPLED_LINES: {
+      CompiledMicrostripCoupledLines lines;
+      std::copy(comp.nodes.begin(), comp.nodes.begin() + 4, lines.nodes);
+      lines.W = value.value("W");
+      lines.S = value.value("S");
+      lines.L = value.value("L");
+      lines.h = value.value("h");
+      lines.er = value.value("er");
+      lines.t = value.value("th", 0.0);
+      lines.tand = value.value("tand", 0.0);
+      lines.rho = value.value("rho", 1e-10);
+
+      std::array<double, 7> key = {lines.W,  lines.S,    lines.h,  lines.er,
+                                   lines.t,  lines.tand, lines.rho};
+      auto cached = coupledStatics.find(key);
+      if (cached == coupledStatics.end()) {
+        std::pair<MicrostripStatics, MicrostripStatics> modes;
+        analyseMicrostripCoupledStatics(lines.W, lines.S, lines.h, lines.er,
+                                        lines.t, lines.tand, lines.rho,
+                                        modes.first, modes.second);
+        cached = coupledStatics.emplace(key, modes).first;
+      }
+      lines.even = cached->second.first;
+      lines.odd = cached->second.second;
+      circuit.microstripCoupledLines.push_back(lines);
+      addParameter(comp, "W", SensitivityParameter::CoupledMicrostripWidth,
+                   circuit.microstripCoupledLines.size() - 1, lines.W);
+      addParameter(comp, "L", SensitivityParameter::CoupledMicrostripLength,
+                   circuit.microstripCoupledLines.size() - 1, lines.L);
+      break;
+    }
+
+    case ComponentType_SPAR::MICROSTRIP_VIA: {
+      CompiledMicrostripVia via;
+      via.node1 = comp.nodes[0];
+      via.N = value.value("N");
+      via.D = value.value("D");
+      via.h = value.value("h");
+      via.t = value.value("th");
+      via.rho = value.value("rho", 1e-10);
+      circuit.microstripVias.push_back(via);
+      break;
+    }
+
+    default: {
+      // Types without a dedicated stamp (sources, microstrip steps and open
+      // ends) keep the generic two-terminal handling: zero impedance, clamped
+      // to 1e-12 Ω when stamped
+      if (comp.nodes.size() == 2) {
+        CompiledLumped lumped;
+        lumped.type = comp.type;
+        lumped.node1 = comp.nodes[0];
+        lumped.node2 = comp.nodes[1];
+        lumped.value = 0.0;
+        lumped.Z = Complex(0, 0);
+        circuit.fixedLumped.push_back(lumped);
+      }
+      break;
+    }
+    }
+  }
+
+  fixedY.resize(numNodes, numNodes);
+  buildFixedAdmittanceMatrix(fixedY);
+
+  // Port rows in the full and in the reduced system. The Kron ordering puts
+  // the internal nodes first, followed by the distinct port nodes
+  portNodes.clear();
+  reducedPortNodes.clear();
+  vector<int> reducedRow(numNodes, -1);
+  vector<int> reducedNodes;
+  for (const auto &port : ports) {
+    int node = port.node - 1;
+    portNodes.push_back(node);
+    if (node < 0 || node >= numNodes) {
+      reducedPortNodes.push_back(-1); // Reported by solveSParameters()
+      continue;
+    }
+    if (reducedRow[node] < 0) {
+      reducedRow[node] = reducedNodes.size();
+      reducedNodes.push_back(node);
+    }
+    reducedPortNodes.push_back(reducedRow[node]);
+  }
+
+  kronOrder.clear();
+  for (int i = 0; i < numNodes; i++) {
+    if (reducedRow[i] < 0) {
+      kronOrder.push_back(i);
+    }
+  }
+  numInternalNodes = kronOrder.size();
+  kronOrder.insert(kronOrder.end(), reducedNodes.begin(), reducedNodes.end());
+
+  analyzeCascade();
+
+  sparseLU.clear();
+  if (sparseSolverThreshold > 0 && numNodes >= sparseSolverThreshold) {
+    analyzeSparsePattern();
+  }
+
+  circuitCompiled = true;
+}
+
+void SParameterCalculator::analyzeSparsePattern() {
+  int numPorts = ports.size();
+  int systemSize = numNodes + numPorts;
+  vector<vector<int>> adjacency(systemSize);
+
+  // Couples every pair of non-ground nodes of an element
+  auto connect = [&](std::initializer_list<int> nodes) {
+    for (int a : nodes) {
+      for (int b : nodes) {
+        if (a > 0 && b > 0 && a != b) {
+          adjacency[a - 1].push_back(b - 1);
+        }
+      }
+    }
+  };
+
+  for (const auto &comp : circuit.fixedLumped) {
+    connect({comp.node1, comp.node2});
+  }
+  for (const auto &comp : circuit.reactiveLumped) {
+    connect({comp.node1, comp.node2});
+  }
+  for (const auto &stub : circuit.stubs) {
+    connect({stub.node1, stub.node2});
+  }
+  for (const auto &line : circuit.transmissionLines) {
+    connect({line.node1, line.node2});
+  }
+  for (const auto &line : circuit.coupledLines) {
+    connect({line.nodes[0], line.nodes[1], line.nodes[2], line.nodes[3]});
+  }
+  for (const auto &coupler : circuit.idealCouplers) {
+    connect({coupler.nodes[0], coupler.nodes[1], coupler.nodes[2],
+             coupler.nodes[3]});
+  }
+  for (const auto &block : circuit.sparBlocks) {
+    connect({block.node1, block.node2});
+  }
+  for (const auto &block : circuit.frequencyDependentBlocks) {
+    connect({block.node1, block.node2});
+  }
+  for (const auto &line : circuit.microstripLines) {
+    connect({line.node1, line.node2});
+  }
+  for (const auto &lines : circuit.microstripCoupledLines) {
+    connect({lines.nodes[0], lines.nodes[1], lines.nodes[2], lines.nodes[3]});
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    std::sort(adjacency[i].begin(), adjacency[i].end());
+    adjacency[i].erase(std::unique(adjacency[i].begin(), adjacency[i].end()),
+                       adjacency[i].end());
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    adjacency[i].push_back(i);
+  }
+  for (int p = 0; p < numPorts; p++) {
+    int portNode = ports[p].node - 1;
+    if (portNode < 0 || portNode >= numNodes) {
+      // Reported by solveSParameters()
+      return;
+    }
+    adjacency[portNode].push_back(numNodes + p);
+    adjacency[numNodes + p].push_back(portNode);
+  }
+
+  sparseLU.analyze(systemSize, adjacency, numPorts);
+
+  // Frequency-independent stamps, laid out as the sparse storage. They are
+  // copied into it at the start of every frequency point
+  sparseFixedValues.assign(sparseLU.nonZeros(), Complex(0, 0));
+  buildFixedAdmittanceMatrix(StampTarget(sparseLU, sparseFixedValues.data()));
+
+  sparsePortSlots.clear();
+  for (int p = 0; p < numPorts; p++) {
+    int portNode = ports[p].node - 1;
+    int portEqn = numNodes + p;
+    sparsePortSlots.push_back(sparseLU.find(portEqn, portNode));
+    sparsePortSlots.push_back(sparseLU.find(portEqn, portEqn));
+    sparsePortSlots.push_back(sparseLU.find(portNode, portEqn));
+  }
+}
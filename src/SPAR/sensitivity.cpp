@@ -0,0 +1,267 @@
+/// @file sensitivity.cpp
+/// @brief Adjoint sensitivity analysis of the S-parameters
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SParameterCalculator.h"
+
+namespace {
+
+// Relative step of the central differences of the distributed element stamps
+constexpr double StampStep = 1e-6;
+
+// Local node of an element terminal. Ground stays at 0
+int localNode(int node, int terminal) { return node > 0 ? terminal + 1 : 0; }
+
+// Central difference of the stamp of an element with respect to one of its
+// fields. The element must already be renumbered to its local nodes
+template <typename Element, typename Stamp>
+void differenceStamp(Element element, double Element::*field, int count,
+                     Stamp stamp, ComplexMatrix &dY, ComplexMatrix &work) {
+  double value = element.*field;
+  double delta = StampStep * (value != 0.0 ? std::abs(value) : 1.0);
+
+  dY.resize(count, count);
+  element.*field = value + delta;
+  stamp(dY, element);
+
+  work.resize(count, count);
+  element.*field = value - delta;
+  stamp(work, element);
+
+  for (int a = 0; a < count; a++) {
+    for (int b = 0; b < count; b++) {
+      dY[a][b] = (dY[a][b] - work[a][b]) / (2 * delta);
+    }
+  }
+}
+
+} // namespace
+
+vector<ComplexMatrix> SParameterCalculator::calculateSensitivities() {
+  if (ports.empty()) {
+    throw runtime_error("No ports defined for the sensitivity analysis");
+  }
+
+  ensureCircuitCompiled();
+
+  ComplexMatrix S;
+  vector<ComplexMatrix> dS;
+  solveSensitivities(S, dS);
+  return dS;
+}
+
+void SParameterCalculator::solveSensitivities(ComplexMatrix &S,
+                                              vector<ComplexMatrix> &dS,
+                                              const vector<int> *selection) {
+  checkPortNodes();
+
+  // Forward solution X of the augmented system A·X = B. The factors of A are
+  // kept for the adjoint solve
+  bool solvedSparse = solveNodalSystem(S);
+  if (!isFiniteMatrix(S)) {
+    // Singular system: the derivatives are undefined as well
+    dS.resize(selection ? selection->size() : circuit.parameters.size());
+    for (ComplexMatrix &derivative : dS) {
+      derivative.resize(ports.size(), ports.size());
+      std::fill(derivative.data(), derivative.data() + derivative.size(),
+                Complex(NAN, NAN));
+    }
+    return;
+  }
+  const ComplexMatrix &X = scratchExcitation;
+
+  // Adjoint solution W of A^T·W = E, where column i of E selects the unknown
+  // of port i. Then S_ij = E_i^T·X_j and dS_ij/dp = -W_i^T·(dA/dp)·X_j
+  int numPorts = ports.size();
+  ComplexMatrix &W = scratchAdjoint;
+  W.resize(numNodes + numPorts, numPorts);
+  for (int p = 0; p < numPorts; p++) {
+    W[numNodes + p][p] = Complex(1, 0);
+  }
+  if (solvedSparse) {
+    sparseLU.solveTransposed(W.view());
+  } else {
+    luSolveTransposed(scratchSystem.view(), scratchPivots, W.view());
+  }
+
+  // Each parameter only changes the stamp of its own component, so the
+  // derivatives are small products of W and X over the component nodes
+  const vector<SensitivityParameter> &parameters = circuit.parameters;
+  size_t numDerivatives = selection ? selection->size() : parameters.size();
+  dS.resize(numDerivatives);
+  int nodes[4];
+  for (size_t k = 0; k < numDerivatives; k++) {
+    ComplexMatrix &derivative = dS[k];
+    derivative.resize(numPorts, numPorts);
+
+    const SensitivityParameter &parameter =
+        parameters[selection ? (*selection)[k] : k];
+    int count = sensitivityStamp(parameter, nodes, scratchStampDerivative);
+    const ComplexMatrix &dY = scratchStampDerivative;
+    for (int a = 0; a < count; a++) {
+      if (nodes[a] <= 0) {
+        continue;
+      }
+      const Complex *adjointRow = W[nodes[a] - 1];
+      for (int b = 0; b < count; b++) {
+        if (nodes[b] <= 0 || dY[a][b] == Complex(0, 0)) {
+          continue;
+        }
+        const Complex *solutionRow = X[nodes[b] - 1];
+        for (int i = 0; i < numPorts; i++) {
+          Complex weight = adjointRow[i] * dY[a][b];
+          for (int j = 0; j < numPorts; j++) {
+            derivative[i][j] -= weight * solutionRow[j];
+          }
+        }
+      }
+    }
+  }
+}
+
+int SParameterCalculator::sensitivityStamp(
+    const SensitivityParameter &parameter, int nodes[4], ComplexMatrix &dY) {
+  ComplexMatrix &work = scratchStamp;
+
+  // Lumped elements have closed-form derivatives
+  auto lumpedStamp = [&](const CompiledLumped &comp, Complex dy) {
+    nodes[0] = comp.node1;
+    nodes[1] = comp.node2;
+    dY.resize(2, 2);
+    dY[0][0] = dY[1][1] = dy;
+    dY[0][1] = dY[1][0] = -dy;
+    return 2;
+  };
+
+  switch (parameter.kind) {
+  case SensitivityParameter::Resistance: {
+    const CompiledLumped &comp = circuit.fixedLumped[parameter.index];
+    if (comp.value == 0.0) {
+      return 0; // Shorts are stamped with a clamped impedance
+    }
+    Complex y = Complex(1, 0) / getImpedance(comp, frequency);
+    return lumpedStamp(comp, -y * y);
+  }
+
+  case SensitivityParameter::Capacitance: {
+    const CompiledLumped &comp = circuit.reactiveLumped[parameter.index];
+    return lumpedStamp(comp, Complex(0, 2 * M_PI * frequency));
+  }
+
+  case SensitivityParameter::Inductance: {
+    const CompiledLumped &comp = circuit.reactiveLumped[parameter.index];
+    if (comp.value == 0.0) {
+      return 0;
+    }
+    Complex y = Complex(1, 0) / getImpedance(comp, frequency);
+    return lumpedStamp(comp, -y / comp.value);
+  }
+
+  case SensitivityParameter::StubImpedance:
+  case SensitivityParameter::StubLength: {
+    CompiledStub stub = circuit.stubs[parameter.index];
+    nodes[0] = stub.node1;
+    nodes[1] = stub.node2;
+    stub.node1 = localNode(stub.node1, 0);
+    stub.node2 = localNode(stub.node2, 1);
+    auto field = parameter.kind == SensitivityParameter::StubImpedance
+                     ? &CompiledStub::Z0
+                     : &CompiledStub::length;
+    differenceStamp(
+        stub, field, 2,
+        [this](ComplexMatrix &Y, const CompiledStub &element) {
+          Complex impedance = getImpedance(element, frequency);
+          if (abs(impedance) < 1e-12) {
+            impedance = Complex(1e-12, 0); // Avoid division by zero!
+          }
+          addTwoTerminalAdmittance(Y, element.node1, element.node2,
+                                   Complex(1, 0) / impedance);
+        },
+        dY, work);
+    return 2;
+  }
+
+  case SensitivityParameter::LineImpedance:
+  case SensitivityParameter::LineLength: {
+    CompiledTransmissionLine line = circuit.transmissionLines[parameter.index];
+    nodes[0] = line.node1;
+    nodes[1] = line.node2;
+    line.node1 = localNode(line.node1, 0);
+    line.node2 = localNode(line.node2, 1);
+    auto field = parameter.kind == SensitivityParameter::LineImpedance
+                     ? &CompiledTransmissionLine::Z0
+                     : &CompiledTransmissionLine::length;
+    differenceStamp(
+        line, field, 2,
+        [this](ComplexMatrix &Y, const CompiledTransmissionLine &element) {
+          addTransmissionLineToAdmittance(Y, element);
+        },
+        dY, work);
+    return 2;
+  }
+
+  case SensitivityParameter::MicrostripWidth:
+  case SensitivityParameter::MicrostripLength: {
+    CompiledMicrostripLine line = circuit.microstripLines[parameter.index];
+    nodes[0] = line.node1;
+    nodes[1] = line.node2;
+    line.node1 = localNode(line.node1, 0);
+    line.node2 = localNode(line.node2, 1);
+    if (parameter.kind == SensitivityParameter::MicrostripLength) {
+      differenceStamp(
+          line, &CompiledMicrostripLine::L, 2,
+          [this](ComplexMatrix &Y, const CompiledMicrostripLine &element) {
+            addMicrostripLineToAdmittance(Y, element);
+          },
+          dY, work);
+    } else {
+      // The width changes the quasi-static model as well
+      differenceStamp(
+          line, &CompiledMicrostripLine::W, 2,
+          [this](ComplexMatrix &Y, CompiledMicrostripLine element) {
+            element.statics =
+                analyseMicrostripStatics(element.W, element.h, element.er,
+                                         element.t, element.tand, element.rho);
+            addMicrostripLineToAdmittance(Y, element);
+          },
+          dY, work);
+    }
+    return 2;
+  }
+
+  case SensitivityParameter::CoupledMicrostripWidth:
+  case SensitivityParameter::CoupledMicrostripLength: {
+    CompiledMicrostripCoupledLines lines =
+        circuit.microstripCoupledLines[parameter.index];
+    for (int k = 0; k < 4; k++) {
+      nodes[k] = lines.nodes[k];
+      lines.nodes[k] = localNode(lines.nodes[k], k);
+    }
+    if (parameter.kind == SensitivityParameter::CoupledMicrostripLength) {
+      differenceStamp(
+          lines, &CompiledMicrostripCoupledLines::L, 4,
+          [this](ComplexMatrix &Y,
+                 const CompiledMicrostripCoupledLines &element) {
+            addMicrostripCoupledLinesToAdmittance(Y, element);
+          },
+          dY, work);
+    } else {
+      differenceStamp(
+          lines, &CompiledMicrostripCoupledLines::W, 4,
+          [this](ComplexMatrix &Y, CompiledMicrostripCoupledLines element) {
+            analyseMicrostripCoupledStatics(element.W, element.S, element.h,
+                                            element.er, element.t,
+                                            element.tand, element.rho,
+                                            element.even, element.odd);
+            addMicrostripCoupledLinesToAdmittance(Y, element);
+          },
+          dY, work);
+    }
+    return 4;
+  }
+  }
+  return 0;
+}
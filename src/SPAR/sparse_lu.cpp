@@ -0,0 +1,285 @@
+/// @file sparse_lu.cpp
+/// @brief Sparse LU factorization of the nodal equations (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "SparseLU.h"
+
+#include <algorithm>
+
+void SparseLU::clear() {
+  n = 0;
+  perm.clear();
+  invPerm.clear();
+  rowStart.clear();
+  diagIndex.clear();
+  colIndex.clear();
+  vals.clear();
+  work.clear();
+}
+
+void SparseLU::analyze(int size,
+                       const std::vector<std::vector<int>> &adjacency,
+                       int numTrailing) {
+  clear();
+  n = size;
+
+  // Elimination graph, as sorted adjacency lists. Eliminating a vertex
+  // connects all its neighbours, which is the fill-in created by that pivot
+  std::vector<std::vector<int>> graph(n);
+  for (int i = 0; i < n; i++) {
+    for (int j : adjacency[i]) {
+      if (j != i) {
+        graph[i].push_back(j);
+        graph[j].push_back(i);
+      }
+    }
+  }
+  for (auto &neighbours : graph) {
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                     neighbours.end());
+  }
+
+  // Degree buckets: the candidate vertices of each degree form a doubly
+  // linked list, so the vertex of minimum degree is found without scanning
+  // and a degree change is a constant time move between lists
+  std::vector<int> head(n, -1), next(n, -1), prev(n, -1), degree(n, 0);
+  std::vector<bool> queued(n, false);
+  int minDegree = 0;
+  auto enqueue = [&](int v) {
+    int d = graph[v].size();
+    degree[v] = d;
+    prev[v] = -1;
+    next[v] = head[d];
+    if (head[d] >= 0) {
+      prev[head[d]] = v;
+    }
+    head[d] = v;
+    queued[v] = true;
+    minDegree = std::min(minDegree, d);
+  };
+  auto dequeue = [&](int v) {
+    if (prev[v] >= 0) {
+      next[prev[v]] = next[v];
+    } else {
+      head[degree[v]] = next[v];
+    }
+    if (next[v] >= 0) {
+      prev[next[v]] = prev[v];
+    }
+    queued[v] = false;
+  };
+
+  // Minimum degree ordering. The neighbours of each vertex at the time it is
+  // eliminated are the columns of its row in U. The trailing vertices only
+  // become candidates once all the others are eliminated
+  std::vector<std::vector<int>> upper(n);
+  int firstTrailing = std::max(0, n - numTrailing);
+  for (int v = 0; v < firstTrailing; v++) {
+    enqueue(v);
+  }
+  perm.reserve(n);
+
+  std::vector<int> merged;
+  for (int step = 0; step < n; step++) {
+    if (step == firstTrailing) {
+      for (int v = firstTrailing; v < n; v++) {
+        enqueue(v);
+      }
+    }
+    while (head[minDegree] < 0) {
+      minDegree++;
+    }
+    int best = head[minDegree];
+    dequeue(best);
+
+    // Each neighbour loses the pivot and gains the other neighbours
+    std::vector<int> neighbours = std::move(graph[best]);
+    graph[best].clear();
+    for (int a : neighbours) {
+      merged.clear();
+      const std::vector<int> &current = graph[a];
+      size_t i = 0, j = 0;
+      while (i < current.size() || j < neighbours.size()) {
+        int v;
+        if (j == neighbours.size() ||
+            (i < current.size() && current[i] < neighbours[j])) {
+          v = current[i++];
+        } else if (i == current.size() || neighbours[j] < current[i]) {
+          v = neighbours[j++];
+        } else {
+          v = current[i++];
+          j++;
+        }
+        if (v != a && v != best) {
+          merged.push_back(v);
+        }
+      }
+      graph[a].swap(merged);
+
+      if (queued[a] && degree[a] != (int)graph[a].size()) {
+        dequeue(a);
+        enqueue(a);
+      }
+    }
+
+    upper[best] = std::move(neighbours);
+    perm.push_back(best);
+  }
+
+  invPerm.assign(n, 0);
+  for (int i = 0; i < n; i++) {
+    invPerm[perm[i]] = i;
+  }
+
+  // Row patterns in the permuted numbering. The pattern is symmetric, so the
+  // L part of a row is the transpose of the U columns
+  std::vector<std::vector<int>> rows(n);
+  for (int i = 0; i < n; i++) {
+    rows[i].push_back(i);
+    for (int u : upper[perm[i]]) {
+      int j = invPerm[u];
+      rows[i].push_back(j);
+      rows[j].push_back(i);
+    }
+  }
+
+  rowStart.assign(n + 1, 0);
+  diagIndex.assign(n, 0);
+  for (int i = 0; i < n; i++) {
+    std::sort(rows[i].begin(), rows[i].end());
+    rowStart[i] = colIndex.size();
+    for (int j : rows[i]) {
+      if (j == i) {
+        diagIndex[i] = colIndex.size();
+      }
+      colIndex.push_back(j);
+    }
+  }
+  rowStart[n] = colIndex.size();
+
+  vals.assign(colIndex.size(), Complex(0, 0));
+  work.assign(n, Complex(0, 0));
+}
+
+int SparseLU::find(int row, int col) const {
+  int i = invPerm[row];
+  int j = invPerm[col];
+  auto first = colIndex.begin() + rowStart[i];
+  auto last = colIndex.begin() + rowStart[i + 1];
+  auto it = std::lower_bound(first, last, j);
+  if (it == last || *it != j) {
+    return -1;
+  }
+  return it - colIndex.begin();
+}
+
+void SparseLU::setZero() { std::fill(vals.begin(), vals.end(), Complex(0, 0)); }
+
+bool SparseLU::factorize(double pivotTolerance) {
+  double ratio = 1.0;
+  for (int i = 0; i < n; i++) {
+    int begin = rowStart[i];
+    int end = rowStart[i + 1];
+    int diag = diagIndex[i];
+
+    // Scatter the row, then eliminate it against the previous rows (IKJ
+    // order). The symbolic analysis guarantees that every update lands inside
+    // the pattern of the row
+    double rowScale = 0.0;
+    for (int s = begin; s < end; s++) {
+      work[colIndex[s]] = vals[s];
+      rowScale = std::max(rowScale, std::abs(vals[s]));
+    }
+    for (int s = begin; s < diag; s++) {
+      int k = colIndex[s];
+      Complex l = work[k] / vals[diagIndex[k]];
+      work[k] = l;
+      for (int t = diagIndex[k] + 1; t < rowStart[k + 1]; t++) {
+        work[colIndex[t]] -= l * vals[t];
+      }
+    }
+
+    double rowMax = 0.0;
+    for (int s = begin; s < end; s++) {
+      vals[s] = work[colIndex[s]];
+      work[colIndex[s]] = Complex(0, 0);
+      if (s >= diag) {
+        rowMax = std::max(rowMax, std::abs(vals[s]));
+      }
+    }
+
+    double pivot = std::abs(vals[diag]);
+    if (pivot < 1e-12 || pivot < pivotTolerance * rowMax) {
+      return false;
+    }
+    ratio = std::max(ratio, rowScale / pivot);
+  }
+  pivotRatio = ratio;
+  return true;
+}
+
+void SparseLU::solve(ComplexMatrixView B) {
+  for (int c = 0; c < B.cols(); c++) {
+    for (int i = 0; i < n; i++) {
+      work[i] = B[perm[i]][c];
+    }
+
+    // Forward substitution (L has a unit diagonal)
+    for (int i = 0; i < n; i++) {
+      Complex sum = work[i];
+      for (int s = rowStart[i]; s < diagIndex[i]; s++) {
+        sum -= vals[s] * work[colIndex[s]];
+      }
+      work[i] = sum;
+    }
+
+    // Back substitution
+    for (int i = n - 1; i >= 0; i--) {
+      Complex sum = work[i];
+      for (int s = diagIndex[i] + 1; s < rowStart[i + 1]; s++) {
+        sum -= vals[s] * work[colIndex[s]];
+      }
+      work[i] = sum / vals[diagIndex[i]];
+    }
+
+    for (int i = 0; i < n; i++) {
+      B[perm[i]][c] = work[i];
+    }
+  }
+  std::fill(work.begin(), work.end(), Complex(0, 0));
+}
+
+void SparseLU::solveTransposed(ComplexMatrixView B) {
+  for (int c = 0; c < B.cols(); c++) {
+    for (int i = 0; i < n; i++) {
+      work[i] = B[perm[i]][c];
+    }
+
+    // U^T is lower triangular. Its columns are the rows of U, so each solved
+    // entry is pushed forward into the ones that depend on it
+    for (int i = 0; i < n; i++) {
+      Complex x = work[i] / vals[diagIndex[i]];
+      work[i] = x;
+      for (int s = diagIndex[i] + 1; s < rowStart[i + 1]; s++) {
+        work[colIndex[s]] -= vals[s] * x;
+      }
+    }
+
+    // L^T is upper triangular with a unit diagonal
+    for (int i = n - 1; i >= 0; i--) {
+      Complex x = work[i];
+      for (int s = rowStart[i]; s < diagIndex[i]; s++) {
+        work[colIndex[s]] -= vals[s] * x;
+      }
+    }
+
+    for (int i = 0; i < n; i++) {
+      B[perm[i]][c] = work[i];
+    }
+  }
+  std::fill(work.begin(), work.end(), Complex(0, 0));
+}
@@ -6,6 +6,7 @@
 /// @license GPL-3.0-or-later
 
 #include "SchematicContent.h"
+#include "Misc/profiler.h"
 
 SchematicContent::SchematicContent() {
   Comps.clear();
@@ -40,6 +41,7 @@ void SchematicContent::assignNetToWiresConnectedToNode(QString NodeID,
 }
 
 QString SchematicContent::getSParameterNetlist() {
+  PROFILE_SCOPE("getSParameterNetlist");
   if (Comps.isEmpty()) {
     return netlist; // This is used in case the network is defined using a plain
                     // text netlist
@@ -93,6 +93,21 @@ class SchematicContent {
         /// @param C Component information
         void appendComponent(struct ComponentInfo C) {Comps.append(C);}
 
+        /// @brief Set a parameter of a component (e.g. after an optimization)
+        /// @param ID Component identifier
+        /// @param parameter Parameter name (e.g. "C", "Z0", "Length")
+        /// @param value New value, with its units
+        /// @return False if there is no such component parameter
+        bool setComponentValue(QString ID, QString parameter, QString value) {
+          for (int i = 0; i < Comps.size(); i++) {
+            if (Comps[i].ID == ID && Comps[i].val.contains(parameter)) {
+              Comps[i].val[parameter] = value;
+              return true;
+            }
+          }
+          return false;
+        }
+
         /// @brief Add wire to schematic
         /// @param WI Wire information
         void appendWire(WireInfo WI);
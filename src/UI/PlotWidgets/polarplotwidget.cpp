@@ -244,6 +244,7 @@ void PolarPlotWidget::updatePlot() {
     graphsForTrace.append(currentGraph);
 
     double prevPhase = -1e3; // Initialize with impossible value
+    bool gap = false;        // Unsolved points since the last one added
 
     for (int i = 0; i < trace.values.size() && i < trace.frequencies.size();
          ++i) {
@@ -256,9 +257,17 @@ void PolarPlotWidget::updatePlot() {
           phase += 360;
         }
 
+        // Points that the simulator could not solve are NaN. They end the
+        // segment, so the trace shows a gap
+        if (!std::isfinite(magnitude) || !std::isfinite(phase)) {
+          gap = true;
+          continue;
+        }
+
         // Check for phase wrap (only after first point)
-        if (prevPhase != -1e3 &&
-            std::abs(phase - prevPhase) > PHASE_WRAP_THRESHOLD) {
+        if (gap || (prevPhase != -1e3 &&
+                    std::abs(phase - prevPhase) > PHASE_WRAP_THRESHOLD)) {
+          gap = false;
           // Create new polar graph for next segment
           currentGraph = new QCPPolarGraph(angularAxis, radialAxis);
           currentGraph->setPen(trace.pen);
@@ -8,6 +8,7 @@
 #include "smithchartwidget.h"
 #include <QDebug>
 #include <QToolTip>
+#include <cmath>
 
 SmithChartWidget::SmithChartWidget(QWidget *parent)
     : QWidget(parent), z0(50.0), scaleFactor(1.0), panX(0.0), panY(0.0),
@@ -609,8 +610,12 @@ void SmithChartWidget::plotImpedanceData(QPainter *painter) {
       QPointF currentPoint(center.x() + radius * gamma.real(),
                            center.y() - radius * gamma.imag());
 
-      // Draw a line between the previous point and the current point
-      painter->drawLine(prevPoint, currentPoint);
+      // Draw a line between the previous point and the current point. Points
+      // that the simulator could not solve are NaN and leave a gap
+      if (std::isfinite(prevPoint.x()) && std::isfinite(prevPoint.y()) &&
+          std::isfinite(currentPoint.x()) && std::isfinite(currentPoint.y())) {
+        painter->drawLine(prevPoint, currentPoint);
+      }
 
       // Update the previous point
       prevPoint = currentPoint;
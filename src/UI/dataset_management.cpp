@@ -8,6 +8,9 @@
 #include "qucs-s-spar-viewer.h"
 
 void Qucs_S_SPAR_Viewer::removeAllFiles() {
+  // Files still being read are dropped too
+  *fileLoadCancelled = true;
+
   // Remove files
   QStringList fileIDs;
   for (int i = 0; i < List_RemoveButton.size(); i++) {
@@ -26,6 +29,7 @@ void Qucs_S_SPAR_Viewer::removeAllFiles() {
 
   // Clear the watchedFilePaths map
   watchedFilePaths.clear();
+  fileReloads.clear();
 }
 
 void Qucs_S_SPAR_Viewer::removeFile(QString ID) {
@@ -44,6 +48,7 @@ void Qucs_S_SPAR_Viewer::removeFile(QString ID) {
 
       // Remove data from dataset
       datasets.remove(dataset_to_remove);
+      fileReloads.remove(watchedFilePaths.value(dataset_to_remove));
 
       // Remove dataset from dataset-selection combobox (so that the user can no longer see it)
       QCombobox_datasets->removeItem(QCombobox_datasets->findText(dataset_to_remove));
@@ -88,7 +93,7 @@ void Qucs_S_SPAR_Viewer::addFile(const QFileInfo &fileInfo) {
 void Qucs_S_SPAR_Viewer::addFile() {
   QFileDialog dialog(this, QStringLiteral("Select S-parameter data files"),
                      QDir::homePath(),
-                     tr("S-Parameter Files (*.s1p *.s2p *.s3p *.s4p);;"
+                     tr("S-Parameter Files (*.s1p *.s2p *.s3p *.s4p *.ts);;"
                         "Data Files (*.dat *.ngspice.dat);;"
                         "All Files (*.*)"));
   dialog.setFileMode(QFileDialog::ExistingFiles);
@@ -101,101 +106,126 @@ void Qucs_S_SPAR_Viewer::addFile() {
   addFiles(fileNames);
 }
 
-void Qucs_S_SPAR_Viewer::addFiles(QStringList fileNames) {
-  int existing_files =
-      this->datasets.size(); // Get the number of entries in the map
-  QString filename;
+QString Qucs_S_SPAR_Viewer::datasetNameFromFile(const QString &path) {
+  QString filename = QFileInfo(path).fileName();
+  QString dataset_name =
+      filename.left(filename.lastIndexOf('.')); // Remove file extension
+  if (dataset_name.endsWith(".dat")) {
+    // This file has extension .dat.ngspice
+    dataset_name = dataset_name.left(dataset_name.length() - 4);
+  }
+  return dataset_name;
+}
 
-  if (existing_files == 0) {
+void Qucs_S_SPAR_Viewer::addFiles(QStringList fileNames) {
+  if (datasets.isEmpty() && fileLoadTotal == 0) {
     // Reset limits
     this->f_max = -1;
     this->f_min = 1e30;
   }
 
-  // Remove from the list of files those that already exist in the database
-  QStringList files_dataset = datasets.keys();
-
-  for (int i = 0; i < fileNames.length(); i++) {
-    filename = QFileInfo(fileNames.at(i)).fileName();
-    // Check if this file already exists
-    QString new_filename = filename.left(filename.lastIndexOf('.'));
-
-    if (new_filename.endsWith(".dat")) {
-      // This file has extension .dat.ngspice
-      new_filename = new_filename.left(new_filename.length() - 4);
-    }
-
-    if (files_dataset.contains(new_filename)) {
-      // Remove it from the list of new files to load
-      fileNames.removeAt(i);
-
+  // Remove from the list of files those that already exist in the database or
+  // are being loaded
+  QStringList newFiles;
+  for (const QString &path : std::as_const(fileNames)) {
+    QString dataset_name = datasetNameFromFile(path);
+    if (datasets.contains(dataset_name) ||
+        pendingDatasets.contains(dataset_name)) {
       // Pop up a warning
       QMessageBox::information(this, tr("Warning"),
                                tr("This file is already in the dataset."));
+      continue;
     }
+    pendingDatasets.append(dataset_name);
+    newFiles.append(QFileInfo(path).absoluteFilePath());
+  }
+  if (newFiles.isEmpty()) {
+    return;
+  }
+
+  if (fileLoadTotal == 0) {
+    // New batch
+    loadedFiles.clear();
+    fileLoadDone = 0;
+    fileLoadProgress->show();
+    fileLoadCancelButton->show();
+  }
+  if (*fileLoadCancelled) {
+    // The files of a cancelled batch may still be draining. The new ones must
+    // not be skipped
+    fileLoadCancelled = std::make_shared<std::atomic<bool>>(false);
+  }
+  fileLoadTotal += newFiles.size();
+  fileLoadProgress->setRange(0, fileLoadTotal);
+  fileLoadProgress->setValue(fileLoadDone);
+
+  // The files are parsed on the pool. Only the widgets are created on the GUI
+  // thread, as each file arrives
+  std::shared_ptr<std::atomic<bool>> cancelled = fileLoadCancelled;
+  for (const QString &path : std::as_const(newFiles)) {
+    fileLoadPool->start([this, path, cancelled]() {
+      QMap<QString, QList<double>> file_data;
+      if (!*cancelled) {
+        file_data = loadSparamFile(path);
+      }
+      QMetaObject::invokeMethod(
+          this,
+          [this, path, file_data, cancelled]() {
+            if (!*cancelled) {
+              addLoadedFile(path, file_data);
+            }
+            fileLoadFinished(path);
+          },
+          Qt::QueuedConnection);
+    });
   }
+}
 
-  // Read files
-  int widget_counter = existing_files;
-  int n_files = fileNames.length(); // Number of files to be added
-  QStringList files_filtered; // Some of the files included may be discarded for
-                              // not having s-parameter data. This list contain
-                              // only the files to be added
-  for (int i = existing_files; i < existing_files + n_files; i++) {
-    // Create the file name label
-    QFileInfo file_info = QFileInfo(fileNames.at(i - existing_files));
-    QString filename = file_info.fileName();
-    QString fileabspath = file_info.absoluteFilePath();
+void Qucs_S_SPAR_Viewer::addLoadedFile(
+    const QString &path, const QMap<QString, QList<double>> &file_data) {
+  // It must contain basic S-parameter data
+  if (file_data.isEmpty() || file_data["n_ports"].at(0) == 0) {
+    return;
+  }
 
-    // Determine the file extension
-    QString fileExtension =
-        QFileInfo(fileNames.at(i - existing_files)).suffix().toLower();
+  QString filename = QFileInfo(path).fileName();
+  loadedFiles.append(filename);
 
-    QMap<QString, QList<double>> file_data = loadSparamFile(fileabspath);
+  // Create widgets at this point. It's necessary to ensure that the files to
+  // be loaded contain S-parameter data
+  CreateFileWidgets(filename, datasets.size());
 
-    if (file_data.isEmpty()) {
-      // Stop the load process and remove file from the list of files to be
-      // added
-      continue;
-    } else {
-      // It must contain basic S-parameter data
-      if (file_data["n_ports"].at(0) == 0) {
-        continue;
-      }
-    }
-    files_filtered.append(filename);
-
-    // Create widgets at this point. It's necessary to ensure that the files to
-    // be loaded contain S-parameter data
-    CreateFileWidgets(filename, widget_counter);
-    widget_counter++;
-
-    // Add data to the dataset
-    QString dataset_name =
-        filename.left(filename.lastIndexOf('.')); // Remove file extension
-    if (fileExtension == "ngspice") {
-      // These files have extension .dat.ngspice. Remove the extension again to
-      // have only the file name
-      dataset_name = dataset_name.left(dataset_name.length() - 4);
-    }
+  // Add data to the dataset
+  QString dataset_name = datasetNameFromFile(path);
+  datasets[dataset_name] = file_data;
 
-    datasets[dataset_name] = file_data;
+  // Add file to watchedFilePaths map
+  watchedFilePaths[dataset_name] = path;
 
-    // Add file to watchedFilePaths map
-    watchedFilePaths[dataset_name] = fileNames.at(i - existing_files);
+  // Add new dataset to the trace selection combobox
+  QCombobox_datasets->addItem(dataset_name);
 
-    // Add new dataset to the trace selection combobox
-    QCombobox_datasets->addItem(dataset_name);
+  // Add optional traces based on number of ports
+  addOptionalTraces(file_data);
 
-    // Add optional traces based on number of ports
-    addOptionalTraces(file_data);
+  // Update traces
+  updateTracesCombo();
+}
 
-    // Update traces
-    updateTracesCombo();
+void Qucs_S_SPAR_Viewer::fileLoadFinished(const QString &path) {
+  pendingDatasets.removeOne(datasetNameFromFile(path));
+  fileLoadProgress->setValue(++fileLoadDone);
+  if (fileLoadDone < fileLoadTotal) {
+    return;
   }
 
+  // End of the batch
+  fileLoadTotal = 0;
+  fileLoadProgress->hide();
+  fileLoadCancelButton->hide();
+
   // Apply default visualizations based on file types
-  applyDefaultVisualizations(files_filtered);
+  applyDefaultVisualizations(loadedFiles);
 
   // Set up file watcher for the newly added files
   setupFileWatcher();
@@ -0,0 +1,86 @@
+/// @file limitanalysisdialog.cpp
+/// @brief Dialog that turns the limit lines of the chart into specifications
+/// of the simulated circuit (implementation)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#include "limitanalysisdialog.h"
+
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+LimitAnalysisDialog::LimitAnalysisDialog(const QString &title,
+                                         const QStringList &limits,
+                                         int numPorts, QWidget *parent)
+    : QDialog(parent), numPorts(numPorts) {
+  setWindowTitle(title);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(new QLabel(
+      tr("Choose the S-parameter each limit line applies to and the side of "
+         "the line the trace must stay on.")));
+
+  table = new QTableWidget(limits.size(), 3);
+  table->setHorizontalHeaderLabels(
+      {tr("Limit"), tr("Trace"), tr("Trace must be")});
+  table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  table->verticalHeader()->setVisible(false);
+
+  // Two-port circuits are most often specified on the transmission
+  QString defaultTrace = numPorts >= 2 ? "S21" : "S11";
+  for (int i = 0; i < limits.size(); i++) {
+    QTableWidgetItem *name = new QTableWidgetItem(limits[i]);
+    name->setFlags(Qt::ItemIsEnabled);
+    table->setItem(i, 0, name);
+
+    QComboBox *trace = new QComboBox();
+    trace->addItem(tr("Not used"));
+    for (int row = 1; row <= numPorts; row++) {
+      for (int col = 1; col <= numPorts; col++) {
+        trace->addItem(QString("S%1%2").arg(row).arg(col));
+      }
+    }
+    trace->setCurrentText(defaultTrace);
+    table->setCellWidget(i, 1, trace);
+
+    QComboBox *direction = new QComboBox();
+    direction->addItem(tr("Below the line"));
+    direction->addItem(tr("Above the line"));
+    direction->setCurrentIndex(defaultTrace == "S21" ? 1 : 0);
+    table->setCellWidget(i, 2, direction);
+  }
+  layout->addWidget(table);
+
+  settings = new QFormLayout();
+  layout->addLayout(settings);
+
+  QDialogButtonBox *buttons =
+      new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  layout->addWidget(buttons);
+
+  resize(480, 320);
+}
+
+bool LimitAnalysisDialog::getTarget(int limit, int &row, int &col,
+                                    bool &upper) const {
+  QComboBox *trace = qobject_cast<QComboBox *>(table->cellWidget(limit, 1));
+  QComboBox *direction = qobject_cast<QComboBox *>(table->cellWidget(limit, 2));
+  if (!trace || !direction || trace->currentIndex() <= 0) {
+    return false;
+  }
+  // Item k (k >= 1) is S(row, col) in row-major order
+  int entry = trace->currentIndex() - 1;
+  row = entry / numPorts;
+  col = entry % numPorts;
+  upper = direction->currentIndex() == 0;
+  return true;
+}
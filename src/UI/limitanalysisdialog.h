@@ -0,0 +1,52 @@
+/// @file limitanalysisdialog.h
+/// @brief Dialog that turns the limit lines of the chart into specifications
+/// of the simulated circuit (definition)
+/// @author Andrés Martínez Mera - andresmmera@protonmail.com
+/// @date Jan 3, 2026
+/// @copyright Copyright (C) 2026 Andrés Martínez Mera
+/// @license GPL-3.0-or-later
+
+#ifndef LIMITANALYSISDIALOG_H
+#define LIMITANALYSISDIALOG_H
+
+#include <QDialog>
+
+class QFormLayout;
+class QTableWidget;
+
+/// @class LimitAnalysisDialog
+/// @brief Asks which S-parameter each limit line applies to and on which side
+/// of the line the trace must stay
+/// @details The limit lines of the chart are not tied to any trace, so the
+/// user picks the S-parameter and the direction of each one. The settings of
+/// the analysis (number of trials, iterations...) are added by the caller to
+/// settingsLayout()
+class LimitAnalysisDialog : public QDialog {
+  Q_OBJECT
+public:
+  /// @brief Dialog constructor
+  /// @param title Window title
+  /// @param limits Names of the limit lines (e.g. "Limit 1")
+  /// @param numPorts Number of ports of the simulated circuit
+  /// @param parent Pointer to parent widget
+  LimitAnalysisDialog(const QString &title, const QStringList &limits,
+                      int numPorts, QWidget *parent = nullptr);
+
+  /// @brief Form where the caller adds the settings of the analysis
+  QFormLayout *settingsLayout() const { return settings; }
+
+  /// @brief Gets the specification the user set for a limit line
+  /// @param limit Position of the limit in the list given to the constructor
+  /// @param[out] row S-parameter row (0-based)
+  /// @param[out] col S-parameter column (0-based)
+  /// @param[out] upper true if the trace must stay below the line
+  /// @return false if the limit line is not used
+  bool getTarget(int limit, int &row, int &col, bool &upper) const;
+
+private:
+  QTableWidget *table;   ///< One row per limit line
+  QFormLayout *settings; ///< Settings of the analysis
+  int numPorts;          ///< Number of ports of the circuit
+};
+
+#endif // LIMITANALYSISDIALOG_H
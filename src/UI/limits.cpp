@@ -7,6 +7,12 @@
 
 #include "qucs-s-spar-viewer.h"
 
+#include <QFormLayout>
+#include <QListWidget>
+#include <QProgressDialog>
+#include <QSpinBox>
+#include <QTimer>
+
 void Qucs_S_SPAR_Viewer::addLimit(double f_limit1, QString f_limit1_unit,
                                   double f_limit2, QString f_limit2_unit,
                                   double y_limit1, double y_limit2,
@@ -513,3 +519,332 @@ void Qucs_S_SPAR_Viewer::onLimitsOffsetChanged(double newOffset) {
   }
   Magnitude_PhaseChart->update();
 }
+
+QStringList Qucs_S_SPAR_Viewer::getMagnitudeLimitNames() {
+  QStringList names;
+  int n_limits = getNumberOfLimits();
+  for (int i = 0; i < n_limits; ++i) {
+    QString limit_name;
+    LimitProperties limit_props;
+    // Only the left axis holds magnitudes in dB
+    if (getLimitByPosition(i, limit_name, limit_props) &&
+        limit_props.axis->currentIndex() == 0) {
+      names.append(limit_name);
+    }
+  }
+  return names;
+}
+
+SpecificationLimit
+Qucs_S_SPAR_Viewer::getLimitSpecification(const QString &limit_name, int row,
+                                          int col, bool upper) {
+  const LimitProperties &limit_props = limitsMap[limit_name];
+
+  // Same conversion as the line drawn in the chart
+  SpecificationLimit limit;
+  limit.row = row;
+  limit.col = col;
+  limit.f1 = limit_props.Start_Freq->value() /
+             getFreqScale(limit_props.Start_Freq_Scale->currentText());
+  limit.f2 = limit_props.Stop_Freq->value() /
+             getFreqScale(limit_props.Stop_Freq_Scale->currentText());
+  limit.y1 = limit_props.Start_Value->value() + Limits_Offset->value();
+  limit.y2 = limit_props.Stop_Value->value() + Limits_Offset->value();
+  limit.upper = upper;
+  return limit;
+}
+
+vector<SpecificationLimit>
+Qucs_S_SPAR_Viewer::getLimitSpecifications(const LimitAnalysisDialog &dialog,
+                                           const QStringList &limits) {
+  vector<SpecificationLimit> specifications;
+  for (int i = 0; i < limits.size(); i++) {
+    int row, col;
+    bool upper;
+    if (dialog.getTarget(i, row, col, upper)) {
+      specifications.push_back(
+          getLimitSpecification(limits[i], row, col, upper));
+    }
+  }
+  return specifications;
+}
+
+void Qucs_S_SPAR_Viewer::runLimitAnalysis(
+    const QString &title, const QString &label,
+    std::function<void(SParameterCalculator &, AnalysisControl &)> analysis,
+    std::function<void(const QString &)> finished) {
+  // The analysis runs on a copy of the engine, so the window keeps responding
+  // and the circuit can be simulated again meanwhile
+  auto engine = std::make_shared<SParameterCalculator>(SPAR_engine);
+  auto control = std::make_shared<AnalysisControl>();
+  limitAnalysisControl = control;
+
+  QProgressDialog *progress =
+      new QProgressDialog(label, tr("Cancel"), 0, 0, this);
+  progress->setWindowTitle(title);
+  progress->setWindowModality(Qt::WindowModal);
+  progress->setMinimumDuration(0);
+  progress->setAutoClose(false);
+  progress->setAutoReset(false);
+  connect(progress, &QProgressDialog::canceled, this,
+          [control]() { control->abort = true; });
+
+  // The engine counts the steps it has done. The dialog shows a busy
+  // indicator until it knows how many there are
+  QTimer *timer = new QTimer(progress);
+  connect(timer, &QTimer::timeout, progress, [progress, control]() {
+    int total = control->total;
+    progress->setMaximum(total);
+    progress->setValue(std::min<int>(control->done, total));
+  });
+  timer->start(100);
+  progress->show();
+
+  fileLoadPool->start([this, engine, control, analysis, finished, progress]() {
+    QString error;
+    try {
+      analysis(*engine, *control);
+    } catch (const std::exception &e) {
+      error = QString::fromStdString(e.what());
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this, control, finished, progress, error]() {
+          progress->hide();
+          progress->deleteLater();
+          if (limitAnalysisControl == control) {
+            limitAnalysisControl.reset();
+          }
+          finished(error);
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+void Qucs_S_SPAR_Viewer::runYieldAnalysis() {
+  int numPorts = SPAR_engine.getNumPorts();
+  if (numPorts == 0) {
+    QMessageBox::information(
+        this, tr("Yield analysis"),
+        tr("Simulate a circuit with the design tools or the netlist "
+           "scratchpad first."));
+    return;
+  }
+  QStringList limits = getMagnitudeLimitNames();
+  if (limits.isEmpty()) {
+    QMessageBox::information(
+        this, tr("Yield analysis"),
+        tr("Add a limit line on the magnitude (left) axis first."));
+    return;
+  }
+
+  LimitAnalysisDialog dialog(tr("Yield analysis"), limits, numPorts, this);
+
+  QSpinBox *trials = new QSpinBox();
+  trials->setRange(10, 100000);
+  trials->setSingleStep(100);
+  trials->setValue(500);
+  dialog.settingsLayout()->addRow(tr("Trials"), trials);
+
+  QDoubleSpinBox *tolerance = new QDoubleSpinBox();
+  tolerance->setRange(0.1, 50);
+  tolerance->setSingleStep(0.5);
+  tolerance->setValue(5);
+  tolerance->setSuffix(" %");
+  dialog.settingsLayout()->addRow(tr("Component tolerance (±)"), tolerance);
+
+  QComboBox *distribution = new QComboBox();
+  distribution->addItem(tr("Uniform"));
+  distribution->addItem(tr("Gaussian (tolerance = 3σ)"));
+  dialog.settingsLayout()->addRow(tr("Distribution"), distribution);
+
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+
+  vector<SpecificationLimit> specifications =
+      getLimitSpecifications(dialog, limits);
+  if (specifications.empty()) {
+    QMessageBox::information(this, tr("Yield analysis"),
+                             tr("No limit line was assigned to a trace."));
+    return;
+  }
+
+  // The same tolerance applies to every component value of the circuit
+  Tolerance component_tolerance;
+  component_tolerance.relative = tolerance->value() / 100;
+  component_tolerance.distribution = distribution->currentIndex() == 1
+                                         ? Tolerance::Gaussian
+                                         : Tolerance::Uniform;
+  int numTrials = trials->value();
+
+  // The tolerances are set on the copy of the engine that runs the trials
+  auto result = std::make_shared<MonteCarloResult>();
+  runLimitAnalysis(
+      tr("Yield analysis"), tr("Simulating %1 trials...").arg(numTrials),
+      [result, numTrials, specifications,
+       component_tolerance](SParameterCalculator &engine,
+                            AnalysisControl &control) {
+        for (int kind = SensitivityParameter::Resistance;
+             kind <= SensitivityParameter::CoupledMicrostripLength; kind++) {
+          engine.setDefaultTolerance(SensitivityParameter::Kind(kind),
+                                     component_tolerance);
+        }
+        *result = engine.runMonteCarlo(numTrials, specifications, 1, &control);
+      },
+      [this, result](const QString &error) {
+        if (!error.isEmpty()) {
+          QMessageBox::critical(this, tr("Yield analysis"),
+                                tr("The analysis failed: %1").arg(error));
+          return;
+        }
+        if (result->aborted) {
+          statusBar()->showMessage(tr("Yield analysis cancelled"), 5000);
+          return;
+        }
+        QString summary = tr("%1 of %2 trials meet the limits. Yield: %3 %")
+                              .arg(result->passed)
+                              .arg(result->trials)
+                              .arg(100 * result->yield, 0, 'f', 1);
+        statusBar()->showMessage(summary, 5000);
+        QMessageBox::information(this, tr("Yield analysis"), summary);
+      });
+}
+
+void Qucs_S_SPAR_Viewer::optimizeToLimits() {
+  int numPorts = SPAR_engine.getNumPorts();
+  if (numPorts == 0) {
+    QMessageBox::information(
+        this, tr("Optimization"),
+        tr("Simulate a circuit with the design tools or the netlist "
+           "scratchpad first."));
+    return;
+  }
+  QStringList limits = getMagnitudeLimitNames();
+  if (limits.isEmpty()) {
+    QMessageBox::information(
+        this, tr("Optimization"),
+        tr("Add a limit line on the magnitude (left) axis first."));
+    return;
+  }
+  // Copied, since the circuit is compiled again after the optimization
+  const vector<SensitivityParameter> parameters =
+      SPAR_engine.getSensitivityParameters();
+  if (parameters.empty()) {
+    QMessageBox::information(this, tr("Optimization"),
+                             tr("The circuit has no values to tune."));
+    return;
+  }
+
+  LimitAnalysisDialog dialog(tr("Optimization"), limits, numPorts, this);
+
+  QListWidget *variables = new QListWidget();
+  for (const auto &parameter : parameters) {
+    QListWidgetItem *item = new QListWidgetItem(
+        QString("%1.%2 = %3")
+            .arg(QString::fromStdString(parameter.component),
+                 QString::fromStdString(parameter.name),
+                 SParameterCalculator::formatParameterValue(parameter)),
+        variables);
+    item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+    item->setCheckState(Qt::Checked);
+  }
+  dialog.settingsLayout()->addRow(tr("Values to tune"), variables);
+
+  QDoubleSpinBox *range = new QDoubleSpinBox();
+  range->setRange(1, 100);
+  range->setValue(50);
+  range->setSuffix(" %");
+  range->setToolTip(tr("Maximum change of each value (100 %: no bounds)"));
+  dialog.settingsLayout()->addRow(tr("Range (±)"), range);
+
+  QSpinBox *iterations = new QSpinBox();
+  iterations->setRange(1, 1000);
+  iterations->setValue(100);
+  dialog.settingsLayout()->addRow(tr("Maximum iterations"), iterations);
+
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+
+  vector<SpecificationLimit> goals = getLimitSpecifications(dialog, limits);
+  vector<OptimizationVariable> tuned;
+  double r = range->value() / 100;
+  for (int i = 0; i < variables->count(); i++) {
+    if (variables->item(i)->checkState() != Qt::Checked) {
+      continue;
+    }
+    OptimizationVariable variable;
+    variable.component = parameters[i].component;
+    variable.parameter = parameters[i].name;
+    variable.minimum = parameters[i].value * (1 - r);
+    variable.maximum = r < 1 ? parameters[i].value * (1 + r) : 0;
+    tuned.push_back(variable);
+  }
+  if (goals.empty() || tuned.empty()) {
+    QMessageBox::information(
+        this, tr("Optimization"),
+        tr("Assign at least one limit line to a trace and select at least "
+           "one value to tune."));
+    return;
+  }
+
+  int maxIterations = iterations->value();
+
+  auto result = std::make_shared<OptimizationResult>();
+  runLimitAnalysis(
+      tr("Optimization"), tr("Tuning %1 values...").arg(tuned.size()),
+      [result, tuned, goals, maxIterations](SParameterCalculator &engine,
+                                            AnalysisControl &control) {
+        *result = engine.optimize(tuned, goals, maxIterations, &control);
+      },
+      [this, result](const QString &error) {
+        if (!error.isEmpty()) {
+          QMessageBox::critical(this, tr("Optimization"),
+                                tr("The optimization failed: %1").arg(error));
+          return;
+        }
+        if (result->aborted) {
+          // The circuit keeps its values
+          statusBar()->showMessage(tr("Optimization cancelled"), 5000);
+          return;
+        }
+        applyOptimizationResult(*result);
+      });
+}
+
+void Qucs_S_SPAR_Viewer::applyOptimizationResult(
+    const OptimizationResult &result) {
+  // The tools keep the schematic, so the values are written into it and the
+  // netlist is generated again. Plain netlists get the values written back
+  // into their text
+  QStringList not_applied;
+  if (!Circuit.getComponents().isEmpty()) {
+    for (const auto &variable : result.variables) {
+      QString component = QString::fromStdString(variable.component);
+      QString name = QString::fromStdString(variable.name);
+      if (!Circuit.setComponentValue(
+              component, name,
+              SParameterCalculator::formatParameterValue(variable))) {
+        not_applied.append(component + "." + name);
+      }
+    }
+  } else {
+    Circuit.setNetlist(result.netlist);
+  }
+  updateSimulation(Circuit);
+
+  QString summary =
+      tr("Cost: %1 -> %2 after %3 iterations. %4")
+          .arg(result.initialCost, 0, 'g', 4)
+          .arg(result.finalCost, 0, 'g', 4)
+          .arg(result.iterations)
+          .arg(result.finalCost == 0 ? tr("All the limits are met.")
+                                     : tr("Some limits are not met."));
+  if (!not_applied.isEmpty()) {
+    summary += "\n" + tr("Not found in the schematic: %1")
+                          .arg(not_applied.join(", "));
+  }
+  statusBar()->showMessage(summary.section('\n', 0, 0), 5000);
+  QMessageBox::information(this, tr("Optimization"), summary);
+}
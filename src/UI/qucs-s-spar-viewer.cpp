@@ -15,6 +15,7 @@
 #include <QClipboard>
 #include <QComboBox>
 #include <QDebug>
+#include <QFileDialog>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -56,6 +57,12 @@ Qucs_S_SPAR_Viewer::Qucs_S_SPAR_Viewer() {
   default_colors.append(QColor(Qt::darkYellow));
   default_colors.append(QColor(Qt::darkMagenta));
 
+  // Points of the last simulation that could not be solved (see
+  // runSimulation()). The tools may simulate while the panels are created
+  simulationStatusLabel = new QLabel();
+  simulationStatusLabel->hide();
+  statusBar()->addPermanentWidget(simulationStatusLabel);
+
   CreateDisplayWidgets();
   CreateRightPanel();
 
@@ -66,6 +73,23 @@ Qucs_S_SPAR_Viewer::Qucs_S_SPAR_Viewer() {
   connect(fileWatcher, &QFileSystemWatcher::directoryChanged, this,
           &Qucs_S_SPAR_Viewer::directoryChanged);
 
+  // Background file loading. The progress and the cancel button are shown in
+  // the status bar while a batch is being read
+  fileLoadPool = new QThreadPool(this);
+  fileLoadCancelled = std::make_shared<std::atomic<bool>>(false);
+  fileLoadProgress = new QProgressBar();
+  fileLoadProgress->setFormat(tr("Loading files: %v of %m"));
+  fileLoadProgress->setMaximumWidth(250);
+  fileLoadProgress->hide();
+  statusBar()->addPermanentWidget(fileLoadProgress);
+  fileLoadCancelButton = new QToolButton();
+  fileLoadCancelButton->setText(tr("Cancel"));
+  fileLoadCancelButton->setToolTip(tr("Skip the files not read yet"));
+  fileLoadCancelButton->hide();
+  statusBar()->addPermanentWidget(fileLoadCancelButton);
+  connect(fileLoadCancelButton, &QToolButton::clicked, this,
+          [this]() { *fileLoadCancelled = true; });
+
   // Put the following widgets on the top to make them visible to the user
   dockFiles->raise();
   dockChart->raise();
@@ -76,6 +100,14 @@ Qucs_S_SPAR_Viewer::Qucs_S_SPAR_Viewer() {
 }
 
 Qucs_S_SPAR_Viewer::~Qucs_S_SPAR_Viewer() {
+  // The files being read and the limit analysis still post their results to
+  // the window
+  *fileLoadCancelled = true;
+  if (limitAnalysisControl) {
+    limitAnalysisControl->abort = true;
+  }
+  fileLoadPool->waitForDone();
+
   QSettings settings;
   settings.setValue("recentFiles", QVariant::fromValue(recentFiles));
   delete smithChart;
@@ -131,6 +163,34 @@ void Qucs_S_SPAR_Viewer::CreateMenuBar() {
           &Qucs_S_SPAR_Viewer::slotLoadCustomTheme);
   themeMenu->addAction(customThemeAction);
 
+  viewMenu->addSeparator();
+
+  // Profiling of the simulation pipeline
+  QAction *profilingAction = new QAction(tr("&Profiling"), this);
+  profilingAction->setCheckable(true);
+  profilingAction->setChecked(Profiler::isEnabled());
+  connect(profilingAction, &QAction::toggled, this,
+          &Qucs_S_SPAR_Viewer::slotSetProfiling);
+  viewMenu->addAction(profilingAction);
+
+  QAction *profilingTraceAction =
+      new QAction(tr("Save profiling &trace..."), this);
+  connect(profilingTraceAction, &QAction::triggered, this,
+          &Qucs_S_SPAR_Viewer::slotSaveProfilingTrace);
+  viewMenu->addAction(profilingTraceAction);
+
+  // Binary cache of the datasets of large files. The SPAR_DATASET_CACHE
+  // environment variable sets the default until the user picks a choice
+  QSettings settings;
+  DatasetCache::setEnabled(
+      settings.value("datasetCache", DatasetCache::isEnabled()).toBool());
+  QAction *datasetCacheAction =
+      new QAction(tr("&Cache large data files"), this);
+  datasetCacheAction->setCheckable(true);
+  datasetCacheAction->setChecked(DatasetCache::isEnabled());
+  connect(datasetCacheAction, &QAction::toggled, this,
+          &Qucs_S_SPAR_Viewer::slotSetDatasetCache);
+  viewMenu->addAction(datasetCacheAction);
 
   // Create calculators menu
   QMenu *calculatorsMenu = CreateCalculatorsMenu();
@@ -160,6 +220,37 @@ void Qucs_S_SPAR_Viewer::CreateMenuBar() {
   menuBar()->addMenu(helpMenu);
 }
 
+void Qucs_S_SPAR_Viewer::slotSetProfiling(bool enable) {
+  Profiler::setEnabled(enable);
+  if (enable) {
+    statusBar()->showMessage(tr("Profiling enabled"));
+  } else {
+    statusBar()->clearMessage();
+  }
+}
+
+void Qucs_S_SPAR_Viewer::slotSaveProfilingTrace() {
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Save profiling trace"), QDir::homePath() + "/spar_trace.json",
+      tr("Chrome trace (*.json)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  if (!Profiler::writeChromeTrace(fileName)) {
+    QMessageBox::warning(this, tr("Profiling"),
+                         tr("Cannot write the trace file %1").arg(fileName));
+  }
+}
+
+void Qucs_S_SPAR_Viewer::slotSetDatasetCache(bool enable) {
+  DatasetCache::setEnabled(enable);
+  if (!enable) {
+    DatasetCache::clear();
+  }
+  QSettings settings;
+  settings.setValue("datasetCache", enable);
+}
+
 void Qucs_S_SPAR_Viewer::CreateRightPanel() {
   // Create left panel widgets
   setFileManagementDock();
@@ -657,6 +748,23 @@ void Qucs_S_SPAR_Viewer::setLimitManagementDock() {
 
   LimitsGrid->addWidget(Button_Remove_All_Limits, 0, 1);
 
+  // Analyses of the simulated circuit against the limit lines
+  Button_Limits_Yield = new QPushButton("Yield analysis");
+  Button_Limits_Yield->setToolTip(
+      "Monte Carlo analysis of the simulated circuit against the limits");
+  connect(Button_Limits_Yield, &QPushButton::clicked, this,
+          &Qucs_S_SPAR_Viewer::runYieldAnalysis);
+
+  LimitsGrid->addWidget(Button_Limits_Yield, 1, 0);
+
+  Button_Limits_Optimize = new QPushButton("Optimize");
+  Button_Limits_Optimize->setToolTip(
+      "Tune the simulated circuit until it meets the limits");
+  connect(Button_Limits_Optimize, &QPushButton::clicked, this,
+          &Qucs_S_SPAR_Viewer::optimizeToLimits);
+
+  LimitsGrid->addWidget(Button_Limits_Optimize, 1, 1);
+
   QGroupBox *LimitSettings = new QGroupBox("Settings");
   QGridLayout *LimitsSettingLayout = new QGridLayout(LimitSettings);
   QLabel *LimitsOffsetLabel = new QLabel("<b>Limits Offset</>");
@@ -1569,87 +1677,142 @@ void Qucs_S_SPAR_Viewer::setupFileWatcher() {
 }
 
 void Qucs_S_SPAR_Viewer::fileChanged(const QString &path) {
-  // Don't process the same file within a short time window
-  static QMap<QString, QDateTime> lastProcessedTimes;
-  static const int debounceTime = 500; // milliseconds
-
-  QDateTime currentTime = QDateTime::currentDateTime();
-  if (lastProcessedTimes.contains(path)) {
-    if (lastProcessedTimes[path].msecsTo(currentTime) < debounceTime) {
-      qDebug() << "Debouncing file change for:" << path;
-      return;
-    }
+  // Find the dataset associated with this file
+  QString datasetName = watchedFilePaths.key(path);
+  if (datasetName.isEmpty()) {
+    qDebug() << "File changed but not in our datasets:" << path;
+    return;
   }
-  lastProcessedTimes[path] = currentTime;
-
-  QFileInfo fileInfo(path);
-  QString fileName = fileInfo.fileName();
-
-  // Some file systems might report the file as deleted when modified
-  // Wait a moment to see if the file reappears and to ensure file is fully
-  // written
-  QTimer::singleShot(200, this, [this, path, fileName, fileInfo]() {
-    if (!QFile::exists(path)) {
-      qDebug() << "File no longer exists:" << path;
-      return;
-    }
 
-    // Wait a bit more to ensure the file is completely written and unlocked
-    QFile file(path);
-    int attempts = 0;
-    const int maxAttempts = 5;
-    while (attempts < maxAttempts) {
-      if (file.open(QIODevice::ReadOnly)) {
-        file.close();
-        break;
-      }
-      QThread::msleep(100);
-      attempts++;
-    }
+  std::shared_ptr<FileReload> &reload = fileReloads[path];
+  if (!reload) {
+    reload = std::make_shared<FileReload>();
+  }
+  if (reload->running) {
+    // A writer that appends progressively sends a burst of changes. They are
+    // read together when the current reload finishes
+    reload->pending = true;
+    return;
+  }
+  startFileReload(path, reload);
+}
 
-    if (attempts == maxAttempts) {
-      qWarning() << "Could not open file after multiple attempts:" << path;
-      return;
-    }
+void Qucs_S_SPAR_Viewer::startFileReload(const QString &path,
+                                         std::shared_ptr<FileReload> reload) {
+  reload->running = true;
+  reload->pending = false;
 
-    // Find the dataset associated with this file
-    QString datasetName;
-    for (auto it = watchedFilePaths.begin(); it != watchedFilePaths.end();
-         ++it) {
-      if (it.value() == path) {
-        datasetName = it.key();
-        break;
-      }
-    }
+  QString suffix = QFileInfo(path).suffix().toLower();
+  if (!reload->tail &&
+      ((suffix.startsWith("s") && suffix.endsWith("p")) || suffix == "ts")) {
+    reload->tail = std::make_unique<TouchstoneTailReader>(path);
+  }
 
-    if (datasetName.isEmpty()) {
-      qDebug() << "File changed but not in our datasets:" << path;
-      return;
+  // The short wait gathers the changes of a writer that is still busy, so the
+  // plots are not redrawn for every line it writes
+  QTimer::singleShot(200, this, [this, path, reload]() {
+    fileLoadPool->start([this, path, reload]() { reloadFile(path, reload); });
+  });
+}
+
+void Qucs_S_SPAR_Viewer::reloadFile(const QString &path,
+                                    std::shared_ptr<FileReload> reload) {
+  // Some file systems report the file as deleted while it is replaced, and
+  // the writer may keep it locked for a moment
+  QFile file(path);
+  int attempts = 0;
+  const int maxAttempts = 5;
+  while (attempts < maxAttempts && !file.open(QIODevice::ReadOnly)) {
+    QThread::msleep(100);
+    attempts++;
+  }
+  file.close();
+
+  TouchstoneTailReader::Update update = TouchstoneTailReader::Update::Failed;
+  QMap<QString, QList<double>> file_data;
+  if (attempts < maxAttempts) {
+    if (reload->tail) {
+      SParSweep sweep;
+      update = reload->tail->update(sweep);
+      if (update == TouchstoneTailReader::Update::Appended ||
+          update == TouchstoneTailReader::Update::Reloaded) {
+        file_data = sweepToDataset(sweep);
+      }
+    } else {
+      file_data = loadSparamFile(path);
+      if (!file_data.isEmpty()) {
+        update = TouchstoneTailReader::Update::Reloaded;
+      }
     }
+  }
 
-    qDebug() << "Reloading file:" << path << "for dataset:" << datasetName;
+  QMetaObject::invokeMethod(
+      this,
+      [this, path, reload, update, file_data]() {
+        fileReloadFinished(path, reload, update, file_data);
+      },
+      Qt::QueuedConnection);
+}
 
-    QMap<QString, QList<double>> file_data = loadSparamFile(path);
+void Qucs_S_SPAR_Viewer::fileReloadFinished(
+    const QString &path, const std::shared_ptr<FileReload> &reload,
+    TouchstoneTailReader::Update update,
+    const QMap<QString, QList<double>> &file_data) {
+  reload->running = false;
 
-    // Verify we actually loaded data
-    if (file_data.isEmpty()) {
-      qWarning() << "Failed to load data from file:" << path;
-      return;
-    }
+  // The file may have been removed while it was being read
+  QString datasetName = watchedFilePaths.key(path);
+  if (fileReloads.value(path) != reload || datasetName.isEmpty() ||
+      !datasets.contains(datasetName)) {
+    return;
+  }
 
+  switch (update) {
+  case TouchstoneTailReader::Update::Unchanged:
+    break;
+  case TouchstoneTailReader::Update::Failed:
+    qWarning() << "Failed to load data from file:" << path;
+    break;
+  case TouchstoneTailReader::Update::Reloaded:
     // Replace the dataset with updated data
     datasets[datasetName] = file_data;
+    break;
+  case TouchstoneTailReader::Update::Appended: {
+    QMap<QString, QList<double>> &dataset = datasets[datasetName];
+    // The derived traces (stability factors, group delay, ...) are computed
+    // from the whole sweep. As after a full reload, they are dropped and
+    // computed again by the plot update
+    for (auto it = dataset.begin(); it != dataset.end();) {
+      if (file_data.contains(it.key())) {
+        ++it;
+      } else {
+        it = dataset.erase(it);
+      }
+    }
+    for (auto it = file_data.cbegin(); it != file_data.cend(); ++it) {
+      if (it.key() == "n_ports" || it.key() == "Z0") {
+        continue; // Single values
+      }
+      dataset[it.key()].append(it.value());
+    }
+    break;
+  }
+  }
 
+  if (update == TouchstoneTailReader::Update::Appended ||
+      update == TouchstoneTailReader::Update::Reloaded) {
     // Update any plots that use this dataset
     updateAllPlots(datasetName);
+  }
 
-    // Make sure the file watcher is still watching this file
-    if (!fileWatcher->files().contains(path)) {
-      fileWatcher->addPath(path);
-    }
+  // Make sure the file watcher is still watching this file
+  if (QFile::exists(path) && !fileWatcher->files().contains(path)) {
+    fileWatcher->addPath(path);
+  }
 
-    qDebug() << "Successfully updated dataset:" << datasetName;
-  });
+  if (reload->pending) {
+    startFileReload(path, reload);
+  }
 }
 
 void Qucs_S_SPAR_Viewer::directoryChanged(const QString &path) {
@@ -1659,9 +1822,9 @@ void Qucs_S_SPAR_Viewer::directoryChanged(const QString &path) {
   // List all files
   const QStringList allFiles = dir.entryList(QDir::Files);
 
-  // Regular expression for S-Parameter files (*.s1p, *.s2p, ..., *.snp) and
-  // data files
-  QRegularExpression sparamRegex(R"(\.s\d+p$)",
+  // Regular expression for S-Parameter files (*.s1p, *.s2p, ..., *.snp,
+  // *.ts) and data files
+  QRegularExpression sparamRegex(R"(\.(s\d+p|ts)$)",
                                  QRegularExpression::CaseInsensitiveOption);
   QRegularExpression snpRegex(R"(\.s\d+p$)",
                               QRegularExpression::CaseInsensitiveOption);
@@ -1672,7 +1835,7 @@ void Qucs_S_SPAR_Viewer::directoryChanged(const QString &path) {
 
   QStringList filesToAdd;
   for (const QString &file : allFiles) {
-    // Match *.snp (n is 1 or more digits), *.dat, *.ngspice.dat
+    // Match *.snp (n is 1 or more digits), *.ts, *.dat, *.ngspice.dat
     if (sparamRegex.match(file).hasMatch() || datRegex.match(file).hasMatch() ||
         ngspiceDatRegex.match(file).hasMatch()) {
       if (!filePaths.contains(file)) {
@@ -1748,6 +1911,7 @@ void Qucs_S_SPAR_Viewer::directoryChanged(const QString &path) {
 }
 
 void Qucs_S_SPAR_Viewer::updateAllPlots(const QString &datasetName) {
+  PROFILE_SCOPE("updateAllPlots");
   // Refresh all traces on each chart
   updateTracesInWidget(Magnitude_PhaseChart, datasetName);
   updateTracesInWidget(smithChart, datasetName);
@@ -1922,7 +2086,7 @@ bool Qucs_S_SPAR_Viewer::isSparamFile(const QString &path) {
   QFileInfo fi(path);
   return fi.exists() &&
          (path.endsWith(".dat", Qt::CaseInsensitive) ||
-          QRegularExpression(R"(\.s\d+p$)",
+          QRegularExpression(R"(\.(s\d+p|ts)$)",
                              QRegularExpression::CaseInsensitiveOption)
               .match(path)
               .hasMatch());
@@ -1933,16 +2097,17 @@ void Qucs_S_SPAR_Viewer::addPathToWatcher(const QString &path) {
     fileWatcher->addPath(path);
     qDebug() << "Watching directory:" << path;
 
-    // Find all files ending with ".dat" or ".snp" (n is an integer),
+    // Find all files ending with ".dat", ".snp" (n is an integer) or ".ts",
     // case-insensitive
     QDir dir(path);
     QStringList filters;
-    filters << "*.dat" << "*.DAT" << "*.s*" << "*.S*"; // Add uppercase patterns
+    filters << "*.dat" << "*.DAT" << "*.s*" << "*.S*" << "*.ts"
+            << "*.TS"; // Add uppercase patterns
     dir.setNameFilters(filters);
 
     QStringList matchingFiles;
     QRegularExpression snpRegex(
-        R"(\.s\d+p$)",
+        R"(\.(s\d+p|ts)$)",
         QRegularExpression::CaseInsensitiveOption); // Case-insensitive
 
     // Iterate through all files in the directory
@@ -25,9 +25,12 @@
 
 #include "SPAR/SParameterCalculator.h"
 
+#include "Misc/datasetCache.h"
 #include "Misc/general.h"
+#include "Misc/profiler.h"
 
 #include "aboutdialog.h"
+#include "limitanalysisdialog.h"
 
 
 #include <QCheckBox>
@@ -36,10 +39,16 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QMainWindow>
+#include <QProgressBar>
 #include <QScrollArea>
+#include <QStatusBar>
 #include <QTableWidget>
+#include <QThreadPool>
 #include <QtGlobal>
+#include <atomic>
 #include <complex>
+#include <functional>
+#include <memory>
 #include <utility> // std::as_const()
 
 
@@ -223,6 +232,21 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     /// @brief Pop up window to let the user to add a custom theme file
     void slotLoadCustomTheme();
 
+    /// @brief Enable or disable the profiling of the simulation pipeline
+    /// @details While enabled, the time spent in each phase of the last
+    /// update is shown in the status bar
+    /// @param enable Profiling state
+    void slotSetProfiling(bool enable);
+
+    /// @brief Save the recorded phases as a Chrome trace (JSON)
+    void slotSaveProfilingTrace();
+
+    /// @brief Enable or disable the binary cache of large data files
+    /// @details The choice is kept in the settings. Disabling the cache also
+    /// deletes the cached datasets
+    /// @param enable Cache state
+    void slotSetDatasetCache(bool enable);
+
     /// @brief Raise appropriate widgets when trace tab is selected
     ///
     /// Synchronizes the trace tab selection with:
@@ -252,16 +276,17 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     /// @see addFiles(QStringList)
     void addFile();
 
-    /// @brief Add a single file using QFileInfo
+    /// @brief Add data files
     ///
-    /// Wrapper function for adding a single file. Used when opening
-    /// files from command line.
+    /// The files are parsed concurrently on a thread pool. Each dataset is
+    /// added to the file dock when its file has been read, and the status bar
+    /// shows the progress with a button to cancel the rest of the batch.
+    /// Files added while a batch is running join that batch.
     ///
-    /// @param fileInfo QFileInfo object containing file path information
-    /// @note Validates file existence before attempting to load
-    /// @note Shows warning dialog if file doesn't exist
-    /// @note Internally calls addFiles(QStringList) with single-item list
-    void addFiles(QStringList);
+    /// @param fileNames Paths of the files
+    /// @note Files whose dataset is already loaded (or being loaded) are
+    /// skipped
+    void addFiles(QStringList fileNames);
 
     /// @brief Remove file via UI
     /// Called when a remove button is clicked. Identifies which file
@@ -344,12 +369,13 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
 
     /// @brief Handle file change event from file watcher
     ///
-    /// Implements debouncing and robust file handling:
-    /// 1. Debounces rapid file change events (500ms window)
-    /// 2. Waits for file to be completely written (200ms delay + retry logic)
-    /// 3. Reloads the file data using appropriate parser
-    /// 4. Updates all plots using the new data
-    /// 5. Re-adds file to watcher if needed
+    /// The file is read again on the thread pool (see startFileReload()):
+    /// 1. Touchstone files are followed from the offset reached by the
+    ///    previous reload, so only the points appended meanwhile are parsed.
+    ///    They are read from the start if the earlier content changed
+    /// 2. Other files are read again from the start
+    /// 3. Changes that arrive while the file is being read are handled by one
+    ///    more reload when it finishes
     ///
     /// @param path Full path to the changed file
     void fileChanged(const QString& path);
@@ -574,6 +600,62 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     /// @return bool True if position is valid and limit retrieved, false otherwise
     bool getLimitByPosition(int, QString&, LimitProperties&);
 
+    /// @brief Names of the limit lines drawn on the magnitude (left) axis
+    QStringList getMagnitudeLimitNames();
+
+    /// @brief Converts a limit line of the chart into a specification of the
+    /// simulated circuit
+    /// @param limit_name Name of the limit (e.g., "Limit 1")
+    /// @param row S-parameter row (0-based)
+    /// @param col S-parameter column (0-based)
+    /// @param upper true if the trace must stay below the line
+    /// @return Limit in Hz and dB, with the limits offset applied
+    SpecificationLimit getLimitSpecification(const QString& limit_name,
+                                             int row, int col, bool upper);
+
+    /// @brief Collects the specifications chosen in a LimitAnalysisDialog
+    /// @param dialog Accepted dialog
+    /// @param limits Limit names the dialog was built with
+    /// @return One specification per limit line in use
+    vector<SpecificationLimit> getLimitSpecifications(
+        const LimitAnalysisDialog& dialog, const QStringList& limits);
+
+    /// @brief Runs an analysis of the simulated circuit against the limit
+    /// lines on fileLoadPool, while a progress dialog with a cancel button is
+    /// shown
+    /// @param title Title of the progress dialog
+    /// @param label Text of the progress dialog
+    /// @param analysis Runs the analysis on a copy of SPAR_engine (pool
+    /// thread). The errors are thrown
+    /// @param finished Gets the error message, empty on success (GUI thread)
+    void runLimitAnalysis(
+        const QString& title, const QString& label,
+        std::function<void(SParameterCalculator&, AnalysisControl&)> analysis,
+        std::function<void(const QString&)> finished);
+
+    /// @brief Runs a Monte Carlo yield analysis of the simulated circuit
+    /// against the limit lines
+    ///
+    /// The user picks the S-parameter and direction of each limit line, the
+    /// component tolerance and the number of trials. The tolerance applies
+    /// to all the component values of the circuit simulated by the design
+    /// tools or the netlist scratchpad.
+    void runYieldAnalysis();
+
+    /// @brief Tunes the component values of the simulated circuit until it
+    /// meets the limit lines
+    ///
+    /// The user picks the S-parameter and direction of each limit line and
+    /// the values to tune. The optimized values are written into the
+    /// schematic of the design tool, or into the netlist of the scratchpad,
+    /// and the circuit is simulated again.
+    void optimizeToLimits();
+
+    /// @brief Writes the values found by the optimizer into the circuit,
+    /// simulates it again and reports the cost
+    /// @param result Outcome of SParameterCalculator::optimize()
+    void applyOptimizationResult(const OptimizationResult& result);
+
     /// @brief Toggle coupling between start and stop Y values
     ///
     /// Controls whether start and stop Y values are synchronized:
@@ -711,6 +793,70 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     QFileSystemWatcher* fileWatcher;          ///< File system watcher object
     QMap<QString, QString> watchedFilePaths;  ///< Relates the file name with a file path
 
+    /// @struct FileReload
+    /// @brief Reload state of a watched file
+    struct FileReload {
+        /// Parse state of a Touchstone file, used only by the running reload
+        std::unique_ptr<TouchstoneTailReader> tail;
+        bool running = false; ///< A reload is in progress
+        bool pending = false; ///< The file changed again meanwhile
+    };
+    /// Reload state of each watched file that has changed, keyed by path
+    QMap<QString, std::shared_ptr<FileReload>> fileReloads;
+
+    /// @brief Reads a watched file again on the thread pool, after a short
+    /// wait for the writer
+    /// @param path Path of the file
+    /// @param reload Reload state of the file
+    void startFileReload(const QString& path,
+                         std::shared_ptr<FileReload> reload);
+
+    /// @brief Reads a watched file and posts the result to
+    /// fileReloadFinished() (thread pool)
+    /// @param path Path of the file
+    /// @param reload Reload state of the file
+    void reloadFile(const QString& path, std::shared_ptr<FileReload> reload);
+
+    /// @brief Applies the data read by a reload to the dataset of the file
+    /// and updates the plots (GUI thread)
+    /// @param path Path of the file
+    /// @param reload Reload state of the file
+    /// @param update Outcome of the reload
+    /// @param file_data Points appended to the file (Appended) or all of them
+    /// (Reloaded)
+    void fileReloadFinished(const QString& path,
+                            const std::shared_ptr<FileReload>& reload,
+                            TouchstoneTailReader::Update update,
+                            const QMap<QString, QList<double>>& file_data);
+
+    // Background file loading (see addFiles())
+    QThreadPool* fileLoadPool;           ///< Threads that parse the files
+    /// Set to skip the files of the batch that have not been read yet
+    std::shared_ptr<std::atomic<bool>> fileLoadCancelled;
+    QStringList pendingDatasets;         ///< Datasets being loaded
+    QStringList loadedFiles;             ///< Files of the batch that were added
+    int fileLoadTotal = 0;               ///< Files in the batch
+    int fileLoadDone = 0;                ///< Files of the batch already handled
+    QProgressBar* fileLoadProgress;      ///< Progress of the batch
+    QToolButton* fileLoadCancelButton;   ///< Cancels the batch
+    /// Unsolved points of the last simulation. Hidden if there are none
+    QLabel* simulationStatusLabel;
+
+    /// @brief Returns the dataset name of a data file: its name without the
+    /// extension (.sNp, .ts, .dat or .dat.ngspice)
+    static QString datasetNameFromFile(const QString& path);
+
+    /// @brief Adds a dataset read by the background loader (GUI thread)
+    /// @param path Path of the file
+    /// @param file_data Data read from the file. Empty if it could not be read
+    void addLoadedFile(const QString& path,
+                       const QMap<QString, QList<double>>& file_data);
+
+    /// @brief Accounts for a file of the batch. When it is the last one, the
+    /// default traces and the file watcher are set up (GUI thread)
+    /// @param path Path of the file
+    void fileLoadFinished(const QString& path);
+
 
     // Plot widgets
     // Magnitude plot
@@ -780,6 +926,8 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     QGridLayout* LimitsGrid;                 ///< Grid layout for limits
     QPushButton *Button_add_Limit;           ///< Button to add limit
     QPushButton *Button_Remove_All_Limits;   ///< Button to remove all limits
+    QPushButton *Button_Limits_Yield;        ///< Button to run the yield analysis
+    QPushButton *Button_Limits_Optimize;     ///< Button to optimize to the limits
     CustomDoubleSpinBox* Limits_Offset;           ///< Spin box for limit offset
 
     /// @brief Groups the widgets related to the traces. They are accessible by name (map key)
@@ -834,6 +982,8 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
 
     // S-parameter simulation class
     SParameterCalculator SPAR_engine;
+    /// Analysis running on the pool (see runLimitAnalysis()). Null if none
+    std::shared_ptr<AnalysisControl> limitAnalysisControl;
 
     // Substrate
     MS_Substrate MS_Subs;
@@ -985,12 +1135,17 @@ class Qucs_S_SPAR_Viewer : public QMainWindow {
     /// @param Name of the theme {'light', 'dark', 'custom'}
     void applyTheme(const QString& themeName);
 
+    /// @brief Simulates the current circuit and refreshes its traces
+    void runSimulation();
+
   private slots:
     /// @brief Update simulation traces
     /// @param SI Schematic description
     void updateSimulation(SchematicContent SI);
 
     /// @brief Force simulation update
+    /// @details When profiling is enabled, the phases of the update are shown
+    /// in the status bar
     void updateSimulation();
 
     /// @brief Update substrate parameters
@@ -136,6 +136,18 @@ void Qucs_S_SPAR_Viewer::setToolsDock() {
           &Qucs_S_SPAR_Viewer::callTools);
 }
 void Qucs_S_SPAR_Viewer::updateSimulation() {
+  // The scope ends before the readout, so it is included in it
+  {
+    PROFILE_SCOPE("updateSimulation");
+    runSimulation();
+  }
+  if (Profiler::isEnabled()) {
+    statusBar()->showMessage(Profiler::summary());
+    Profiler::mark();
+  }
+}
+
+void Qucs_S_SPAR_Viewer::runSimulation() {
   QString netlist = Circuit.getSParameterNetlist();
   qDebug() << "Netlist";
   qDebug() << netlist;
@@ -149,7 +161,7 @@ void Qucs_S_SPAR_Viewer::updateSimulation() {
   // Pass settings to the S-parameter engine
   SPAR_engine.setFrequencySweep(fstart, fstop, npoints);
   SPAR_engine.calculateSParameterSweep();
-  QMap<QString, QList<double>> data = SPAR_engine.getData();
+  const SParSweep &sweep = SPAR_engine.getSweep();
 
   ///////////////////////////////////////////////////////////
   // Update the data on the Schematic Object. This is needed
@@ -159,14 +171,42 @@ void Qucs_S_SPAR_Viewer::updateSimulation() {
   Circuit.setFrequencySweep(fstart_text, fstop_text, npoints);
   ///////////////////////////////////////////////////////////
 
-  if (data.isEmpty()) {
+  if (sweep.empty() || SPAR_engine.getNumPorts() == 0) {
+    simulationStatusLabel->hide();
     return;
   }
 
   QString dataset_name = Circuit.Name;
 
   // Update data
-  datasets[dataset_name] = data;
+  QStringList parameters;
+  if (SPAR_engine.getSensitivityAnalysis()) {
+    for (const auto &parameter : SPAR_engine.getSensitivityParameters()) {
+      parameters.append(QString::fromStdString(parameter.component + "." +
+                                               parameter.name));
+    }
+  }
+  datasets[dataset_name] =
+      sweepToDataset(sweep, parameters, SPAR_engine.getSweepSensitivities());
+
+  // The points the simulator could not solve are NaN, so they are drawn as
+  // gaps in the traces. A permanent label of the status bar says how many
+  // there are, so the other messages (e.g. the profiler) do not hide it
+  int unsolved = sweep.count(SolveStatus::Singular) +
+                 sweep.count(SolveStatus::Failed);
+  int illConditioned = sweep.count(SolveStatus::NearSingular);
+  if (unsolved > 0 || illConditioned > 0) {
+    simulationStatusLabel->setText(
+        tr("%1: %2 of %3 frequency points could not be solved, %4 are "
+           "ill-conditioned")
+            .arg(dataset_name)
+            .arg(unsolved)
+            .arg(sweep.size())
+            .arg(illConditioned));
+    simulationStatusLabel->show();
+  } else {
+    simulationStatusLabel->hide();
+  }
 
   // After simulation, once the data has been updated in the datasets structure,
   // it is needed to refresh the list of available traces. This is needed